@@ -1,3 +1,244 @@
-int main() {
-    return 0;
-}
\ No newline at end of file
+#include <context.h>
+#include <errno.h>
+#include <lexer.h>
+#include <private/pool.h>
+#include <private/thread.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <token_cache.h>
+
+// one input file, compiled in its own context so jobs share nothing but the read-only options
+struct job {
+    const char* path;
+    const char* token_cache; // directory given by --token-cache, or NULL
+    struct mcc_stats stats;  // counters of the job's context, read before it is destroyed
+    char* output;            // diagnostics, printed once every job is done so the order never depends on scheduling
+    size_t size;
+    size_t capacity;
+    bool failed;
+};
+
+static void job_printf(struct job* job, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int length = vsnprintf(NULL, 0, fmt, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+
+    const size_t needed = job->size + (size_t)length + 1;
+    if (needed > job->capacity) {
+        size_t capacity = job->capacity ? job->capacity : 256;
+        while (capacity < needed) {
+            capacity *= 2;
+        }
+        char* output = realloc(job->output, capacity);
+        if (!output) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        job->output   = output;
+        job->capacity = capacity;
+    }
+
+    va_start(args, fmt);
+    (void)vsnprintf(job->output + job->size, job->capacity - job->size, fmt, args);
+    va_end(args);
+    job->size += (size_t)length;
+}
+
+static void report(struct job* job, struct mcc_lexer* lexer, const struct mcc_token* token) {
+    const struct mcc_source_location location = mcc_lexer_location(lexer, token->offset);
+    job_printf(job,
+               "%s:%zu:%zu: error: %s\n",
+               job->path,
+               location.line + 1,
+               location.column + 1,
+               token->value.error_message);
+    job->failed = true;
+}
+
+static void compile(void* arg, size_t index) {
+    struct job* job         = (struct job*)arg + index;
+    struct mcc_context* ctx = mcc_context_create();
+
+    struct mcc_lexer lexer;
+    if (strcmp(job->path, "-") == 0) {
+        // piped input is lexed through a window instead of being buffered whole
+        mcc_lexer_create_stream(ctx, 0, 0, &lexer);
+        for (struct mcc_token token; (token = mcc_lexer_next_token(&lexer)).type != MCC_TOKEN_TYPE_EOF;) {
+            if (token.type == MCC_TOKEN_TYPE_INVALID) {
+                report(job, &lexer, &token);
+            }
+        }
+    } else {
+        size_t size;
+        char* source = mcc_context_map_file(ctx, job->path, &size);
+        if (!source) {
+            job_printf(job, "mcc: error: cannot read '%s': %s\n", job->path, strerror(errno));
+            job->failed = true;
+            mcc_context_destroy(ctx);
+            return;
+        }
+
+        mcc_lexer_create_borrowed(ctx, source, size, &lexer);
+        const struct mcc_token_array tokens = job->token_cache
+                                                  ? mcc_token_cache_tokenize(&lexer, job->token_cache, NULL)
+                                                  : mcc_lexer_tokenize_all(&lexer);
+        for (size_t i = 0; i < tokens.size; i++) {
+            if (tokens.data[i].type == MCC_TOKEN_TYPE_INVALID) {
+                report(job, &lexer, &tokens.data[i]);
+            }
+        }
+    }
+
+    mcc_lexer_destroy(&lexer);
+    (void)mcc_context_stats(ctx, &job->stats);
+    mcc_context_destroy(ctx);
+}
+
+static void print_stats(const struct mcc_stats* stats) {
+    static const char* const token_types[MCC_STATS_TOKEN_TYPES] = {
+        "invalid", "eof", "keyword", "identifier", "constant", "string literal", "punctuator",
+    };
+    static const char* const functions[MCC_STATS_FUNCTION_COUNT] = {
+        "scan_number", "parse_number", "parse_char", "scan_string", "scan_punctuator",
+    };
+
+    (void)fprintf(stderr, "%-16s %12s %14s\n", "token type", "tokens", "bytes");
+    for (size_t i = 0; i < MCC_STATS_TOKEN_TYPES; i++) {
+        (void)fprintf(stderr,
+                      "%-16s %12llu %14llu\n",
+                      token_types[i],
+                      (unsigned long long)stats->tokens[i],
+                      (unsigned long long)stats->bytes[i]);
+    }
+    (void)fprintf(stderr, "\n%-16s %12s %14s %12s\n", "function", "calls", "cycles", "cycles/call");
+    for (size_t i = 0; i < MCC_STATS_FUNCTION_COUNT; i++) {
+        const uint64_t calls = stats->calls[i];
+        (void)fprintf(stderr,
+                      "%-16s %12llu %14llu %12.1f\n",
+                      functions[i],
+                      (unsigned long long)calls,
+                      (unsigned long long)stats->cycles[i],
+                      calls ? (double)stats->cycles[i] / (double)calls : 0.0);
+    }
+    (void)fprintf(stderr,
+                  "\n%llu string literals stored, %llu bytes\n",
+                  (unsigned long long)stats->stored_literals,
+                  (unsigned long long)stats->stored_literal_bytes);
+}
+
+static void usage(FILE* stream) {
+    (void)fprintf(stream,
+                  "usage: mcc [-j N] [--token-cache DIR] [--stats] FILE...\n"
+                  "  FILE               a source file, or - to read standard input\n"
+                  "  -j N               compile up to N files at once, 0 or no -j uses one thread per processor\n"
+                  "  --token-cache DIR  reuse the tokens of files lexed before, cached in the existing DIR\n"
+                  "  --stats            print token counts and lexer timings, needs a build with MCC_STATS\n");
+}
+
+// accepts "-j N" and "-jN", returns false on a malformed count
+static bool parse_jobs(int argc, char** argv, int* i, size_t* threads) {
+    const char* value = argv[*i][2] ? argv[*i] + 2 : (*i + 1 < argc ? argv[++*i] : NULL);
+    if (!value || !*value) {
+        return false;
+    }
+    char* end;
+    const unsigned long count = strtoul(value, &end, 10);
+    if (*end || value[0] == '-') {
+        return false;
+    }
+    *threads = (size_t)count;
+    return true;
+}
+
+int main(int argc, char** argv) {
+    size_t threads          = 0;
+    const char* token_cache = NULL;
+    bool stats              = false;
+
+    struct job* jobs = calloc((size_t)argc, sizeof(struct job));
+    if (!jobs) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t count = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-h") == 0 || strcmp(argv[i], "--help") == 0) {
+            usage(stdout);
+            free(jobs);
+            return EXIT_SUCCESS;
+        }
+        if (strncmp(argv[i], "-j", 2) == 0) {
+            if (!parse_jobs(argc, argv, &i, &threads)) {
+                (void)fprintf(stderr, "mcc: error: -j expects a number of threads\n");
+                free(jobs);
+                return EXIT_FAILURE;
+            }
+            continue;
+        }
+        if (strcmp(argv[i], "--token-cache") == 0) {
+            if (i + 1 == argc) {
+                (void)fprintf(stderr, "mcc: error: --token-cache expects a directory\n");
+                free(jobs);
+                return EXIT_FAILURE;
+            }
+            token_cache = argv[++i];
+            continue;
+        }
+        if (strcmp(argv[i], "--stats") == 0) {
+#ifdef MCC_STATS
+            stats = true;
+#else
+            (void)fprintf(stderr, "mcc: warning: --stats needs mcc built with -DMCC_STATS=ON, nothing is counted\n");
+#endif
+            continue;
+        }
+        if (argv[i][0] == '-' && argv[i][1]) {
+            (void)fprintf(stderr, "mcc: error: unknown option '%s'\n", argv[i]);
+            usage(stderr);
+            free(jobs);
+            return EXIT_FAILURE;
+        }
+        jobs[count++].path = argv[i]; // "-" is standard input, not an option
+    }
+
+    if (count == 0) {
+        usage(stderr);
+        free(jobs);
+        return EXIT_FAILURE;
+    }
+    if (threads == 0) {
+        threads = thread_hardware_concurrency();
+    }
+    for (size_t i = 0; i < count; i++) {
+        jobs[i].token_cache = token_cache;
+    }
+
+    pool_run(count, threads, compile, jobs);
+
+    bool failed             = false;
+    struct mcc_stats totals = {0};
+    for (size_t i = 0; i < count; i++) {
+        if (jobs[i].size) {
+            (void)fwrite(jobs[i].output, 1, jobs[i].size, stderr);
+        }
+        failed |= jobs[i].failed;
+        free(jobs[i].output);
+        mcc_stats_add(&totals, &jobs[i].stats);
+    }
+    free(jobs);
+
+    if (stats) {
+        print_stats(&totals);
+    }
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+/// @file bench/bench.h
+/// @brief Shared helpers for the MCC microbenchmarks.
+
+#pragma once
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include <stdio.h>
+
+/// @brief Prevents the optimizer from discarding a computed value.
+static volatile unsigned long long bench_sink;
+
+/// @brief Reads a monotonic clock.
+/// @return The current time in seconds.
+static inline double bench_now(void) {
+#ifdef _WIN32
+    LARGE_INTEGER freq, now;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+#endif
+}
+
+/// @brief Prints a single benchmark result line.
+/// @param name Name of the measured variant.
+/// @param seconds Total elapsed time.
+/// @param ops Number of operations performed in that time.
+static inline void bench_report(const char* name, double seconds, double ops) {
+    printf("  %-32s %10.2f ns/op %12.2f Mop/s\n", name, seconds * 1e9 / ops, ops / seconds * 1e-6);
+}
@@ -0,0 +1,549 @@
+/// @file bench/dispatch_bench.c
+/// @brief Compares the table-driven token start dispatch and punctuator DFA against the character test chain and
+/// nested switch they replaced, on operator-dense code.
+
+#include <context.h>
+#include <ctype.h>
+#include <lexer.h>
+#include <private/charclass.h>
+#include <private/dispatch.h>
+#include <private/simd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define CORPUS_LINES 200000
+#define RUNS         5
+
+// =============================================================================
+// Corpus
+// =============================================================================
+
+static char* make_corpus(size_t* length) {
+    static const char* const lines[] = {
+        "a[i] += b->c * (d << 2) - e++ % f;\n",
+        "x = y ? z : w && !v || u >= t;\n",
+        "p->q.r <<= s >> 3 ^ ~m | n & 0x1f;\n",
+        "if (a != b && c <= d) { e -= f--; g /= h; }\n",
+        "k = (l + m) * n / o - p % q, c = 'a' + s[j];\n",
+        "%:define CAT(a, b) a %:%: b <: :> <% %>\n",
+    };
+    const size_t line_count = sizeof(lines) / sizeof(*lines);
+
+    const size_t capacity = (size_t)CORPUS_LINES * 64;
+    char* corpus          = malloc(capacity);
+    if (!corpus) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < CORPUS_LINES; i++) {
+        const char* line = lines[(size_t)i % line_count];
+        memcpy(corpus + len, line, strlen(line));
+        len += strlen(line);
+    }
+    corpus[len] = '\0';
+    *length     = len;
+    return corpus;
+}
+
+// =============================================================================
+// Reference
+// =============================================================================
+
+// the nested switch scan_punctuator() used before the tables, reading from a bare cursor
+
+struct cursor {
+    const char* current;
+};
+
+static char curr(struct cursor* lexer) {
+    return *lexer->current;
+}
+
+static char next(struct cursor* lexer) {
+    return *(++lexer->current);
+}
+
+static char peek(struct cursor* lexer) {
+    return lexer->current[1];
+}
+
+static size_t switch_punctuator(const char* str, enum mcc_punctuator* out) {
+    struct cursor cursor = {str};
+    struct cursor* lexer = &cursor;
+
+    enum mcc_punctuator punctuator;
+
+    switch (curr(lexer)) {
+        case '!':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_BANG_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_BANG;
+                    break;
+            }
+            break;
+        case '#':
+            switch (next(lexer)) {
+                case '#':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_HASH_HASH;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_HASH;
+                    break;
+            }
+            break;
+        case '%':
+            switch (next(lexer)) {
+                case ':':
+                    switch (next(lexer)) {
+                        case '%':
+                            switch (peek(lexer)) {
+                                case ':':
+                                    next(lexer);
+                                    next(lexer);
+                                    punctuator = MCC_PUNCTUATOR_HASH_HASH;
+                                    break;
+                                default:
+                                    punctuator = MCC_PUNCTUATOR_HASH;
+                                    break;
+                            }
+                            break;
+                        default:
+                            punctuator = MCC_PUNCTUATOR_HASH;
+                            break;
+                    }
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_PERCENT_EQUAL;
+                    break;
+                case '>':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_RIGHT_BRACE;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_PERCENT;
+                    break;
+            }
+            break;
+        case '&':
+            switch (next(lexer)) {
+                case '&':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_AMPERSAND_AMPERSAND;
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_AMPERSAND_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_AMPERSAND;
+                    break;
+            }
+            break;
+        case '(':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_LEFT_PARENTHESIS;
+            break;
+        case ')':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_RIGHT_PARENTHESIS;
+            break;
+        case '*':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_ASTERISK_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_ASTERISK;
+                    break;
+            }
+            break;
+        case '+':
+            switch (next(lexer)) {
+                case '+':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_PLUS_PLUS;
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_PLUS_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_PLUS;
+                    break;
+            }
+            break;
+        case ',':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_COMMA;
+            break;
+        case '-':
+            switch (next(lexer)) {
+                case '-':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_MINUS_MINUS;
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_MINUS_EQUAL;
+                    break;
+                case '>':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_ARROW;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_MINUS;
+                    break;
+            }
+            break;
+        case '.':
+            switch (next(lexer)) {
+                case '.':
+                    switch (peek(lexer)) {
+                        case '.':
+                            next(lexer);
+                            next(lexer);
+                            punctuator = MCC_PUNCTUATOR_ELLIPSIS;
+                            break;
+                        default:
+                            punctuator = MCC_PUNCTUATOR_DOT;
+                            break;
+                    }
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_DOT;
+                    break;
+            }
+            break;
+        case '/':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_SLASH_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_SLASH;
+                    break;
+            }
+            break;
+        case ':':
+            switch (next(lexer)) {
+                case '>':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_RIGHT_BRACKET;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_COLON;
+                    break;
+            }
+            break;
+        case ';':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_SEMICOLON;
+            break;
+        case '<':
+            switch (next(lexer)) {
+                case '%':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_LEFT_BRACE;
+                    break;
+                case ':':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_LEFT_BRACKET;
+                    break;
+                case '<':
+                    switch (next(lexer)) {
+                        case '=':
+                            next(lexer);
+                            punctuator = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON_EQUAL;
+                            break;
+                        default:
+                            punctuator = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON;
+                            break;
+                    }
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_LEFT_CHEVRON_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_LEFT_CHEVRON;
+                    break;
+            }
+            break;
+        case '=':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_EQUAL_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_EQUAL;
+                    break;
+            }
+            break;
+        case '>':
+            switch (next(lexer)) {
+                case '>':
+                    switch (next(lexer)) {
+                        case '=':
+                            next(lexer);
+                            punctuator = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON_EQUAL;
+                            break;
+                        default:
+                            punctuator = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON;
+                            break;
+                    }
+                    break;
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_RIGHT_CHEVRON_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_RIGHT_CHEVRON;
+                    break;
+            }
+            break;
+        case '?':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_QUESTION_MARK;
+            break;
+        case '[':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_LEFT_BRACKET;
+            break;
+        case ']':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_RIGHT_BRACKET;
+            break;
+        case '^':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_CARET_EQUAL;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_CARET;
+                    break;
+            }
+            break;
+        case '{':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_LEFT_BRACE;
+            break;
+        case '|':
+            switch (next(lexer)) {
+                case '=':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_PIPE_EQUAL;
+                    break;
+                case '|':
+                    next(lexer);
+                    punctuator = MCC_PUNCTUATOR_PIPE_PIPE;
+                    break;
+                default:
+                    punctuator = MCC_PUNCTUATOR_PIPE;
+                    break;
+            }
+            break;
+        case '}':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_RIGHT_BRACE;
+            break;
+        case '~':
+            next(lexer);
+            punctuator = MCC_PUNCTUATOR_TILDE;
+            break;
+        default:
+            *out = MCC_PUNCTUATOR_INVALID;
+            return 0;
+    }
+
+    *out = punctuator;
+    return (size_t)(lexer->current - str);
+}
+
+
+// =============================================================================
+// Variants
+// =============================================================================
+
+// Both walkers only classify tokens, identifiers and numbers are spanned and quoted literals skipped without being
+// decoded, so the difference between them is the dispatch and the punctuator scan alone.
+
+static const char* skip_quoted(const char* p) {
+    const char quote = *p++;
+    while (*p != quote && *p != '\0') {
+        p += (*p == '\\' && p[1] != '\0') ? 2 : 1;
+    }
+    return *p ? p + 1 : p;
+}
+
+static size_t walk_switch(const char* source, const char* end, unsigned long long* checksum) {
+    size_t tokens = 0;
+    for (const char* p = source;; tokens++) {
+        p += span_whitespace(p, end);
+        const char c = *p;
+
+        if (c == '\0') {
+            return tokens;
+        }
+        if (isdigit(c) || (c == '.' && isdigit(p[1]))) {
+            p += span_ident(p, end);
+        } else if (c == '\'' || (c == 'L' && p[1] == '\'')) {
+            p = skip_quoted(p + (c == 'L'));
+        } else if (c == '\"' || (c == 'L' && p[1] == '\"')) {
+            p = skip_quoted(p + (c == 'L'));
+        } else if (isalpha(c) || c == '_') {
+            p += span_ident(p, end);
+        } else {
+            enum mcc_punctuator punctuator;
+            const size_t len = switch_punctuator(p, &punctuator);
+            *checksum += (unsigned long long)punctuator;
+            p += len ? len : 1;
+        }
+    }
+}
+
+static size_t walk_table(const char* source, const char* end, unsigned long long* checksum) {
+    size_t tokens = 0;
+    for (const char* p = source;; tokens++) {
+        p += span_whitespace(p, end);
+
+        switch ((enum token_start)token_start_table[(unsigned char)*p]) {
+            case TOKEN_START_END:
+                return tokens;
+            case TOKEN_START_WIDE:
+                if (p[1] == '\'' || p[1] == '\"') {
+                    p = skip_quoted(p + 1);
+                    break;
+                }
+                p += span_ident(p, end);
+                break;
+            case TOKEN_START_DIGIT:
+            case TOKEN_START_IDENT:
+                p += span_ident(p, end);
+                break;
+            case TOKEN_START_CHAR:
+            case TOKEN_START_STRING:
+                p = skip_quoted(p);
+                break;
+            case TOKEN_START_DOT:
+                if (is_digit(p[1])) {
+                    p += span_ident(p, end);
+                    break;
+                }
+                // fall through
+            case TOKEN_START_OTHER:
+            default: {
+                enum mcc_punctuator punctuator;
+                const size_t len = punctuator_match(p, &punctuator);
+                *checksum += (unsigned long long)punctuator;
+                p += len ? len : 1;
+                break;
+            }
+        }
+    }
+}
+
+static void run_walk(const char* name,
+                     size_t (*walk)(const char*, const char*, unsigned long long*),
+                     const char* corpus,
+                     size_t length) {
+    double best   = 1e30;
+    size_t tokens = 0;
+    for (int r = 0; r < RUNS; r++) {
+        unsigned long long checksum = 0;
+        const double start          = bench_now();
+        tokens                      = walk(corpus, corpus + length, &checksum);
+        const double elapsed        = bench_now() - start;
+        bench_sink                  = checksum;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    bench_report(name, best, (double)tokens);
+}
+
+static void run_lexer(const char* corpus, size_t length) {
+    double best   = 1e30;
+    size_t tokens = 0;
+    for (int r = 0; r < RUNS; r++) {
+        struct mcc_context* ctx = mcc_context_create();
+        struct mcc_lexer lexer;
+        mcc_lexer_create(ctx, corpus, length, &lexer);
+
+        const double start   = bench_now();
+        tokens               = mcc_lexer_tokenize_all(&lexer).size;
+        const double elapsed = bench_now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+
+        mcc_lexer_destroy(&lexer);
+        mcc_context_destroy(ctx);
+    }
+    bench_report("mcc_lexer_tokenize_all", best, (double)tokens);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+// every string of up to four punctuator characters (plus one that is not) must scan the same either way
+static int check_punctuators(void) {
+    static const char alphabet[] = "!#%&()*+,-./:;<=>?[]^{|}~x";
+    const size_t n               = sizeof(alphabet) - 1;
+
+    char buffer[5] = {0};
+    for (size_t i = 0; i < n * n * n * n; i++) {
+        for (size_t k = 0, rest = i; k < 4; k++, rest /= n) {
+            buffer[k] = alphabet[rest % n];
+        }
+        enum mcc_punctuator expected, actual;
+        const size_t expected_len = switch_punctuator(buffer, &expected);
+        const size_t actual_len   = punctuator_match(buffer, &actual);
+        if (expected_len != actual_len || (expected_len && expected != actual)) {
+            fprintf(stderr, "mismatch on '%s'\n", buffer);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int main(void) {
+    if (!check_punctuators()) {
+        return EXIT_FAILURE;
+    }
+
+    size_t length;
+    char* corpus = make_corpus(&length);
+
+    unsigned long long switch_checksum = 0, table_checksum = 0;
+    const size_t switch_tokens         = walk_switch(corpus, corpus + length, &switch_checksum);
+    const size_t table_tokens          = walk_table(corpus, corpus + length, &table_checksum);
+    if (switch_tokens != table_tokens || switch_checksum != table_checksum) {
+        fprintf(stderr, "token walks disagree\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("\n=== Classify %.1f MB of operator-dense code ===\n", (double)length * 1e-6);
+    run_walk("if-chain + nested switch", walk_switch, corpus, length);
+    run_walk("start table + punctuator DFA", walk_table, corpus, length);
+
+    printf("\n=== Tokenize the same code ===\n");
+    run_lexer(corpus, length);
+
+    free(corpus);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,148 @@
+/// @file bench/float_bench.c
+/// @brief Compares the in-tree floating constant parser against strtof()/strtod()/strtold().
+
+#include <private/float_parse.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define LITERALS 200000
+#define RUNS     5
+
+// =============================================================================
+// Corpus
+// =============================================================================
+
+// a mix shaped like generated numeric tables, mostly short decimals with some full precision and hex values
+static char** make_literals(void) {
+    char** literals = malloc(sizeof(*literals) * LITERALS);
+    if (!literals) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    unsigned long long state = 0x9E3779B97F4A7C15;
+    for (int i = 0; i < LITERALS; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+
+        char buffer[64];
+        switch (i % 4) {
+            case 0:
+                sprintf(buffer, "%.3f", (double)(state % 1000000) / 7.0);
+                break;
+            case 1:
+                sprintf(buffer, "%.17g", (double)(state >> 11) * 0x1p-53);
+                break;
+            case 2:
+                sprintf(buffer, "%.6e", (double)(state % 100000) * 1e-3);
+                break;
+            default:
+                sprintf(buffer, "%a", (double)(state >> 11) * 0x1p-40);
+                break;
+        }
+
+        literals[i] = malloc(strlen(buffer) + 1);
+        if (!literals[i]) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        strcpy(literals[i], buffer);
+    }
+    return literals;
+}
+
+// =============================================================================
+// Variants
+// =============================================================================
+
+static double run_libc(char** literals, int type) {
+    double best = 1e30;
+    for (int r = 0; r < RUNS; r++) {
+        double sum         = 0.0;
+        const double start = bench_now();
+        for (int i = 0; i < LITERALS; i++) {
+            sum += type == 0 ? strtof(literals[i], NULL)
+                 : type == 1 ? strtod(literals[i], NULL)
+                             : (double)strtold(literals[i], NULL);
+        }
+        const double elapsed = bench_now() - start;
+        bench_sink           = (unsigned long long)sum;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+static double run_mcc(char** literals, const size_t* lengths, int type) {
+    double best = 1e30;
+    for (int r = 0; r < RUNS; r++) {
+        double sum         = 0.0;
+        const double start = bench_now();
+        for (int i = 0; i < LITERALS; i++) {
+            const char* end = literals[i] + lengths[i];
+            if (type == 0) {
+                float f;
+                parse_float(literals[i], end, &f);
+                sum += f;
+            } else if (type == 1) {
+                double d;
+                parse_double(literals[i], end, &d);
+                sum += d;
+            } else {
+                long double ld;
+                parse_long_double(literals[i], end, &ld);
+                sum += (double)ld;
+            }
+        }
+        const double elapsed = bench_now() - start;
+        bench_sink           = (unsigned long long)sum;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    char** literals = make_literals();
+    size_t* lengths = malloc(sizeof(*lengths) * LITERALS);
+    if (!lengths) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < LITERALS; i++) {
+        lengths[i] = strlen(literals[i]);
+    }
+
+    // sanity check both implementations agree before timing them
+    for (int i = 0; i < LITERALS; i++) {
+        double d;
+        parse_double(literals[i], literals[i] + lengths[i], &d);
+        if (d != strtod(literals[i], NULL)) {
+            fprintf(stderr, "mismatch on '%s'\n", literals[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    static const char* const names[] = {"float", "double", "long double"};
+    for (int type = 0; type < 3; type++) {
+        printf("\n=== Parse %d %s literals ===\n", LITERALS, names[type]);
+        bench_report("libc strto*", run_libc(literals, type), LITERALS);
+        bench_report("float_parse", run_mcc(literals, lengths, type), LITERALS);
+    }
+
+    for (int i = 0; i < LITERALS; i++) {
+        free(literals[i]);
+    }
+    free(literals);
+    free(lengths);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+/// @file bench/keyword_bench.c
+/// @brief Compares the perfect hash keyword lookup against the original linear table scan.
+
+#include <lexer.h>
+#include <private/keywords.h>
+#include <private/utils.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define ITERATIONS 200000
+
+// =============================================================================
+// Reference Implementation
+// =============================================================================
+
+struct table_entry {
+    const char* key;
+    int value;
+};
+
+// the keyword table as it was before the perfect hash
+static const struct table_entry linear_keyword_table[] = {
+    {"auto",       MCC_KEYWORD_AUTO     },
+    {"break",      MCC_KEYWORD_BREAK    },
+    {"case",       MCC_KEYWORD_CASE     },
+    {"char",       MCC_KEYWORD_CHAR     },
+    {"const",      MCC_KEYWORD_CONST    },
+    {"continue",   MCC_KEYWORD_CONTINUE },
+    {"default",    MCC_KEYWORD_DEFAULT  },
+    {"do",         MCC_KEYWORD_DO       },
+    {"double",     MCC_KEYWORD_DOUBLE   },
+    {"else",       MCC_KEYWORD_ELSE     },
+    {"enum",       MCC_KEYWORD_ENUM     },
+    {"extern",     MCC_KEYWORD_EXTERN   },
+    {"float",      MCC_KEYWORD_FLOAT    },
+    {"for",        MCC_KEYWORD_FOR      },
+    {"goto",       MCC_KEYWORD_GOTO     },
+    {"if",         MCC_KEYWORD_IF       },
+    {"inline",     MCC_KEYWORD_INLINE   },
+    {"int",        MCC_KEYWORD_INT      },
+    {"long",       MCC_KEYWORD_LONG     },
+    {"register",   MCC_KEYWORD_REGISTER },
+    {"restrict",   MCC_KEYWORD_RESTRICT },
+    {"return",     MCC_KEYWORD_RETURN   },
+    {"short",      MCC_KEYWORD_SHORT    },
+    {"signed",     MCC_KEYWORD_SIGNED   },
+    {"sizeof",     MCC_KEYWORD_SIZEOF   },
+    {"static",     MCC_KEYWORD_STATIC   },
+    {"struct",     MCC_KEYWORD_STRUCT   },
+    {"switch",     MCC_KEYWORD_SWITCH   },
+    {"typedef",    MCC_KEYWORD_TYPEDEF  },
+    {"union",      MCC_KEYWORD_UNION    },
+    {"unsigned",   MCC_KEYWORD_UNSIGNED },
+    {"void",       MCC_KEYWORD_VOID     },
+    {"volatile",   MCC_KEYWORD_VOLATILE },
+    {"while",      MCC_KEYWORD_WHILE    },
+    {"_Bool",      MCC_KEYWORD_BOOL     },
+    {"_Complex",   MCC_KEYWORD_COMPLEX  },
+    {"_Imaginary", MCC_KEYWORD_IMAGINARY},
+    {NULL,         MCC_KEYWORD_NOT_FOUND},
+};
+
+static int linear_keyword_lookup(const char* str, size_t len) {
+    const struct table_entry* table = linear_keyword_table;
+    for (; table->key != NULL; table++) {
+        if ((strncmp(table->key, str, len) == 0) && (strlen(table->key) == len)) {
+            break;
+        }
+    }
+    return table->value;
+}
+
+// =============================================================================
+// Corpus
+// =============================================================================
+
+// identifier-heavy mix, roughly one keyword for every three identifiers
+static const char* const words[] = {
+    "int",      "count",       "i",       "return", "buffer",   "size",     "const",   "char",
+    "ptr",      "node",        "next",    "if",     "value",    "result",   "struct",  "list_head",
+    "len",      "for",         "idx",     "unsigned", "flags",  "mcc_lexer", "while", "data",
+    "err",      "static",      "x",       "y",      "width",    "height",   "void",    "ctx",
+    "tmp",      "else",        "index",   "offset", "uint32_t", "memcpy",   "sizeof",  "begin",
+    "end",      "break",       "table",   "entry",  "key",      "hash",     "_private", "do_work",
+};
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    size_t lens[ARRAY_SIZE(words)];
+    for (size_t i = 0; i < ARRAY_SIZE(words); i++) {
+        lens[i] = strlen(words[i]);
+    }
+
+    // sanity check both implementations agree before timing them
+    for (size_t i = 0; i < ARRAY_SIZE(words); i++) {
+        if (linear_keyword_lookup(words[i], lens[i]) != (int)keyword_lookup(words[i], lens[i])) {
+            fprintf(stderr, "mismatch on '%s'\n", words[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    const double ops = (double)ITERATIONS * (double)ARRAY_SIZE(words);
+
+    printf("\n=== Keyword lookup (identifier-heavy) ===\n");
+
+    unsigned long long sum = 0;
+    double start           = bench_now();
+    for (int n = 0; n < ITERATIONS; n++) {
+        for (size_t i = 0; i < ARRAY_SIZE(words); i++) {
+            sum += (unsigned long long)linear_keyword_lookup(words[i], lens[i]);
+        }
+    }
+    const double linear = bench_now() - start;
+    bench_sink          = sum;
+    bench_report("linear table", linear, ops);
+
+    sum   = 0;
+    start = bench_now();
+    for (int n = 0; n < ITERATIONS; n++) {
+        for (size_t i = 0; i < ARRAY_SIZE(words); i++) {
+            sum += (unsigned long long)keyword_lookup(words[i], lens[i]);
+        }
+    }
+    const double perfect = bench_now() - start;
+    bench_sink           = sum;
+    bench_report("perfect hash", perfect, ops);
+
+    printf("  speedup: %.2fx\n", linear / perfect);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,407 @@
+/// @file bench/mcc_bench.c
+/// @brief Lexer throughput suite over synthetic corpora, with an optional check against a recorded baseline.
+///
+/// Usage: mcc_bench [--baseline FILE [--threshold PERCENT]] [--write-baseline FILE]
+///
+/// The corpus results measure whole-file throughput on five kinds of code. The scanner results lex corpora made of
+/// a single token kind separated by spaces, so each one isolates the cost of one scanner plus the shared dispatch. With
+/// --baseline every result is compared against the recorded ns/token and the run fails if any is more than PERCENT
+/// slower (15 by default).
+
+#include <context.h>
+#include <lexer.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define CORPUS_SIZE       (4u << 20) ///< Bytes of source generated per corpus.
+#define RUNS              10
+#define DEFAULT_THRESHOLD 15.0
+#define MAX_NAME          64
+
+// =============================================================================
+// Corpus Generation
+// =============================================================================
+
+struct text {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+static void text_append(struct text* text, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    char piece[256];
+    const int len = vsnprintf(piece, sizeof(piece), fmt, args);
+    va_end(args);
+
+    if (len < 0 || (size_t)len >= sizeof(piece)) {
+        fprintf(stderr, "corpus piece too long\n");
+        exit(EXIT_FAILURE);
+    }
+    if (text->size + (size_t)len + 1 > text->capacity) {
+        text->capacity = text->capacity ? text->capacity * 2 : CORPUS_SIZE + 1024;
+        text->data     = realloc(text->data, text->capacity);
+        if (!text->data) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memcpy(text->data + text->size, piece, (size_t)len + 1);
+    text->size += (size_t)len;
+}
+
+static unsigned long long next_random(unsigned long long* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+typedef void (*generate_fn)(struct text* out, unsigned long long r);
+
+static void generate_identifiers(struct text* out, unsigned long long r) {
+    static const char* const types[] = {"int", "unsigned long", "const char*", "struct node*", "double", "size_t"};
+    const unsigned n                 = (unsigned)(r >> 8) % 5000;
+    text_append(out,
+                "static %s lookup_%u(%s element_%u, %s* context_%u) { return element_%u; }\n",
+                types[r % 6],
+                n,
+                types[(r >> 3) % 6],
+                n,
+                types[(r >> 5) % 6],
+                n % 97,
+                n);
+}
+
+static void generate_numbers(struct text* out, unsigned long long r) {
+    const unsigned n = (unsigned)(r >> 16);
+    text_append(out,
+                "{%u, 0x%XU, 0%o, %lluULL, %u.%03uf, %.9e, 0x%X.%Xp-%u, %uL},\n",
+                n % 100000,
+                n,
+                n % 4096,
+                r >> 4,
+                n % 1000,
+                n % 997,
+                (double)(r >> 11) * 0x1p-40,
+                n % 256,
+                n % 16,
+                n % 60);
+}
+
+static void generate_strings(struct text* out, unsigned long long r) {
+    const unsigned n = (unsigned)(r >> 16) % 10000;
+    text_append(out,
+                "\"message %u:\\t%%s\\n\", L\"wide \\x41\\x%02X text\", \"quote \\\"%u\\\" and \\\\ path\", '\\n', "
+                "'%c', L'\\x%02X',\n",
+                n,
+                (unsigned)(r % 0x60) + 0x20,
+                n,
+                'a' + (char)(r % 26),
+                (unsigned)(r >> 7) % 0x7F);
+}
+
+static void generate_operators(struct text* out, unsigned long long r) {
+    static const char* const lines[] = {
+        "a[i] += b->c * (d << 2) - e++ % f;\n",
+        "x = y ? z : w && !v || u >= t;\n",
+        "p->q.r <<= s >> 3 ^ ~m | n & k;\n",
+        "if (a != b && c <= d) { e -= f--; g /= h; }\n",
+        "k = (l + m) * n / o - p % q, r |= s ^= t;\n",
+    };
+    text_append(out, "%s", lines[r % 5]);
+}
+
+// a vendor header, mostly license and doc comments around a few declarations
+static void generate_comments(struct text* out, unsigned long long r) {
+    const unsigned n = (unsigned)(r >> 16) % 10000;
+    switch (r % 4) {
+        case 0:
+            text_append(out,
+                        "/**\n * @brief Returns the value of register %u, see the reference manual section %u.\n"
+                        " * @param handle Device handle, must not be NULL.\n * @return The register value.\n */\n",
+                        n,
+                        n % 97);
+            break;
+        case 1:
+            text_append(out, "// Copyright (c) vendor %u. Licensed under the terms in LICENSE, all rights reserved.\n",
+                        n);
+            break;
+        case 2:
+            text_append(out,
+                        "#define REG_%u_MASK (0x%XU << %u) /* bits %u to %u of the status register */\n",
+                        n,
+                        (unsigned)(r >> 8) & 0xFF,
+                        n % 24,
+                        n % 24,
+                        n % 24 + 7);
+            break;
+        default:
+            text_append(out, "unsigned long reg_read_%u(struct device* handle); // may block\n", n);
+            break;
+    }
+}
+
+// the scanner corpora hold one kind of token each, spaces keep neighbouring punctuators from merging
+
+static void generate_scan_number(struct text* out, unsigned long long r) {
+    switch (r % 4) {
+        case 0:
+            text_append(out, "%u ", (unsigned)(r >> 8) % 100000);
+            break;
+        case 1:
+            text_append(out, "0x%XU ", (unsigned)(r >> 8));
+            break;
+        case 2:
+            text_append(out, "%u.%03u ", (unsigned)(r >> 8) % 1000, (unsigned)(r >> 20) % 1000);
+            break;
+        default:
+            text_append(out, "%.6ef ", (double)(r >> 11) * 0x1p-50);
+            break;
+    }
+}
+
+static void generate_scan_string(struct text* out, unsigned long long r) {
+    if (r % 3 == 0) {
+        text_append(out, "\"line %u\\n\" ", (unsigned)(r >> 8) % 1000);
+    } else {
+        text_append(out, "\"a plain string literal of some length %u\" ", (unsigned)(r >> 8) % 1000);
+    }
+}
+
+static void generate_scan_char(struct text* out, unsigned long long r) {
+    switch (r % 3) {
+        case 0:
+            text_append(out, "'%c' ", 'a' + (char)((r >> 8) % 26));
+            break;
+        case 1:
+            text_append(out, "'\\%c' ", "ntr0\\'"[(r >> 8) % 6]);
+            break;
+        default:
+            text_append(out, "L'\\x%02X' ", (unsigned)(r >> 8) % 0x80);
+            break;
+    }
+}
+
+static void generate_scan_punctuator(struct text* out, unsigned long long r) {
+    static const char* const punctuators[] = {
+        "(",  ")",  "{",  "}",  "[",  "]",  ";",  ",",   "->",  "++", "--", "+", "-", "*",  "/",  "%",
+        "=",  "==", "!=", "<",  ">",  "<=", ">=", "<<=", ">>=", "&&", "||", "&", "|", "^=", "...", "#",
+    };
+    text_append(out, "%s ", punctuators[r % 32]);
+}
+
+static void generate_scan_keyword_or_identifier(struct text* out, unsigned long long r) {
+    static const char* const keywords[] = {"int", "return", "static", "const", "unsigned", "struct", "if", "while"};
+    if (r % 3 == 0) {
+        text_append(out, "%s ", keywords[(r >> 8) % 8]);
+    } else {
+        text_append(out, "name_%u ", (unsigned)(r >> 8) % 20000);
+    }
+}
+
+struct corpus {
+    const char* name;
+    generate_fn generate;
+    char* data;
+    size_t length;
+};
+
+static struct corpus corpora[] = {
+    {"corpus/identifiers",                 generate_identifiers,                NULL, 0},
+    {"corpus/numbers",                     generate_numbers,                    NULL, 0},
+    {"corpus/strings",                     generate_strings,                    NULL, 0},
+    {"corpus/operators",                   generate_operators,                  NULL, 0},
+    {"corpus/comments",                    generate_comments,                   NULL, 0},
+    {"scanner/scan_number",                generate_scan_number,                NULL, 0},
+    {"scanner/scan_string",                generate_scan_string,                NULL, 0},
+    {"scanner/scan_char",                  generate_scan_char,                  NULL, 0},
+    {"scanner/scan_punctuator",            generate_scan_punctuator,            NULL, 0},
+    {"scanner/scan_keyword_or_identifier", generate_scan_keyword_or_identifier, NULL, 0},
+};
+
+#define CORPUS_COUNT (sizeof(corpora) / sizeof(*corpora))
+
+static void generate_corpus(struct corpus* corpus) {
+    struct text text         = {0};
+    unsigned long long state = 0x9E3779B97F4A7C15;
+    while (text.size < CORPUS_SIZE) {
+        corpus->generate(&text, next_random(&state));
+    }
+    corpus->data   = text.data;
+    corpus->length = text.size;
+}
+
+// =============================================================================
+// Measurement
+// =============================================================================
+
+struct result {
+    double seconds;
+    size_t tokens;
+};
+
+static struct result measure(const struct corpus* corpus) {
+    struct result result = {1e30, 0};
+    for (int r = 0; r < RUNS; r++) {
+        struct mcc_context* ctx = mcc_context_create();
+        struct mcc_lexer lexer;
+        mcc_lexer_create(ctx, corpus->data, corpus->length, &lexer);
+
+        size_t tokens      = 0;
+        size_t invalid     = 0;
+        const double start = bench_now();
+        for (;;) {
+            const struct mcc_token token = mcc_lexer_next_token(&lexer);
+            if (token.type == MCC_TOKEN_TYPE_EOF) {
+                break;
+            }
+            invalid += token.type == MCC_TOKEN_TYPE_INVALID;
+            tokens++;
+        }
+        const double elapsed = bench_now() - start;
+
+        mcc_lexer_destroy(&lexer);
+        mcc_context_destroy(ctx);
+
+        // a corpus that does not lex cleanly would time the error paths instead of the scanners
+        if (invalid) {
+            fprintf(stderr, "%s: %zu invalid tokens\n", corpus->name, invalid);
+            exit(EXIT_FAILURE);
+        }
+        if (elapsed < result.seconds) {
+            result.seconds = elapsed;
+        }
+        result.tokens = tokens;
+    }
+    return result;
+}
+
+static double ns_per_token(struct result result) {
+    return result.seconds * 1e9 / (double)result.tokens;
+}
+
+// =============================================================================
+// Baseline
+// =============================================================================
+
+struct baseline_entry {
+    char name[MAX_NAME];
+    double ns_per_token;
+};
+
+// one "name ns_per_token" pair per line, '#' starts a comment line
+static size_t read_baseline(const char* path, struct baseline_entry* entries, size_t capacity) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t count = 0;
+    char line[256];
+    while (count < capacity && fgets(line, sizeof(line), file)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "%63s %lf", entries[count].name, &entries[count].ns_per_token) == 2) {
+            count++;
+        }
+    }
+    fclose(file);
+    return count;
+}
+
+static const struct baseline_entry* find_baseline(const struct baseline_entry* entries,
+                                                  size_t count,
+                                                  const char* name) {
+    for (size_t i = 0; i < count; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+static void write_baseline(const char* path, const struct result* results) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    fprintf(file, "# mcc_bench baseline in ns per token, numbers are machine specific\n");
+    fprintf(file, "# regenerate from a Release build with: mcc_bench --write-baseline FILE\n");
+    for (size_t i = 0; i < CORPUS_COUNT; i++) {
+        fprintf(file, "%s %.2f\n", corpora[i].name, ns_per_token(results[i]));
+    }
+    fclose(file);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(int argc, char** argv) {
+    const char* baseline_path = NULL;
+    const char* output_path   = NULL;
+    double threshold          = DEFAULT_THRESHOLD;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--write-baseline") == 0 && i + 1 < argc) {
+            output_path = argv[++i];
+        } else {
+            fprintf(stderr, "usage: %s [--baseline FILE [--threshold PERCENT]] [--write-baseline FILE]\n", argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    struct baseline_entry baseline[CORPUS_COUNT];
+    const size_t baseline_count = baseline_path ? read_baseline(baseline_path, baseline, CORPUS_COUNT) : 0;
+
+    struct result results[CORPUS_COUNT];
+    bool regressed = false;
+
+    printf("\n  %-36s %10s %12s %10s %10s\n", "", "MB/s", "Mtok/s", "ns/tok", "baseline");
+    for (size_t i = 0; i < CORPUS_COUNT; i++) {
+        generate_corpus(&corpora[i]);
+        results[i] = measure(&corpora[i]);
+
+        const double ns = ns_per_token(results[i]);
+        printf("  %-36s %10.1f %12.2f %10.2f",
+               corpora[i].name,
+               (double)corpora[i].length / results[i].seconds * 1e-6,
+               (double)results[i].tokens / results[i].seconds * 1e-6,
+               ns);
+
+        const struct baseline_entry* entry = find_baseline(baseline, baseline_count, corpora[i].name);
+        if (entry) {
+            const double change = (ns / entry->ns_per_token - 1.0) * 100.0;
+            printf(" %9.2f %+6.1f%%", entry->ns_per_token, change);
+            if (change > threshold) {
+                printf("  REGRESSION");
+                regressed = true;
+            }
+        }
+        printf("\n");
+
+        free(corpora[i].data);
+    }
+
+    if (output_path) {
+        write_baseline(output_path, results);
+    }
+    if (regressed) {
+        fprintf(stderr, "\nat least one result is more than %.1f%% slower than the baseline\n", threshold);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/// @file bench/tokenize_bench.c
+/// @brief Compares per-call mcc_lexer_next_token() throughput against bulk mcc_lexer_tokenize_all().
+
+#include <context.h>
+#include <lexer.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define CORPUS_FUNCTIONS 100000
+#define RUNS             5
+
+// =============================================================================
+// Corpus
+// =============================================================================
+
+static char* make_corpus(size_t* length) {
+    const size_t capacity = (size_t)CORPUS_FUNCTIONS * 160;
+    char* corpus          = malloc(capacity);
+    if (!corpus) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t len = 0;
+    for (int i = 0; i < CORPUS_FUNCTIONS; i++) {
+        len += (size_t)sprintf(corpus + len,
+                               "static int function_%d(const char* buffer, unsigned long size) {\n"
+                               "    return buffer[size - 1] + %d * 0x%x;\n"
+                               "}\n",
+                               i,
+                               i,
+                               (unsigned)i);
+    }
+    *length = len;
+    return corpus;
+}
+
+// =============================================================================
+// Variants
+// =============================================================================
+
+// what a consumer has to do today, one call per token and its own growable array
+static size_t tokenize_per_call(struct mcc_lexer* lexer) {
+    size_t capacity         = 1024;
+    size_t size             = 0;
+    struct mcc_token* array = malloc(sizeof(*array) * capacity);
+    for (;;) {
+        if (size == capacity) {
+            array = realloc(array, sizeof(*array) * (capacity *= 2));
+        }
+        if (!array) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        array[size] = mcc_lexer_next_token(lexer);
+        if (array[size++].type == MCC_TOKEN_TYPE_EOF) {
+            break;
+        }
+    }
+    free(array);
+    return size;
+}
+
+static size_t tokenize_bulk(struct mcc_lexer* lexer) {
+    return mcc_lexer_tokenize_all(lexer).size;
+}
+
+static void run(const char* name, size_t (*tokenize)(struct mcc_lexer*), const char* corpus, size_t length) {
+    double best   = 1e30;
+    size_t tokens = 0;
+    for (int r = 0; r < RUNS; r++) {
+        struct mcc_context* ctx = mcc_context_create();
+        struct mcc_lexer lexer;
+        mcc_lexer_create(ctx, corpus, length, &lexer);
+
+        const double start   = bench_now();
+        tokens               = tokenize(&lexer);
+        const double elapsed = bench_now() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+
+        mcc_lexer_destroy(&lexer);
+        mcc_context_destroy(ctx);
+    }
+    bench_report(name, best, (double)tokens);
+    printf("  %-32s %10.2f MB/s\n", "", (double)length / best * 1e-6);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    size_t length;
+    char* corpus = make_corpus(&length);
+
+    printf("\n=== Tokenize %.1f MB ===\n", (double)length * 1e-6);
+    run("per-call next_token", tokenize_per_call, corpus, length);
+    run("bulk tokenize_all", tokenize_bulk, corpus, length);
+
+    free(corpus);
+    return EXIT_SUCCESS;
+}
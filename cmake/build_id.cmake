@@ -0,0 +1,22 @@
+# Writes OUTPUT, a header defining MCC_BUILD_ID as a hash of every library source, so anything keyed on it changes
+# with any change to the code that produced it. Run at build time with -DSOURCE_DIR=<repository> -DOUTPUT=<header>.
+
+file(GLOB_RECURSE SOURCES RELATIVE "${SOURCE_DIR}" "${SOURCE_DIR}/lib/*.c" "${SOURCE_DIR}/lib/*.h")
+list(SORT SOURCES)
+
+set(DIGESTS "")
+foreach(SOURCE IN LISTS SOURCES)
+    file(SHA256 "${SOURCE_DIR}/${SOURCE}" DIGEST)
+    string(APPEND DIGESTS "${SOURCE} ${DIGEST}\n")
+endforeach()
+string(SHA256 BUILD_ID "${DIGESTS}")
+string(SUBSTRING "${BUILD_ID}" 0 16 BUILD_ID)
+
+file(WRITE "${OUTPUT}"
+    "/// @file build_id.h\n"
+    "/// @brief Generated by cmake/build_id.cmake from the library sources, do not edit.\n"
+    "\n"
+    "#pragma once\n"
+    "\n"
+    "#define MCC_BUILD_ID \"${BUILD_ID}\"\n"
+)
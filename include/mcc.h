@@ -4,3 +4,4 @@
 
 #include "../lib/defs.h"
 #include "../lib/lexer.h"
+#include "../lib/token_buffer.h"
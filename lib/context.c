@@ -5,17 +5,53 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "./private/arena.h"
+#include "./private/intern.h"
+#include "./private/stats.h"
+#include "./private/utils.h"
 
-struct string_storage {
-    char** strings; // list of null-terimated strings
+#define INITIAL_STORE_SIZE 16
+
+struct allocation_storage {
+    void** allocations; // list of heap allocations (strings, token arrays, ...)
+    size_t size;
+    size_t used;
+};
+
+struct mapping {
+    char* data;
+    size_t mapping_size;
+};
+
+struct mapping_storage {
+    struct mapping* mappings; // list of files mapped with map_file()
     size_t size;
     size_t used;
 };
 
 struct mcc_context {
-    struct string_storage store; // owns all allocated string/wstring data
+    struct arena arena;              // owns source copies, string/wstring literal data and other compiler objects
+    struct intern_table symbols;     // interned identifiers, names live in the arena
+    struct allocation_storage store; // owns heap allocations handed over with mcc_context_store()
+    struct mapping_storage files;    // owns all mapped source files
+#ifdef MCC_STATS
+    struct mcc_stats stats;
+#endif
 };
 
+static void add_mapping(struct mcc_context* ctx, struct mapping mapping) {
+    if (ctx->files.used == ctx->files.size) {
+        ctx->files.size           = ctx->files.size ? ctx->files.size * 2 : 4;
+        struct mapping* new_files = realloc(ctx->files.mappings, sizeof(struct mapping) * ctx->files.size);
+        if (!new_files) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        ctx->files.mappings = new_files;
+    }
+    ctx->files.mappings[ctx->files.used++] = mapping;
+}
+
 struct mcc_context* mcc_context_create(void) {
     struct mcc_context* ctx = malloc(sizeof(*ctx));
     if (!ctx) {
@@ -23,13 +59,20 @@ struct mcc_context* mcc_context_create(void) {
         exit(EXIT_FAILURE);
     }
 
-    ctx->store.strings = malloc(sizeof(char*));
-    if (!ctx->store.strings) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
-    }
-    ctx->store.size = 1;
-    ctx->store.used = 0;
+    arena_create(&ctx->arena);
+    intern_table_create(&ctx->symbols);
+
+    ctx->store.allocations = NULL;
+    ctx->store.size        = 0;
+    ctx->store.used        = 0;
+
+    ctx->files.mappings = NULL;
+    ctx->files.size     = 0;
+    ctx->files.used     = 0;
+
+#ifdef MCC_STATS
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+#endif
 
     return ctx;
 }
@@ -37,23 +80,130 @@ struct mcc_context* mcc_context_create(void) {
 void mcc_context_destroy(struct mcc_context* ctx) {
     assert(ctx);
     for (size_t i = 0; i < ctx->store.used; i++) {
-        free(ctx->store.strings[i]);
+        free(ctx->store.allocations[i]);
     }
-    free(ctx->store.strings);
+    free(ctx->store.allocations);
+    for (size_t i = 0; i < ctx->files.used; i++) {
+        unmap_file(ctx->files.mappings[i].data, ctx->files.mappings[i].mapping_size);
+    }
+    free(ctx->files.mappings);
+    intern_table_destroy(&ctx->symbols);
+    arena_destroy(&ctx->arena);
     free(ctx);
 }
 
+void* mcc_context_alloc(struct mcc_context* ctx, size_t size) {
+    assert(ctx);
+    return arena_alloc(&ctx->arena, size);
+}
+
+void mcc_context_trim(struct mcc_context* ctx, void* ptr, size_t size) {
+    assert(ctx && ptr);
+    arena_trim(&ctx->arena, ptr, size);
+}
+
+uint32_t mcc_context_intern(struct mcc_context* ctx, const char* str, size_t len) {
+    assert(ctx);
+    return intern_table_insert(&ctx->symbols, &ctx->arena, str, len, intern_hash(str, len));
+}
+
+uint32_t mcc_context_intern_hashed(struct mcc_context* ctx, const char* str, size_t len, uint32_t hash) {
+    assert(ctx);
+    return intern_table_insert(&ctx->symbols, &ctx->arena, str, len, hash);
+}
+
+struct mcc_string_view mcc_context_symbol_name(const struct mcc_context* ctx, uint32_t symbol) {
+    assert(ctx && symbol < ctx->symbols.size);
+    return ctx->symbols.names[symbol];
+}
+
+size_t mcc_context_symbol_count(const struct mcc_context* ctx) {
+    assert(ctx);
+    return ctx->symbols.size;
+}
+
+void mcc_context_absorb(struct mcc_context* ctx, struct mcc_context* other) {
+    assert(ctx && other && ctx != other);
+    arena_absorb(&ctx->arena, &other->arena);
+    for (size_t i = 0; i < other->store.used; i++) {
+        mcc_context_store(ctx, other->store.allocations[i]);
+    }
+    other->store.used = 0;
+    for (size_t i = 0; i < other->files.used; i++) {
+        add_mapping(ctx, other->files.mappings[i]);
+    }
+    other->files.used = 0;
+#ifdef MCC_STATS
+    mcc_stats_add(&ctx->stats, &other->stats);
+#endif
+    mcc_context_destroy(other);
+}
+
 void mcc_context_store_string(struct mcc_context* ctx, char* str) {
     assert(ctx && str);
+    mcc_context_store(ctx, str);
+}
+
+void mcc_context_store(struct mcc_context* ctx, void* ptr) {
+    assert(ctx && ptr);
     if (ctx->store.used == ctx->store.size) {
-        char** new_store = malloc(sizeof(char*) * (ctx->store.size *= 2));
+        ctx->store.size  = ctx->store.size ? ctx->store.size * 2 : INITIAL_STORE_SIZE;
+        void** new_store = realloc(ctx->store.allocations, sizeof(void*) * ctx->store.size);
         if (!new_store) {
-            perror("malloc");
+            perror("realloc");
             exit(EXIT_FAILURE);
         }
-        memcpy(new_store, ctx->store.strings, sizeof(char*) * ctx->store.used);
-        free(ctx->store.strings);
-        ctx->store.strings = new_store;
+        ctx->store.allocations = new_store;
+    }
+    ctx->store.allocations[ctx->store.used++] = ptr;
+}
+
+char* mcc_context_map_file(struct mcc_context* ctx, const char* path, size_t* size) {
+    assert(ctx && path && size);
+    size_t mapping_size;
+    char* data = map_file(path, size, &mapping_size);
+    if (!data) {
+        return NULL;
+    }
+
+    add_mapping(ctx, (struct mapping){data, mapping_size});
+
+    return data;
+}
+
+void mcc_context_store_mapping(struct mcc_context* ctx, char* data, size_t mapping_size) {
+    assert(ctx && data);
+    add_mapping(ctx, (struct mapping){data, mapping_size});
+}
+
+bool mcc_context_stats(const struct mcc_context* ctx, struct mcc_stats* stats) {
+    assert(ctx && stats);
+#ifdef MCC_STATS
+    *stats = ctx->stats;
+    return true;
+#else
+    (void)ctx;
+    memset(stats, 0, sizeof(*stats));
+    return false;
+#endif
+}
+
+void mcc_stats_add(struct mcc_stats* stats, const struct mcc_stats* other) {
+    assert(stats && other);
+    for (size_t i = 0; i < MCC_STATS_TOKEN_TYPES; i++) {
+        stats->tokens[i] += other->tokens[i];
+        stats->bytes[i] += other->bytes[i];
     }
-    ctx->store.strings[ctx->store.used++] = str;
+    for (size_t i = 0; i < MCC_STATS_FUNCTION_COUNT; i++) {
+        stats->calls[i] += other->calls[i];
+        stats->cycles[i] += other->cycles[i];
+    }
+    stats->stored_literals += other->stored_literals;
+    stats->stored_literal_bytes += other->stored_literal_bytes;
+}
+
+#ifdef MCC_STATS
+struct mcc_stats* context_stats(struct mcc_context* ctx) {
+    return &ctx->stats;
 }
+#endif
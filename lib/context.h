@@ -9,6 +9,33 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "defs.h"
+
+/// @brief Hot functions of the lexer timed in MCC_STATS builds.
+enum mcc_stats_function {
+    MCC_STATS_SCAN_NUMBER,
+    MCC_STATS_PARSE_NUMBER, // conversion of an integer or floating constant's digits to its value
+    MCC_STATS_PARSE_CHAR,   // one character of a character constant or string literal
+    MCC_STATS_SCAN_STRING,
+    MCC_STATS_SCAN_PUNCTUATOR,
+    MCC_STATS_FUNCTION_COUNT,
+};
+
+#define MCC_STATS_TOKEN_TYPES 7 ///< Entries of mcc_stats::tokens, one per enum mcc_token_type.
+
+/// @brief Instrumentation counters of a context, only counted in builds with MCC_STATS defined.
+struct mcc_stats {
+    uint64_t tokens[MCC_STATS_TOKEN_TYPES]; // tokens lexed, indexed by enum mcc_token_type + 1
+    uint64_t bytes[MCC_STATS_TOKEN_TYPES];  // lexeme bytes of those tokens
+    uint64_t calls[MCC_STATS_FUNCTION_COUNT];
+    uint64_t cycles[MCC_STATS_FUNCTION_COUNT]; // time stamp counter ticks, a function's include the ones it calls
+    uint64_t stored_literals;                  // string literals decoded or joined into context memory
+    uint64_t stored_literal_bytes;             // bytes of those literals, terminators included
+};
+
 /// @brief Opaque compiler context.
 /// @note Create with mcc_context_create(), destroy with mcc_context_destroy().
 struct mcc_context;
@@ -22,8 +49,89 @@ struct mcc_context* mcc_context_create(void);
 /// @note All pointers into context-owned memory (e.g. string literal data) become invalid after this call.
 void mcc_context_destroy(struct mcc_context* ctx);
 
+/// @brief Allocates memory that lives as long as the context.
+/// @param ctx The context to allocate from. Must not be NULL.
+/// @param size Number of bytes to allocate.
+/// @return A pointer suitably aligned for any type. Never returns NULL; exits on allocation failure.
+/// @note Memory comes from a bump arena and is released all at once on mcc_context_destroy(), it must not be freed.
+void* mcc_context_alloc(struct mcc_context* ctx, size_t size);
+
+/// @brief Shrinks the most recent mcc_context_alloc() allocation, returning the unused tail to the context.
+/// @param ctx The context the memory was allocated from. Must not be NULL.
+/// @param ptr The pointer returned by the most recent mcc_context_alloc(). Must not be NULL.
+/// @param size The new size in bytes, must not exceed the allocated size.
+void mcc_context_trim(struct mcc_context* ctx, void* ptr, size_t size);
+
+/// @brief Interns an identifier, returning the symbol shared by every occurrence of the same name.
+/// @param ctx The context that owns the symbol table. Must not be NULL.
+/// @param str Pointer to the name, need not be null-terminated.
+/// @param len Length of the name.
+/// @return A symbol, symbols are dense and assigned from 0 in order of first appearance.
+uint32_t mcc_context_intern(struct mcc_context* ctx, const char* str, size_t len);
+
+/// @brief Interns an identifier whose hash the caller already computed, see mcc_context_intern().
+/// @param ctx The context that owns the symbol table. Must not be NULL.
+/// @param str Pointer to the name, need not be null-terminated.
+/// @param len Length of the name.
+/// @param hash intern_hash() of the name (lib/private/intern.h).
+/// @return The name's symbol.
+uint32_t mcc_context_intern_hashed(struct mcc_context* ctx, const char* str, size_t len, uint32_t hash);
+
+/// @brief Looks up the name of a symbol.
+/// @param ctx The context that owns the symbol table. Must not be NULL.
+/// @param symbol A symbol returned by mcc_context_intern(), must be less than mcc_context_symbol_count().
+/// @return The name, null-terminated and valid until mcc_context_destroy().
+struct mcc_string_view mcc_context_symbol_name(const struct mcc_context* ctx, uint32_t symbol);
+
+/// @brief Counts the distinct identifiers interned so far.
+/// @param ctx The context that owns the symbol table. Must not be NULL.
+/// @return The number of symbols, every symbol is less than this.
+size_t mcc_context_symbol_count(const struct mcc_context* ctx);
+
+/// @brief Takes over everything another context owns and destroys it.
+/// @param ctx The context taking ownership. Must not be NULL.
+/// @param other The context to absorb, invalid after the call. Must not be NULL.
+/// @note Memory from mcc_context_alloc(), stored allocations and mapped files of @p other stay valid for the lifetime
+///       of @p ctx. Symbols are not carried over, a symbol of @p other means nothing to @p ctx.
+void mcc_context_absorb(struct mcc_context* ctx, struct mcc_context* other);
+
 /// @brief Transfers ownership of a heap-allocated string to the context.
 /// @param ctx The context to store the string in. Must not be NULL.
 /// @param str A heap-allocated, null-terminated string. Must not be NULL.
 ///            The context takes ownership and will free it on mcc_context_destroy().
 void mcc_context_store_string(struct mcc_context* ctx, char* str);
+
+/// @brief Transfers ownership of an arbitrary heap allocation to the context.
+/// @param ctx The context to store the allocation in. Must not be NULL.
+/// @param ptr A pointer returned by malloc/realloc. Must not be NULL.
+///            The context takes ownership and will free it on mcc_context_destroy().
+void mcc_context_store(struct mcc_context* ctx, void* ptr);
+
+/// @brief Maps a source file into memory for the lifetime of the context.
+/// @param ctx The context that will own the mapping. Must not be NULL.
+/// @param path The path to the file to map. Must not be NULL.
+/// @param size Pointer to a variable where the file size will be stored. Must not be NULL.
+/// @return A pointer to the file contents, always followed by a '\0', or NULL if the file could not be mapped.
+///         The mapping is released on mcc_context_destroy(). Pass it to mcc_lexer_create_borrowed() to lex the file
+///         without copying it.
+/// @note A file that cannot be opened is left for the caller to report, errno tells why.
+char* mcc_context_map_file(struct mcc_context* ctx, const char* path, size_t* size);
+
+/// @brief Transfers ownership of a file mapped with map_file() to the context.
+/// @param ctx The context that will own the mapping. Must not be NULL.
+/// @param data The pointer returned by map_file(). Must not be NULL.
+/// @param mapping_size The mapping size returned by map_file(). The mapping is released on mcc_context_destroy().
+void mcc_context_store_mapping(struct mcc_context* ctx, char* data, size_t mapping_size);
+
+/// @brief Reads the instrumentation counters of a context.
+/// @param ctx The context. Must not be NULL.
+/// @param stats Pointer to the structure receiving the counters, zeroed when they are not counted.
+/// @return true if the library was built with MCC_STATS, only then is anything counted.
+/// @note A streaming lexer counts a token each time it lexes it, including after a refill cut it short. Absorbing a
+///       context adds its counters to the absorbing one's.
+bool mcc_context_stats(const struct mcc_context* ctx, struct mcc_stats* stats);
+
+/// @brief Adds one set of counters to another, e.g. to total those of several contexts.
+/// @param stats The counters to add to. Must not be NULL.
+/// @param other The counters to add. Must not be NULL.
+void mcc_stats_add(struct mcc_stats* stats, const struct mcc_stats* other);
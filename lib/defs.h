@@ -5,6 +5,10 @@
 
 #include <stddef.h>
 
+/// @brief Version of the compiler, part of the key of everything it caches on disk along with MCC_BUILD_ID, which
+/// changes with every change to the library sources on its own.
+#define MCC_VERSION "0.1.1"
+
 /// @brief A non-owning view into a string.
 /// @note The data is not guarenteed to be null-terminated.
 struct mcc_string_view {
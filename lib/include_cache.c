@@ -0,0 +1,271 @@
+#include "include_cache.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./private/arena.h"
+#include "./private/intern.h"
+#include "./private/simd.h"
+#include "token_cache.h"
+
+#define INITIAL_CAPACITY 16
+
+struct mcc_include_names {
+    struct arena arena;        // path names
+    struct intern_table paths; // path of every file looked up, its symbol indexes mcc_include_cache::files
+    uint32_t ifdef;            // directive names that lex as identifiers, symbols of the context
+    uint32_t ifndef;
+    uint32_t elif;
+    uint32_t endif;
+    uint32_t pragma;
+    uint32_t once;
+    uint32_t defined;
+};
+
+enum directive {
+    DIRECTIVE_OTHER,
+    DIRECTIVE_IF,     // #if, #ifdef and #ifndef
+    DIRECTIVE_ELSE,   // #else and #elif
+    DIRECTIVE_ENDIF,
+    DIRECTIVE_PRAGMA,
+};
+
+void mcc_include_cache_create(struct mcc_context* ctx, struct mcc_include_cache* cache) {
+    assert(ctx && cache);
+    memset(cache, 0, sizeof(*cache));
+
+    struct mcc_include_names* names = malloc(sizeof(*names));
+    if (!names) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    arena_create(&names->arena);
+    intern_table_create(&names->paths);
+    names->ifdef   = mcc_context_intern(ctx, "ifdef", 5);
+    names->ifndef  = mcc_context_intern(ctx, "ifndef", 6);
+    names->elif    = mcc_context_intern(ctx, "elif", 4);
+    names->endif   = mcc_context_intern(ctx, "endif", 5);
+    names->pragma  = mcc_context_intern(ctx, "pragma", 6);
+    names->once    = mcc_context_intern(ctx, "once", 4);
+    names->defined = mcc_context_intern(ctx, "defined", 7);
+
+    cache->ctx   = ctx;
+    cache->names = names;
+}
+
+void mcc_include_cache_destroy(struct mcc_include_cache* cache) {
+    assert(cache);
+    for (size_t i = 0; i < cache->size; i++) {
+        if (cache->files[i]) {
+            mcc_lexer_destroy(&cache->files[i]->lexer);
+        }
+    }
+    free(cache->files);
+    intern_table_destroy(&cache->names->paths);
+    arena_destroy(&cache->names->arena);
+    free(cache->names);
+    memset(cache, 0, sizeof(*cache));
+}
+
+// a newline outside comments between two tokens puts the second at the start of a line, where directives begin
+static bool starts_line(const char* gap, const char* end) {
+    for (const char* p = gap; p < end; p++) {
+        if (*p == '\n') {
+            return true;
+        }
+        if (p[0] == '/' && p + 1 < end && p[1] == '/') {
+            return memchr(p, '\n', (size_t)(end - p)) != NULL;
+        }
+        if (p[0] == '/' && p + 1 < end && p[1] == '*') {
+            p += 2 + find_comment_end(p + 2, end) + 1; // on the '/' of "*/"
+        }
+    }
+    return false;
+}
+
+static bool at_line_start(const struct mcc_include_file* file, size_t i) {
+    if (i == 0) {
+        return true;
+    }
+    const struct mcc_token* before = &file->tokens.data[i - 1];
+    const char* source             = file->lexer.source;
+    return starts_line(source + before->offset + before->lexeme.size, source + file->tokens.data[i].offset);
+}
+
+static bool is_identifier(const struct mcc_token* token, uint32_t symbol) {
+    return token->type == MCC_TOKEN_TYPE_IDENTIFIER && token->value.identifier == symbol;
+}
+
+static bool is_punctuator(const struct mcc_token* token, enum mcc_punctuator punctuator) {
+    return token->type == MCC_TOKEN_TYPE_PUNCTUATOR && token->value.punctuator == punctuator;
+}
+
+static enum directive classify(const struct mcc_include_names* names, const struct mcc_token* name) {
+    if (name->type == MCC_TOKEN_TYPE_KEYWORD) {
+        return name->value.keyword == MCC_KEYWORD_IF     ? DIRECTIVE_IF
+               : name->value.keyword == MCC_KEYWORD_ELSE ? DIRECTIVE_ELSE
+                                                         : DIRECTIVE_OTHER;
+    }
+    if (is_identifier(name, names->ifdef) || is_identifier(name, names->ifndef)) {
+        return DIRECTIVE_IF;
+    }
+    if (is_identifier(name, names->elif)) {
+        return DIRECTIVE_ELSE;
+    }
+    if (is_identifier(name, names->endif)) {
+        return DIRECTIVE_ENDIF;
+    }
+    if (is_identifier(name, names->pragma)) {
+        return DIRECTIVE_PRAGMA;
+    }
+    return DIRECTIVE_OTHER;
+}
+
+// the macro of "#ifndef X", "#if !defined X" or "#if !defined(X)", count being the number of tokens in the directive
+static uint32_t guard_macro(const struct mcc_include_names* names, const struct mcc_token* begin, size_t count) {
+    const struct mcc_token* name = &begin[1];
+    if (count == 3 && is_identifier(name, names->ifndef) && begin[2].type == MCC_TOKEN_TYPE_IDENTIFIER) {
+        return begin[2].value.identifier;
+    }
+    if (name->type != MCC_TOKEN_TYPE_KEYWORD || name->value.keyword != MCC_KEYWORD_IF || count < 5 ||
+        !is_punctuator(&begin[2], MCC_PUNCTUATOR_BANG) || !is_identifier(&begin[3], names->defined)) {
+        return MCC_INCLUDE_NO_GUARD;
+    }
+    if (count == 5 && begin[4].type == MCC_TOKEN_TYPE_IDENTIFIER) {
+        return begin[4].value.identifier;
+    }
+    if (count == 7 && is_punctuator(&begin[4], MCC_PUNCTUATOR_LEFT_PARENTHESIS) &&
+        begin[5].type == MCC_TOKEN_TYPE_IDENTIFIER && is_punctuator(&begin[6], MCC_PUNCTUATOR_RIGHT_PARENTHESIS)) {
+        return begin[5].value.identifier;
+    }
+    return MCC_INCLUDE_NO_GUARD;
+}
+
+// one pass over the directives: a guard is a conditional opened by the first line and closed by the last one with no
+// #else or #elif of its own, #pragma once counts outside conditionals or directly inside such a guard
+static void detect_guard(const struct mcc_include_names* names, struct mcc_include_file* file) {
+    const struct mcc_token* tokens = file->tokens.data;
+    const size_t count             = file->tokens.size - 1; // without EOF
+
+    uint32_t guard     = MCC_INCLUDE_NO_GUARD;
+    bool guard_closed  = false;
+    bool once_outside  = false;
+    bool once_in_guard = false;
+    size_t depth       = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!is_punctuator(&tokens[i], MCC_PUNCTUATOR_HASH) || !at_line_start(file, i)) {
+            guard_closed = guard_closed || depth == 0; // code outside the conditional
+            continue;
+        }
+
+        size_t end = i + 1;
+        while (end < count && !at_line_start(file, end)) {
+            end++;
+        }
+        const enum directive directive = end > i + 1 ? classify(names, &tokens[i + 1]) : DIRECTIVE_OTHER;
+        switch (directive) {
+            case DIRECTIVE_IF:
+                if (depth == 0) {
+                    if (i == 0) {
+                        guard = guard_macro(names, &tokens[i], end - i);
+                    } else {
+                        guard_closed = true; // a second conditional at the top
+                    }
+                }
+                depth++;
+                break;
+            case DIRECTIVE_ELSE:
+                if (depth == 1) {
+                    guard_closed = true;
+                }
+                break;
+            case DIRECTIVE_ENDIF:
+                if (depth == 0) {
+                    guard_closed = true; // unbalanced
+                    break;
+                }
+                if (--depth == 0 && end < count) {
+                    guard_closed = true; // more follows the conditional
+                }
+                break;
+            case DIRECTIVE_PRAGMA:
+                if (end - i == 3 && is_identifier(&tokens[i + 2], names->once)) {
+                    once_outside  = once_outside || depth == 0;
+                    once_in_guard = once_in_guard || (depth == 1 && i > 0);
+                }
+                break;
+            case DIRECTIVE_OTHER:
+            default:
+                guard_closed = guard_closed || depth == 0;
+                break;
+        }
+        i = end - 1;
+    }
+
+    file->guard       = guard_closed || depth != 0 ? MCC_INCLUDE_NO_GUARD : guard;
+    file->pragma_once = once_outside || (once_in_guard && file->guard != MCC_INCLUDE_NO_GUARD);
+}
+
+static struct mcc_include_file* open_file(struct mcc_include_cache* cache, const char* path) {
+    size_t size;
+    char* source = mcc_context_map_file(cache->ctx, path, &size);
+    if (!source) {
+        return NULL;
+    }
+
+    struct mcc_include_file* file = mcc_context_alloc(cache->ctx, sizeof(*file));
+    memset(file, 0, sizeof(*file));
+    file->path = path;
+    mcc_lexer_create_borrowed(cache->ctx, source, size, &file->lexer);
+    file->tokens = cache->token_cache ? mcc_token_cache_tokenize(&file->lexer, cache->token_cache, NULL)
+                                      : mcc_lexer_tokenize_all(&file->lexer);
+    detect_guard(cache->names, file);
+    cache->opened++;
+    return file;
+}
+
+struct mcc_include_file* mcc_include_cache_enter(struct mcc_include_cache* cache,
+                                                 const char* path,
+                                                 mcc_macro_defined_fn defined,
+                                                 void* user,
+                                                 bool* skip) {
+    assert(cache && path && skip);
+
+    struct intern_table* paths = &cache->names->paths;
+    const size_t length        = strlen(path);
+    const uint32_t hash        = intern_hash(path, length);
+    const uint32_t index       = intern_table_insert(paths, &cache->names->arena, path, length, hash);
+    if (index >= cache->capacity) {
+        const size_t capacity           = cache->capacity ? cache->capacity * 2 : INITIAL_CAPACITY;
+        struct mcc_include_file** files = realloc(cache->files, sizeof(*files) * capacity);
+        if (!files) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        memset(files + cache->capacity, 0, sizeof(*files) * (capacity - cache->capacity));
+        cache->files    = files;
+        cache->capacity = capacity;
+    }
+    if (index >= cache->size) {
+        cache->size = index + 1;
+    }
+
+    struct mcc_include_file* file = cache->files[index];
+    if (!file) {
+        file = open_file(cache, paths->names[index].data);
+        if (!file) {
+            return NULL;
+        }
+        cache->files[index] = file;
+    }
+
+    *skip = (file->pragma_once && file->entered) ||
+            (file->guard != MCC_INCLUDE_NO_GUARD && defined && defined(user, file->guard));
+    if (*skip) {
+        cache->skipped++;
+    } else {
+        file->entered = true;
+    }
+    return file;
+}
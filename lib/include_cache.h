@@ -0,0 +1,69 @@
+/// @file lib/include_cache.h
+/// @brief Per-context cache of included files and their tokens, with include guard and #pragma once detection.
+///
+/// Each file is mapped and lexed once per context, however often it is included. When a file is lexed its tokens are
+/// checked for the multiple-include patterns: the whole file wrapped in "#ifndef X" (or "#if !defined X") and its
+/// matching "#endif", with only comments around them, or a "#pragma once" outside any other conditional. Including
+/// the file again is then answered from the cache without touching the file system, and the preprocessor is told to
+/// skip it when its guard macro is defined or it has #pragma once.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "context.h"
+#include "lexer.h"
+
+#define MCC_INCLUDE_NO_GUARD UINT32_MAX ///< mcc_include_file::guard of a file without an include guard.
+
+/// @brief Answers whether a macro is currently defined, supplied by the preprocessor.
+typedef bool (*mcc_macro_defined_fn)(void* user, uint32_t symbol);
+
+struct mcc_include_file {
+    const char* path;              // path the file was first included by, owned by the cache
+    struct mcc_lexer lexer;        // lexer over the mapped file, for mcc_lexer_location()
+    struct mcc_token_array tokens; // every token of the file, owned by the context
+    uint32_t guard;                // symbol of the macro guarding the whole file, or MCC_INCLUDE_NO_GUARD
+    bool pragma_once;              // the file has a #pragma once that applies whenever it is included
+    bool entered;                  // the preprocessor was told to process the file at least once
+};
+
+/// @brief Interned paths and directive names of an include cache.
+struct mcc_include_names;
+
+struct mcc_include_cache {
+    struct mcc_context* ctx;
+    struct mcc_include_names* names;
+    struct mcc_include_file** files; // indexed by path, NULL for a path that could not be opened
+    size_t size;
+    size_t capacity;
+    const char* token_cache; // directory of an on-disk token cache for the files, NULL unless set after creation
+    size_t opened;           // files mapped and lexed
+    size_t skipped;          // includes skipped without processing the file again
+};
+
+/// @brief Initializes an empty include cache.
+/// @param ctx MCC context, the cache is meant to be the only one of its context and must not outlive it.
+/// @param cache Pointer to the cache to initialize.
+void mcc_include_cache_create(struct mcc_context* ctx, struct mcc_include_cache* cache);
+
+/// @brief Releases the cache, the tokens of its files live in the context and stay valid.
+/// @param cache Pointer to the cache to destroy.
+void mcc_include_cache_destroy(struct mcc_include_cache* cache);
+
+/// @brief Looks up a file being included, mapping and lexing it on first use.
+/// @param cache Pointer to the cache.
+/// @param path Path of the file, as resolved by the preprocessor. Files are told apart by this spelling.
+/// @param defined Callback answering whether a macro is defined, NULL if no macro is.
+/// @param user Argument passed to defined.
+/// @param skip Pointer to a variable set to true when the include must be skipped, because the file's guard macro is
+///             defined or it has #pragma once and was entered before.
+/// @return The file, or NULL if it could not be opened. errno tells why and a later call tries again.
+/// @note A file that is not skipped is marked as entered. A file already in the cache is never reopened, even when it
+///       changed on disk since.
+struct mcc_include_file* mcc_include_cache_enter(struct mcc_include_cache* cache,
+                                                 const char* path,
+                                                 mcc_macro_defined_fn defined,
+                                                 void* user,
+                                                 bool* skip);
@@ -1,70 +1,74 @@
 #include "lexer.h"
 
 #include <assert.h>
-#include <ctype.h>
-#include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
+#include "./private/charclass.h"
+#include "./private/dispatch.h"
+#include "./private/float_parse.h"
+#include "./private/intern.h"
+#include "./private/keywords.h"
+#include "./private/pool.h"
+#include "./private/simd.h"
+#include "./private/splice.h"
+#include "./private/stats.h"
+#include "./private/thread.h"
 #include "./private/utils.h"
 #include "context.h"
 #include "defs.h"
 
-#ifdef _MSC_VER
-#define strcasecmp  _stricmp
-#define strncasecmp _strnicmp
-#endif
+#define LEXER_LOOKAHEAD        4 // the lexer reads a byte or two past a token, e.g. "%:%" backing off to "%:"
+#define STREAM_DEFAULT_WINDOW  (64 * 1024)
+#define STREAM_MIN_WINDOW      4096
+#define RING_INITIAL_CAPACITY  16 // a power of two
+#define MARKS_INITIAL_CAPACITY 8
+
+struct mcc_lexer_stream {
+    int fd;
+    char* buffer;              // the window, one byte longer than capacity for the '\0'
+    size_t capacity;           // window size
+    size_t base;               // spliced stream offset of buffer[0]
+    size_t line;               // newlines before buffer[0]
+    size_t line_start;         // original stream offset of the start of the line buffer[0] is on
+    bool eof;                  // the window holds everything up to the end of the input
+    struct splice_map splices; // splices in the window, older ones only counted
+    char pending[2];           // a backslash, and maybe a carriage return, ending the last read
+    size_t pending_count;
+};
+
+struct mcc_lexer_splices {
+    struct splice_map map;
+};
+
+struct mcc_lexer_lookahead {
+    struct mcc_token* ring; // tokens first to scanned - 1, token i at ring[i & (capacity - 1)]
+    size_t capacity;        // a power of two
+    size_t first;           // oldest token kept, the next one or the one of the oldest mark
+    size_t next;            // token mcc_lexer_next_token() returns next
+    size_t scanned;         // tokens scanned so far
+    size_t* marks;          // live marks oldest first, each the token it rewinds to, a mark's handle is its index
+    size_t mark_count;
+    size_t mark_capacity;
+};
+
+struct mcc_lexer_edits {
+    char* source;             // edited copy of the source, the lexer's source from the first edit on
+    size_t capacity;          // bytes allocated for source, excluding the '\0'
+    struct mcc_token* tokens; // token array returned by mcc_lexer_relex()
+    size_t token_capacity;
+};
 
 struct table_entry {
     const char* key;
     int value;
 };
 
-static const struct table_entry keyword_table[] = {
-    {"auto",       MCC_KEYWORD_AUTO     },
-    {"break",      MCC_KEYWORD_BREAK    },
-    {"case",       MCC_KEYWORD_CASE     },
-    {"char",       MCC_KEYWORD_CHAR     },
-    {"const",      MCC_KEYWORD_CONST    },
-    {"continue",   MCC_KEYWORD_CONTINUE },
-    {"default",    MCC_KEYWORD_DEFAULT  },
-    {"do",         MCC_KEYWORD_DO       },
-    {"double",     MCC_KEYWORD_DOUBLE   },
-    {"else",       MCC_KEYWORD_ELSE     },
-    {"enum",       MCC_KEYWORD_ENUM     },
-    {"extern",     MCC_KEYWORD_EXTERN   },
-    {"float",      MCC_KEYWORD_FLOAT    },
-    {"for",        MCC_KEYWORD_FOR      },
-    {"goto",       MCC_KEYWORD_GOTO     },
-    {"if",         MCC_KEYWORD_IF       },
-    {"inline",     MCC_KEYWORD_INLINE   },
-    {"int",        MCC_KEYWORD_INT      },
-    {"long",       MCC_KEYWORD_LONG     },
-    {"register",   MCC_KEYWORD_REGISTER },
-    {"restrict",   MCC_KEYWORD_RESTRICT },
-    {"return",     MCC_KEYWORD_RETURN   },
-    {"short",      MCC_KEYWORD_SHORT    },
-    {"signed",     MCC_KEYWORD_SIGNED   },
-    {"sizeof",     MCC_KEYWORD_SIZEOF   },
-    {"static",     MCC_KEYWORD_STATIC   },
-    {"struct",     MCC_KEYWORD_STRUCT   },
-    {"switch",     MCC_KEYWORD_SWITCH   },
-    {"typedef",    MCC_KEYWORD_TYPEDEF  },
-    {"union",      MCC_KEYWORD_UNION    },
-    {"unsigned",   MCC_KEYWORD_UNSIGNED },
-    {"void",       MCC_KEYWORD_VOID     },
-    {"volatile",   MCC_KEYWORD_VOLATILE },
-    {"while",      MCC_KEYWORD_WHILE    },
-    {"_Bool",      MCC_KEYWORD_BOOL     },
-    {"_Complex",   MCC_KEYWORD_COMPLEX  },
-    {"_Imaginary", MCC_KEYWORD_IMAGINARY},
-    {NULL,         MCC_KEYWORD_NOT_FOUND},
-};
-
 static const struct table_entry integer_suffix_table[] = {
     {"U",   MCC_CONSTANT_TYPE_UNSIGNED_INT          },
     {"L",   MCC_CONSTANT_TYPE_LONG_INT              },
@@ -96,28 +100,25 @@ static const char escape_sequences[256] = {
     ['v']  = '\v',
 };
 
-static int table_lookup(const struct table_entry* table, const char* str, size_t len) {
-    for (; table->key != NULL; table++) {
-        if ((strncmp(table->key, str, len) == 0) && (strlen(table->key) == len)) {
-            break;
+// keys are upper case letters, clearing 0x20 folds exactly those and leaves the comparison independent of the locale
+static bool caseless_equals(const char* key, const char* str, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (key[i] == '\0' || (str[i] & ~0x20) != key[i]) {
+            return false;
         }
     }
-    return table->value;
+    return key[len] == '\0';
 }
 
 static int table_caseless_lookup(const struct table_entry* table, const char* str, size_t len) {
     for (; table->key != NULL; table++) {
-        if ((strncasecmp(table->key, str, len) == 0) && (strlen(table->key) == len)) {
+        if (caseless_equals(table->key, str, len)) {
             break;
         }
     }
     return table->value;
 }
 
-static enum mcc_keyword keyword_lookup(const char* str, size_t len) {
-    return table_lookup(keyword_table, str, len);
-}
-
 static enum mcc_constant_type integer_suffix_lookup(const char* str, size_t len) {
     return table_caseless_lookup(integer_suffix_table, str, len);
 }
@@ -131,12 +132,6 @@ static char curr(struct mcc_lexer* lexer) {
 }
 
 static char next(struct mcc_lexer* lexer) {
-    if (*lexer->current == '\n') {
-        ++lexer->line;
-        lexer->column = 0;
-    } else {
-        ++lexer->column;
-    }
     return *(++lexer->current);
 }
 
@@ -145,30 +140,28 @@ static char peek(struct mcc_lexer* lexer) {
 }
 
 static void skip_whitespace(struct mcc_lexer* lexer) {
-    while (isspace(curr(lexer))) {
-        next(lexer);
-    }
+    lexer->current += span_whitespace(lexer->current, lexer->end);
 }
 
 static struct mcc_token scan_keyword_or_identifier(struct mcc_lexer* lexer) {
-    assert(isident_start(curr(lexer)) && "ensure a valid starting character in identifier or keyword");
+    assert(is_ident_start(curr(lexer)) && "ensure a valid starting character in identifier or keyword");
 
     const struct mcc_lexer state = *lexer;
 
-    while (isident(curr(lexer))) {
-        next(lexer);
-    }
+    lexer->current += span_ident(lexer->current, lexer->end);
 
     const struct mcc_string_view lexeme = mcc_string_view_from_ptrs(state.current, lexer->current);
     const enum mcc_keyword keyword      = keyword_lookup(lexeme.data, lexeme.size);
 
     if (keyword == MCC_KEYWORD_NOT_FOUND) {
+        // hash while the bytes the scan just walked are still hot
+        const uint32_t hash   = intern_hash(lexeme.data, lexeme.size);
+        const uint32_t symbol = mcc_context_intern_hashed(lexer->ctx, lexeme.data, lexeme.size, hash);
         return (struct mcc_token){
             .type   = MCC_TOKEN_TYPE_IDENTIFIER,
-            .value  = {.identifier = lexeme},
+            .value  = {.identifier = symbol},
             .lexeme = lexeme,
-            .line   = state.line,
-            .column = state.column,
+            .offset = (size_t)(state.current - state.source),
         };
     }
 
@@ -176,8 +169,7 @@ static struct mcc_token scan_keyword_or_identifier(struct mcc_lexer* lexer) {
         .type   = MCC_TOKEN_TYPE_KEYWORD,
         .value  = {.keyword = keyword},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 }
 
@@ -189,116 +181,151 @@ static enum mcc_constant_type parse_suffix(struct mcc_string_view lexeme, bool i
     }
 }
 
-// see ISO C99 6.4.4.1 pg 56 for promotion chain.
-// the promotion chain differs for decimal vs hex and octal when unsuffixed
-static struct mcc_constant parse_number(struct mcc_string_view lexeme,
-                                        enum mcc_constant_type type,
-                                        int radix,
-                                        bool is_suffixed) {
+static int digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return INT_MAX; // never a digit in any radix
+}
+
+static bool is_unsigned_type(enum mcc_constant_type type) {
+    return type == MCC_CONSTANT_TYPE_UNSIGNED_INT || type == MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT ||
+           type == MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT;
+}
+
+static int integer_rank(enum mcc_constant_type type) {
+    switch (type) {
+        case MCC_CONSTANT_TYPE_INT:
+        case MCC_CONSTANT_TYPE_UNSIGNED_INT:
+            return 0;
+        case MCC_CONSTANT_TYPE_LONG_INT:
+        case MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT:
+            return 1;
+        default:
+            return 2;
+    }
+}
+
+static unsigned long long integer_max(enum mcc_constant_type type) {
+    switch (type) {
+        case MCC_CONSTANT_TYPE_INT:
+            return INT_MAX;
+        case MCC_CONSTANT_TYPE_UNSIGNED_INT:
+            return UINT_MAX;
+        case MCC_CONSTANT_TYPE_LONG_INT:
+            return LONG_MAX;
+        case MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT:
+            return ULONG_MAX;
+        case MCC_CONSTANT_TYPE_LONG_LONG_INT:
+            return LLONG_MAX;
+        default:
+            return ULLONG_MAX;
+    }
+}
+
+// see ISO C99 6.4.4.1 pg 56 for the promotion chain.
+// the digits are accumulated once, then the first type from the chain below that can represent the value is taken.
+// a candidate must be at least the rank of the suffix, unsigned if the suffix is, and may only be unsigned without a
+// u suffix when the constant is octal or hexadecimal
+static struct mcc_constant parse_integer(struct mcc_string_view lexeme, enum mcc_constant_type suffix_type, int radix) {
     assert((radix == 8 || radix == 10 || radix == 16) && "valid radix");
-    bool strict_promotion_chain = radix == 10 || is_suffixed;
 
-    struct mcc_constant constant = {.type = type};
+    static const enum mcc_constant_type promotion_chain[] = {
+        MCC_CONSTANT_TYPE_INT,
+        MCC_CONSTANT_TYPE_UNSIGNED_INT,
+        MCC_CONSTANT_TYPE_LONG_INT,
+        MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT,
+        MCC_CONSTANT_TYPE_LONG_LONG_INT,
+        MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT,
+    };
+
+    const char* p   = lexeme.data + (radix == 16 ? 2 : 0); // skip 0x, a leading octal 0 is just a zero digit
+    const char* end = lexeme.data + lexeme.size;
 
-    char* lexeme_end = lexeme.data + lexeme.size;
+    unsigned long long value = 0;
+    bool overflow            = false;
+    for (int digit; p != end && (digit = digit_value(*p)) < radix; p++) {
+        if (value > (ULLONG_MAX - (unsigned)digit) / (unsigned)radix) {
+            overflow = true; // keep scanning, the whole literal is still one invalid token
+        }
+        value = value * (unsigned)radix + (unsigned)digit;
+    }
 
-    // only works if lexeme is writable (it's owned by lexer so yes)
-    const char tmp = *lexeme_end;
-    *lexeme_end    = '\0'; // temporarily null-terminate the string for strto* family functions
+    struct mcc_constant constant = {.type = MCC_CONSTANT_TYPE_OVERFLOW};
+    if (overflow) {
+        return constant;
+    }
 
-    char* number_end;
+    const bool suffix_unsigned = is_unsigned_type(suffix_type);
+    const int suffix_rank      = integer_rank(suffix_type);
 
-l_retry:
-    errno = 0; // strto* will set errno on overflow
+    for (size_t i = 0; i < sizeof(promotion_chain) / sizeof(*promotion_chain); i++) {
+        const enum mcc_constant_type type = promotion_chain[i];
+        if (integer_rank(type) < suffix_rank || (suffix_unsigned && !is_unsigned_type(type)) ||
+            (!suffix_unsigned && is_unsigned_type(type) && radix == 10)) {
+            continue;
+        }
+        if (value <= integer_max(type)) {
+            constant.type = type;
+            break;
+        }
+    }
 
     switch (constant.type) {
         case MCC_CONSTANT_TYPE_INT:
-            // constant.value.i will have correct binary representation if constant.value.l <= INT_MAX
-            constant.value.l = strtol(lexeme.data, &number_end, radix);
-            if (errno == ERANGE || (constant.value.l > INT_MAX) || (constant.value.l < INT_MIN)) {
-                if (strict_promotion_chain) {
-                    constant.type = MCC_CONSTANT_TYPE_LONG_INT;
-                } else {
-                    constant.type = MCC_CONSTANT_TYPE_UNSIGNED_INT;
-                }
-                goto l_retry;
-            }
+            constant.value.i = (int)value;
             break;
         case MCC_CONSTANT_TYPE_LONG_INT:
-            constant.value.l = strtol(lexeme.data, &number_end, radix);
-            if (errno == ERANGE) {
-                if (strict_promotion_chain) {
-                    constant.type = MCC_CONSTANT_TYPE_LONG_LONG_INT;
-                } else {
-                    constant.type = MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT;
-                }
-                goto l_retry;
-            }
+            constant.value.l = (long)value;
             break;
         case MCC_CONSTANT_TYPE_LONG_LONG_INT:
-            constant.value.ll = strtoll(lexeme.data, &number_end, radix);
-            if (errno == ERANGE) {
-                if (strict_promotion_chain) {
-                    constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
-                    break; // exit on overflow
-                } else {
-                    constant.type = MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT;
-                }
-                goto l_retry;
-            }
+            constant.value.ll = (long long)value;
             break;
         case MCC_CONSTANT_TYPE_UNSIGNED_INT:
-            // constant.value.u will have correct binary representation if constant.value.ul <= UINT_MAX
-            constant.value.ul = strtoul(lexeme.data, &number_end, radix);
-            if (errno == ERANGE || constant.value.ul > UINT_MAX) {
-                if (strict_promotion_chain) {
-                    constant.type = MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT;
-                } else {
-                    constant.type = MCC_CONSTANT_TYPE_LONG_INT;
-                }
-                goto l_retry;
-            }
+            constant.value.u = (unsigned)value;
             break;
         case MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT:
-            constant.value.ul = strtoul(lexeme.data, &number_end, radix);
-            if (errno == ERANGE) {
-                if (strict_promotion_chain) {
-                    constant.type = MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT;
-                } else {
-                    constant.type = MCC_CONSTANT_TYPE_LONG_LONG_INT;
-                }
-                goto l_retry;
-            }
+            constant.value.ul = (unsigned long)value;
             break;
         case MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT:
-            constant.value.ull = strtoull(lexeme.data, &number_end, radix);
-            if (errno == ERANGE) {
-                constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
-            }
+            constant.value.ull = value;
+            break;
+        default:
             break;
+    }
+
+    return constant;
+}
+
+static struct mcc_constant parse_floating(struct mcc_string_view lexeme, enum mcc_constant_type type) {
+    struct mcc_constant constant = {.type = type};
+
+    const char* lexeme_end = lexeme.data + lexeme.size;
+    bool in_range          = false;
+
+    switch (type) {
         case MCC_CONSTANT_TYPE_FLOAT:
-            constant.value.f = strtof(lexeme.data, &number_end);
-            if (errno == ERANGE) {
-                constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
-            }
+            in_range = parse_float(lexeme.data, lexeme_end, &constant.value.f);
             break;
         case MCC_CONSTANT_TYPE_DOUBLE:
-            constant.value.d = strtod(lexeme.data, &number_end);
-            if (errno == ERANGE) {
-                constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
-            }
+            in_range = parse_double(lexeme.data, lexeme_end, &constant.value.d);
             break;
         case MCC_CONSTANT_TYPE_LONG_DOUBLE:
-            constant.value.ld = strtold(lexeme.data, &number_end);
-            if (errno == ERANGE) {
-                constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
-            }
+            in_range = parse_long_double(lexeme.data, lexeme_end, &constant.value.ld);
             break;
         default:
             assert(false);
     }
 
-    *lexeme_end = tmp; // restore original character
+    if (!in_range) {
+        constant.type = MCC_CONSTANT_TYPE_OVERFLOW;
+    }
 
     return constant;
 }
@@ -315,7 +342,6 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
     bool is_hex        = false;
     bool maybe_octal   = false;
     bool invalid_octal = false;
-    bool is_suffixed   = false;
 
     int radix = 10;
 
@@ -327,7 +353,7 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
         c = next(lexer);
         if (c == 'x' || c == 'X') {
             c = next(lexer);
-            if (!isxdigit(c)) {
+            if (!is_xdigit(c)) {
                 error_message = "invalid character sequence in number";
             }
             radix  = 16;
@@ -338,7 +364,7 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
     }
 
     // maximal munch
-    while (isalnum(c) || c == '.') {
+    while (is_alnum(c) || c == '.') {
         if (c == '.') {
             if (seen_decimal_point) {
                 error_message = "multiple decimal points in number";
@@ -362,25 +388,24 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
                 c = next(lexer);
             }
 
-            if (!isdigit(peek(lexer))) {
+            if (!is_digit(peek(lexer))) {
                 error_message = "invalid character sequence in exponent";
             }
-        } else if (((!is_hex || seen_significand) && !isdigit(c)) || (is_hex && !isxdigit(c))) {
+        } else if (((!is_hex || seen_significand) && !is_digit(c)) || (is_hex && !is_xdigit(c))) {
             char* suffix_begin = lexer->current;
             do {
                 c = next(lexer);
-            } while (isalnum(c) || c == '.');
+            } while (is_alnum(c) || c == '.');
             const char* suffix_end = lexer->current;
 
             const struct mcc_string_view suffix = mcc_string_view_from_ptrs(suffix_begin, suffix_end);
 
-            is_suffixed = true;
             number_type = parse_suffix(suffix, is_float);
             if (number_type == MCC_CONSTANT_TYPE_INVALID) {
                 error_message = is_float ? "invalid float literal suffix" : "invalid integer literal suffix";
             }
             break; // finding a suffix ends the number (and we already are past the lexeme)
-        } else if (maybe_octal && !isodigit(c)) {
+        } else if (maybe_octal && !is_odigit(c)) {
             invalid_octal = true;
         }
 
@@ -402,7 +427,10 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
         goto l_abort;
     }
 
-    const struct mcc_constant constant = parse_number(lexeme, number_type, radix, is_suffixed);
+    STATS_START(parse_timer);
+    const struct mcc_constant constant =
+        is_float ? parse_floating(lexeme, number_type) : parse_integer(lexeme, number_type, radix);
+    STATS_STOP(lexer->ctx, MCC_STATS_PARSE_NUMBER, parse_timer);
 
     if (constant.type < 0) {
         switch (constant.type) {
@@ -418,8 +446,7 @@ static struct mcc_token scan_number(struct mcc_lexer* lexer) {
         .type   = MCC_TOKEN_TYPE_CONSTANT,
         .value  = {.constant = constant},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 
 l_abort:
@@ -427,8 +454,7 @@ l_abort:
         .type   = MCC_TOKEN_TYPE_INVALID,
         .value  = {.error_message = error_message},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 }
 
@@ -448,8 +474,8 @@ static struct mcc_constant parse_char(struct mcc_string_view lexeme, bool is_wid
             int required           = (esc == 'u') ? 4 : 8;
             int consumed           = 0;
             unsigned long long val = 0;
-            while (consumed < required && isxdigit((unsigned char)*p)) {
-                val = (val * 16) + (isdigit((unsigned char)*p) ? (*p - '0') : (tolower((unsigned char)*p) - 'a' + 10));
+            while (consumed < required && is_xdigit(*p)) {
+                val = (val * 16) + (unsigned long long)digit_value(*p);
                 p++;
                 consumed++;
             }
@@ -466,11 +492,11 @@ static struct mcc_constant parse_char(struct mcc_string_view lexeme, bool is_wid
                 return (struct mcc_constant){.type = MCC_CONSTANT_TYPE_INVALID};
             }
             i = (int)val;
-        } else if (isodigit((unsigned char)esc)) {
+        } else if (is_odigit(esc)) {
             // Octal escape: 1-3 octal digits, first digit already in esc
             int consumed = 1;
             unsigned val = (unsigned)esc - '0';
-            while (consumed < 3 && isodigit((unsigned char)*p)) {
+            while (consumed < 3 && is_odigit(*p)) {
                 val = val * 8 + (*p - '0');
                 p++;
                 consumed++;
@@ -482,13 +508,13 @@ static struct mcc_constant parse_char(struct mcc_string_view lexeme, bool is_wid
             i = (int)(char)val;
         } else if (esc == 'x') {
             // Hex escape: one or more hex digits (greedy)
-            if (!isxdigit((unsigned char)*p)) {
+            if (!is_xdigit(*p)) {
                 // \x with no digits
                 return (struct mcc_constant){.type = MCC_CONSTANT_TYPE_INVALID};
             }
             unsigned val = 0;
-            while (isxdigit((unsigned char)*p)) {
-                val = val * 16 + (isdigit((unsigned char)*p) ? (*p - '0') : (tolower((unsigned char)*p) - 'a' + 10));
+            while (is_xdigit(*p)) {
+                val = val * 16 + (unsigned)digit_value(*p);
                 p++;
 
                 if (val > UCHAR_MAX) {
@@ -544,22 +570,28 @@ static struct mcc_token scan_char(struct mcc_lexer* lexer) {
 
     char* char_begin = lexer->current;
     while (curr(lexer) != '\'' && curr(lexer) != '\0') {
+        if (curr(lexer) == '\\' && peek(lexer) != '\0') {
+            next(lexer); // an escaped quote does not end the literal
+        }
         next(lexer);
     }
     char* char_end = lexer->current;
 
     const struct mcc_string_view character = mcc_string_view_from_ptrs(char_begin, char_end);
-    const struct mcc_constant constant     = parse_char(character, is_wide, NULL);
+    STATS_START(parse_timer);
+    const struct mcc_constant constant = parse_char(character, is_wide, NULL);
+    STATS_STOP(lexer->ctx, MCC_STATS_PARSE_CHAR, parse_timer);
     /* don't check the len because multi-char constants are implementation defined and mcc uses first char */
 
     if (curr(lexer) == '\0') {
-        error_message = "unterminated character constant";
-    } else if (character.size == 0) {
-        error_message = "empty character constant";
+        error_message = "unterminated character constant"; // the terminator is not part of the lexeme
+    } else {
+        if (character.size == 0) {
+            error_message = "empty character constant";
+        }
+        assert(error_message || curr(lexer) == '\'');
+        next(lexer); // lexeme end pointer
     }
-    assert(error_message || curr(lexer) == '\'');
-
-    next(lexer); // lexeme end pointer
     const struct mcc_string_view lexeme = mcc_string_view_from_ptrs(state.current, lexer->current);
 
     if (error_message) {
@@ -575,8 +607,7 @@ static struct mcc_token scan_char(struct mcc_lexer* lexer) {
         .type   = MCC_TOKEN_TYPE_CONSTANT,
         .value  = {.constant = constant},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 
 l_abort:
@@ -584,11 +615,74 @@ l_abort:
         .type   = MCC_TOKEN_TYPE_INVALID,
         .value  = {.error_message = error_message},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 }
 
+// "\xNN" with exactly two digits, the common spelling of embedded binary data
+static bool is_hex_byte_escape(const char* p, const char* end) {
+    return end - p >= 4 && p[0] == '\\' && p[1] == 'x' && is_xdigit(p[2]) && is_xdigit(p[3]) &&
+           (end - p == 4 || !is_xdigit(p[4]));
+}
+
+// decodes the characters between a literal's quotes into string, which has room for view.size of them, returns how
+// many were written or SIZE_MAX at the first invalid one. Runs of plain characters are copied in bulk, widened for a
+// wide literal, and only escape sequences are decoded one at a time
+static size_t decode_string(struct mcc_context* ctx, struct mcc_string_view view, bool is_wide, void* string) {
+    (void)ctx; // only counted with MCC_STATS
+
+    char* p         = view.data;
+    const char* end = view.data + view.size;
+    size_t chars    = 0;
+    for (;;) {
+        // the body holds no quote or null character, so the run stops at a backslash, a newline or the end
+        const size_t run = find_literal_stop(p, end, '"');
+        if (is_wide) {
+            widen_chars(p, p + run, (wchar_t*)string + chars);
+        } else {
+            memcpy((char*)string + chars, p, run);
+        }
+        chars += run;
+        p += run;
+        if (p == end) {
+            return chars;
+        }
+        if (*p != '\\') {
+            return SIZE_MAX;
+        }
+
+        // a value cast to char first, as parse_char does, so wide literals sign-extend the same way
+        while (is_hex_byte_escape(p, end)) {
+            const char c = (char)(digit_value(p[2]) << 4 | digit_value(p[3]));
+            if (is_wide) {
+                ((wchar_t*)string)[chars++] = (wchar_t)c;
+            } else {
+                ((char*)string)[chars++] = c;
+            }
+            p += 4;
+        }
+        if (p == end || *p != '\\') {
+            continue;
+        }
+
+        size_t len;
+        const struct mcc_string_view escape = mcc_string_view_from_ptrs(p, end);
+        STATS_START(parse_timer);
+        const struct mcc_constant constant = parse_char(escape, is_wide, &len);
+        STATS_STOP(ctx, MCC_STATS_PARSE_CHAR, parse_timer);
+        if (constant.type < 0) {
+            return SIZE_MAX;
+        } else if (is_wide) {
+            assert(constant.type == MCC_CONSTANT_TYPE_WIDE_CHAR);
+            ((wchar_t*)string)[chars++] = constant.value.wc;
+        } else {
+            assert(constant.type == MCC_CONSTANT_TYPE_CHAR);
+            ((char*)string)[chars++] = (char)constant.value.i;
+        }
+        p += len;
+    }
+}
+
 static struct mcc_token scan_string(struct mcc_lexer* lexer) {
     const struct mcc_lexer state = *lexer;
 
@@ -600,51 +694,57 @@ static struct mcc_token scan_string(struct mcc_lexer* lexer) {
         next(lexer);
         is_wide = true;
     }
-    assert(curr(lexer) == '"' && "scan_char must be called on '\"' or 'L\"' prefix");
+    assert(curr(lexer) == '"' && "scan_string must be called on '\"' or 'L\"' prefix");
     next(lexer); // skip '"'
 
     char* str_begin = lexer->current;
-    while (curr(lexer) != '"' && curr(lexer) != '\0') {
-        next(lexer);
+    lexer->current += find_literal_stop(lexer->current, lexer->end, '"');
+
+    // without escapes a narrow literal is its own spelling and needs no copy. A stream's window is reused, so its
+    // literals are always copied
+    if (curr(lexer) == '"' && !is_wide && !lexer->stream) {
+        const struct mcc_string_literal in_place = {
+            .type  = MCC_STRING_LITERAL_TYPE_STRING,
+            .value = {.string = mcc_string_view_from_ptrs(str_begin, lexer->current)},
+        };
+        next(lexer); // lexeme end pointer
+        return (struct mcc_token){
+            .type   = MCC_TOKEN_TYPE_STRING_LITERAL,
+            .value  = {.string_literal = in_place},
+            .lexeme = mcc_string_view_from_ptrs(state.current, lexer->current),
+            .offset = (size_t)(state.current - state.source),
+        };
+    }
+    while (curr(lexer) == '\\' || curr(lexer) == '\n') {
+        // an escaped quote does not end the literal, a newline in it is reported once it is decoded
+        lexer->current += curr(lexer) == '\\' && peek(lexer) != '\0' ? 2 : 1;
+        lexer->current += find_literal_stop(lexer->current, lexer->end, '"');
     }
     char* str_end = lexer->current;
 
     const struct mcc_string_view view = mcc_string_view_from_ptrs(str_begin, str_end);
 
-    void* string = malloc((is_wide ? sizeof(wchar_t) : sizeof(char)) * (view.size + 1)); // over alloc is ok
-    if (!string) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
-    }
-
-    size_t chars = 0; // string literal char count
-    for (size_t len, total = 0; total < view.size; chars++) {
-        const struct mcc_string_view slice = mcc_string_view_from_ptrs(view.data + total, view.data + view.size);
-        const struct mcc_constant constant = parse_char(slice, is_wide, &len);
+    // escapes only ever shrink the literal, the unused tail is trimmed once the size is known
+    const size_t char_size = is_wide ? sizeof(wchar_t) : sizeof(char);
+    void* string           = mcc_context_alloc(lexer->ctx, char_size * (view.size + 1));
 
-        if (constant.type < 0) {
-            error_message = "invalid character in string literal";
-            break;
-        } else if (is_wide) {
-            assert(constant.type == MCC_CONSTANT_TYPE_WIDE_CHAR);
-            ((wchar_t*)string)[chars] = constant.value.wc;
-        } else {
-            assert(constant.type == MCC_CONSTANT_TYPE_CHAR);
-            ((char*)string)[chars] = (char)constant.value.i;
-        }
-        total += len;
+    size_t chars = decode_string(lexer->ctx, view, is_wide, string);
+    if (chars == SIZE_MAX) {
+        error_message = "invalid character in string literal";
+        chars         = 0;
     }
 
     if (is_wide) {
-        ((wchar_t*)string)[chars++] = 0;
+        ((wchar_t*)string)[chars] = 0;
     } else {
-        ((char*)string)[chars++] = 0;
+        ((char*)string)[chars] = 0;
     }
 
-    mcc_context_store_string(lexer->ctx, string);
+    mcc_context_trim(lexer->ctx, string, char_size * (chars + 1));
+    STATS_LITERAL(lexer->ctx, char_size * (chars + 1));
 
     if (curr(lexer) == '\0') {
-        error_message = "unterminated character constant";
+        error_message = "unterminated string literal";
     } else {
         assert(error_message || curr(lexer) == '"');
         next(lexer); // lexeme end pointer
@@ -662,11 +762,10 @@ static struct mcc_token scan_string(struct mcc_lexer* lexer) {
     };
 
     return (struct mcc_token){
-        .type   = MCC_TOKEN_TYPE_CONSTANT,
+        .type   = MCC_TOKEN_TYPE_STRING_LITERAL,
         .value  = {.string_literal = string_literal},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 
 l_abort:
@@ -674,8 +773,7 @@ l_abort:
         .type   = MCC_TOKEN_TYPE_INVALID,
         .value  = {.error_message = error_message},
         .lexeme = lexeme,
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 }
 
@@ -683,310 +781,24 @@ static struct mcc_token scan_punctuator(struct mcc_lexer* lexer) {
     const struct mcc_lexer state = *lexer;
 
     enum mcc_punctuator punctuator;
+    const size_t len = punctuator_match(lexer->current, &punctuator);
 
-    switch (curr(lexer)) {
-        case '!':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_BANG_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_BANG;
-                    break;
-            }
-            break;
-        case '#':
-            switch (next(lexer)) {
-                case '#':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_HASH_HASH;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_HASH;
-                    break;
-            }
-            break;
-        case '%':
-            switch (next(lexer)) {
-                case ':':
-                    switch (next(lexer)) {
-                        case '%':
-                            switch (peek(lexer)) {
-                                case ':':
-                                    next(lexer);
-                                    next(lexer);
-                                    punctuator = MCC_PUNCTUATOR_HASH_HASH;
-                                    break;
-                                default:
-                                    punctuator = MCC_PUNCTUATOR_HASH;
-                                    break;
-                            }
-                            break;
-                        default:
-                            punctuator = MCC_PUNCTUATOR_HASH;
-                            break;
-                    }
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_PERCENT_EQUAL;
-                    break;
-                case '>':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_RIGHT_BRACE;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_PERCENT;
-                    break;
-            }
-            break;
-        case '&':
-            switch (next(lexer)) {
-                case '&':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_AMPERSAND_AMPERSAND;
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_AMPERSAND_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_AMPERSAND;
-                    break;
-            }
-            break;
-        case '(':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_LEFT_PARENTHESIS;
-            break;
-        case ')':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_RIGHT_PARENTHESIS;
-            break;
-        case '*':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_ASTERISK_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_ASTERISK;
-                    break;
-            }
-            break;
-        case '+':
-            switch (next(lexer)) {
-                case '+':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_PLUS_PLUS;
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_PLUS_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_PLUS;
-                    break;
-            }
-            break;
-        case ',':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_COMMA;
-            break;
-        case '-':
-            switch (next(lexer)) {
-                case '-':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_MINUS_MINUS;
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_MINUS_EQUAL;
-                    break;
-                case '>':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_ARROW;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_MINUS;
-                    break;
-            }
-            break;
-        case '.':
-            switch (next(lexer)) {
-                case '.':
-                    switch (peek(lexer)) {
-                        case '.':
-                            next(lexer);
-                            next(lexer);
-                            punctuator = MCC_PUNCTUATOR_ELLIPSIS;
-                            break;
-                        default:
-                            punctuator = MCC_PUNCTUATOR_DOT;
-                            break;
-                    }
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_DOT;
-                    break;
-            }
-            break;
-        case '/':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_SLASH_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_SLASH;
-                    break;
-            }
-            break;
-        case ':':
-            switch (next(lexer)) {
-                case '>':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_RIGHT_BRACKET;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_COLON;
-                    break;
-            }
-            break;
-        case ';':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_SEMICOLON;
-            break;
-        case '<':
-            switch (next(lexer)) {
-                case '%':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_LEFT_BRACE;
-                    break;
-                case ':':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_LEFT_BRACKET;
-                    break;
-                case '<':
-                    switch (next(lexer)) {
-                        case '=':
-                            next(lexer);
-                            punctuator = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON_EQUAL;
-                            break;
-                        default:
-                            punctuator = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON;
-                            break;
-                    }
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_LEFT_CHEVRON_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_LEFT_CHEVRON;
-                    break;
-            }
-            break;
-        case '=':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_EQUAL_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_EQUAL;
-                    break;
-            }
-            break;
-        case '>':
-            switch (next(lexer)) {
-                case '>':
-                    switch (next(lexer)) {
-                        case '=':
-                            next(lexer);
-                            punctuator = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON_EQUAL;
-                            break;
-                        default:
-                            punctuator = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON;
-                            break;
-                    }
-                    break;
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_RIGHT_CHEVRON_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_RIGHT_CHEVRON;
-                    break;
-            }
-            break;
-        case '?':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_QUESTION_MARK;
-            break;
-        case '[':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_LEFT_BRACKET;
-            break;
-        case ']':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_RIGHT_BRACKET;
-            break;
-        case '^':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_CARET_EQUAL;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_CARET;
-                    break;
-            }
-            break;
-        case '{':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_LEFT_BRACE;
-            break;
-        case '|':
-            switch (next(lexer)) {
-                case '=':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_PIPE_EQUAL;
-                    break;
-                case '|':
-                    next(lexer);
-                    punctuator = MCC_PUNCTUATOR_PIPE_PIPE;
-                    break;
-                default:
-                    punctuator = MCC_PUNCTUATOR_PIPE;
-                    break;
-            }
-            break;
-        case '}':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_RIGHT_BRACE;
-            break;
-        case '~':
-            next(lexer);
-            punctuator = MCC_PUNCTUATOR_TILDE;
-            break;
-        default:
-            return (struct mcc_token){
-                .type   = MCC_TOKEN_TYPE_INVALID,
-                .value  = {.error_message = "invalid character sequence"},
-                .lexeme = mcc_string_view_from_ptrs(state.current, lexer->current),
-                .line   = state.line,
-                .column = state.column,
-            };
+    if (len == 0) {
+        next(lexer); // consume the offending character so the lexer always makes progress
+        return (struct mcc_token){
+            .type   = MCC_TOKEN_TYPE_INVALID,
+            .value  = {.error_message = "invalid character sequence"},
+            .lexeme = mcc_string_view_from_ptrs(state.current, lexer->current),
+            .offset = (size_t)(state.current - state.source),
+        };
     }
+    lexer->current += len;
 
     return (struct mcc_token){
         .type   = MCC_TOKEN_TYPE_PUNCTUATOR,
         .value  = {.punctuator = punctuator},
         .lexeme = mcc_string_view_from_ptrs(state.current, lexer->current),
-        .line   = state.line,
-        .column = state.column,
+        .offset = (size_t)(state.current - state.source),
     };
 }
 
@@ -994,72 +806,1101 @@ static struct mcc_token scan_eof(struct mcc_lexer* lexer) {
     return (struct mcc_token){
         .type   = MCC_TOKEN_TYPE_EOF,
         .lexeme = {lexer->current, 0},
-        .line   = lexer->line,
-        .column = lexer->column,
+        .offset = (size_t)(lexer->current - lexer->source),
     };
 }
 
+// the lexer's splice map, allocated on first use
+static struct splice_map* splice_map_of(struct mcc_lexer* lexer) {
+    if (!lexer->splices) {
+        lexer->splices = malloc(sizeof(struct mcc_lexer_splices));
+        if (!lexer->splices) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        splice_map_create(&lexer->splices->map);
+    }
+    return &lexer->splices->map;
+}
+
+// translation phase 2 into a copy owned by the context, only sources that have a line splice pay for it
+static char* splice_source(struct mcc_lexer* lexer, const char* source, size_t* length) {
+    char* spliced    = mcc_context_alloc(lexer->ctx, *length + 1);
+    *length          = splice_lines(spliced, source, source + *length, 0, splice_map_of(lexer));
+    spliced[*length] = '\0';
+    return spliced;
+}
+
 void mcc_lexer_create(struct mcc_context* ctx, const char* source, size_t length, struct mcc_lexer* lexer) {
     assert(ctx && lexer && source);
     memset(lexer, 0, sizeof(*lexer));
+    lexer->ctx = ctx;
 
-    lexer->source = malloc(length + 1);
-    if (!lexer->source) {
-        perror("malloc");
-        exit(EXIT_FAILURE);
+    if (find_line_splice(source, source + length) < length) {
+        lexer->source = splice_source(lexer, source, &length);
+    } else {
+        lexer->source = mcc_context_alloc(ctx, length + 1); // context owns source
+        memcpy(lexer->source, source, length);
+        lexer->source[length] = '\0';
     }
-    memcpy(lexer->source, source, length);
-    lexer->source[length] = '\0';
-    lexer->current        = lexer->source;
+    lexer->current = lexer->source;
+    lexer->end     = lexer->source + length;
+}
 
+void mcc_lexer_create_borrowed(struct mcc_context* ctx, char* source, size_t length, struct mcc_lexer* lexer) {
+    assert(ctx && lexer && source);
+    assert(source[length] == '\0' && "borrowed source must be null-terminated");
+    memset(lexer, 0, sizeof(*lexer));
     lexer->ctx = ctx;
-    mcc_context_store_string(ctx, lexer->source); // context owns source
+
+    if (find_line_splice(source, source + length) < length) {
+        source = splice_source(lexer, source, &length);
+    }
+    lexer->source  = source;
+    lexer->current = source;
+    lexer->end     = source + length;
 }
 
 void mcc_lexer_destroy(struct mcc_lexer* lexer) {
     assert(lexer);
+    free(lexer->line_starts);
+    if (lexer->stream) {
+        splice_map_destroy(&lexer->stream->splices);
+        free(lexer->stream->buffer);
+        free(lexer->stream);
+    }
+    if (lexer->edits) {
+        free(lexer->edits->source);
+        free(lexer->edits->tokens);
+        free(lexer->edits);
+    }
+    if (lexer->splices) {
+        splice_map_destroy(&lexer->splices->map);
+        free(lexer->splices);
+    }
+    if (lexer->lookahead) {
+        free(lexer->lookahead->ring);
+        free(lexer->lookahead->marks);
+        free(lexer->lookahead);
+    }
     memset(lexer, 0, sizeof(*lexer));
 }
 
-struct mcc_token mcc_lexer_next_token(struct mcc_lexer* lexer) {
-    assert(lexer && lexer->source && lexer->current);
-
-#ifdef MCC_DEBUG
+// translation phase 3 turns comments into whitespace, they are skipped with it. Returns false at a block comment that
+// is not closed before the end, or a line comment a stream's window cuts off, leaving current on it
+static inline bool skip_blank(struct mcc_lexer* lexer) {
     skip_whitespace(lexer);
-
-    // Skip single-line comments in debug builds for easier testing
-    // Should be handled in the preprocessor in release builds
-    while (curr(lexer) == '/' && peek(lexer) == '/') {
-        while (curr(lexer) != '\n' && curr(lexer) != '\0') {
-            next(lexer);
+    while (curr(lexer) == '/' && (peek(lexer) == '/' || peek(lexer) == '*')) {
+        const char* body = lexer->current + 2;
+        if (peek(lexer) == '/') {
+            const char* newline = memchr(body, '\n', (size_t)(lexer->end - body));
+            if (!newline && lexer->stream && !lexer->stream->eof) {
+                return false;
+            }
+            lexer->current = newline ? (char*)newline : lexer->end;
+        } else {
+            const size_t n = find_comment_end(body, lexer->end);
+            if (body + n == lexer->end) {
+                return false;
+            }
+            lexer->current += 2 + n + 2;
         }
         skip_whitespace(lexer);
     }
-#endif
+    return true;
+}
 
-    skip_whitespace(lexer);
+static struct mcc_token scan_unterminated_comment(struct mcc_lexer* lexer) {
+    char* begin    = lexer->current;
+    lexer->current = lexer->end;
+    return (struct mcc_token){
+        .type   = MCC_TOKEN_TYPE_INVALID,
+        .value  = {.error_message = "unterminated comment"},
+        .lexeme = mcc_string_view_from_ptrs(begin, lexer->end),
+        .offset = (size_t)(begin - lexer->source),
+    };
+}
 
-    char c = curr(lexer);
+#ifdef MCC_STATS
+// runs a scanner as one timed call
+static struct mcc_token timed_scan(struct mcc_lexer* lexer,
+                                   struct mcc_token (*scan)(struct mcc_lexer*),
+                                   enum mcc_stats_function function) {
+    STATS_START(timer);
+    const struct mcc_token token = scan(lexer);
+    STATS_STOP(lexer->ctx, function, timer);
+    return token;
+}
+#define TIMED_SCAN(lexer, scan, function) timed_scan(lexer, scan, function)
+#else
+#define TIMED_SCAN(lexer, scan, function) scan(lexer)
+#endif
 
-    if (c == '\0') {
-        return scan_eof(lexer);
+static inline struct mcc_token scan_token(struct mcc_lexer* lexer) {
+    if (!skip_blank(lexer)) {
+        return scan_unterminated_comment(lexer);
     }
 
-    if (isdigit(c) || (c == '.' && isdigit(peek(lexer)))) {
-        return scan_number(lexer);
+    switch ((enum token_start)token_start_table[(unsigned char)curr(lexer)]) {
+        case TOKEN_START_END:
+            return scan_eof(lexer);
+        case TOKEN_START_DIGIT:
+            return TIMED_SCAN(lexer, scan_number, MCC_STATS_SCAN_NUMBER);
+        case TOKEN_START_DOT:
+            return is_digit(peek(lexer)) ? TIMED_SCAN(lexer, scan_number, MCC_STATS_SCAN_NUMBER)
+                                         : TIMED_SCAN(lexer, scan_punctuator, MCC_STATS_SCAN_PUNCTUATOR);
+        case TOKEN_START_CHAR:
+            return scan_char(lexer);
+        case TOKEN_START_STRING:
+            return TIMED_SCAN(lexer, scan_string, MCC_STATS_SCAN_STRING);
+        case TOKEN_START_WIDE:
+            if (peek(lexer) == '\'') {
+                return scan_char(lexer);
+            }
+            if (peek(lexer) == '\"') {
+                return TIMED_SCAN(lexer, scan_string, MCC_STATS_SCAN_STRING);
+            }
+            return scan_keyword_or_identifier(lexer);
+        case TOKEN_START_IDENT:
+            return scan_keyword_or_identifier(lexer);
+        case TOKEN_START_OTHER:
+        default:
+            return TIMED_SCAN(lexer, scan_punctuator, MCC_STATS_SCAN_PUNCTUATOR);
     }
+}
+
+// shared by mcc_lexer_next_token and mcc_lexer_tokenize_all so the bulk loop can inline the dispatch
+static inline struct mcc_token lex(struct mcc_lexer* lexer) {
+    const struct mcc_token token = scan_token(lexer);
+    STATS_TOKEN(lexer->ctx, &token);
+    return token;
+}
+
+// drops the window before keep and reads the input on behind what is left, splicing what was read
+static void refill(struct mcc_lexer* lexer, char* keep) {
+    struct mcc_lexer_stream* stream = lexer->stream;
 
-    if (c == '\'' || (c == 'L' && peek(lexer) == '\'')) {
-        return scan_char(lexer);
+    // lines scrolling out of the window are counted so locations stay exact
+    for (const char* p = stream->buffer; (p = memchr(p, '\n', (size_t)(keep - p))) != NULL; p++) {
+        stream->line++;
+        stream->line_start = splice_original(&stream->splices, stream->base + (size_t)(p - stream->buffer)) + 1;
     }
 
-    if (c == '\"' || (c == 'L' && peek(lexer) == '\"')) {
-        return scan_string(lexer);
+    const size_t shift = (size_t)(keep - stream->buffer);
+    const size_t kept  = (size_t)(lexer->end - keep);
+    memmove(stream->buffer, keep, kept);
+    stream->base += shift;
+    splice_map_forget(&stream->splices, stream->base);
+
+    char* fresh = stream->buffer + kept;
+    memcpy(fresh, stream->pending, stream->pending_count);
+    assert(kept + stream->pending_count < stream->capacity);
+    const size_t wanted = stream->capacity - kept - stream->pending_count;
+    const size_t got    = read_fd(stream->fd, fresh + stream->pending_count, wanted);
+    size_t length       = stream->pending_count + got;
+    stream->eof         = got < wanted;
+
+    // a backslash ending the read may be half a splice, it waits for the next read to see the newline
+    stream->pending_count = 0;
+    if (!stream->eof && length >= 1 && fresh[length - 1] == '\\') {
+        stream->pending_count = 1;
+    } else if (!stream->eof && length >= 2 && fresh[length - 2] == '\\' && fresh[length - 1] == '\r') {
+        stream->pending_count = 2;
     }
+    length -= stream->pending_count;
+    memcpy(stream->pending, fresh + length, stream->pending_count);
+    length = splice_lines(fresh, fresh, fresh + length, stream->base + kept, &stream->splices);
+
+    lexer->current -= shift;
+    lexer->source   = stream->buffer;
+    lexer->end      = fresh + length;
+    *lexer->end     = '\0';
+}
+
+static void widen(struct mcc_lexer* lexer) {
+    struct mcc_lexer_stream* stream = lexer->stream;
 
-    if (isident_start(c)) {
-        return scan_keyword_or_identifier(lexer);
+    const ptrdiff_t current = lexer->current - stream->buffer;
+    const ptrdiff_t end     = lexer->end - stream->buffer;
+
+    char* buffer = realloc(stream->buffer, stream->capacity * 2 + 1);
+    if (!buffer) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
     }
+    stream->capacity *= 2;
+    stream->buffer    = buffer;
+    lexer->source     = buffer;
+    lexer->current    = buffer + current;
+    lexer->end        = buffer + end;
+}
 
-    return scan_punctuator(lexer);
+// refills keeping everything from keep on, widening first when that would leave less than half a window to read into
+static void advance_window(struct mcc_lexer* lexer, char* keep) {
+    struct mcc_lexer_stream* stream = lexer->stream;
+    if ((size_t)(keep - stream->buffer) < stream->capacity / 2) {
+        const ptrdiff_t at = keep - stream->buffer;
+        widen(lexer);
+        keep = stream->buffer + at;
+    }
+    refill(lexer, keep);
+}
+
+// lexing only looks at the window, a token is final once the window reaches a few bytes past it or the input ended
+static struct mcc_token lex_stream(struct mcc_lexer* lexer) {
+    struct mcc_lexer_stream* stream = lexer->stream;
+
+    for (;;) {
+        // whitespace and comments are skipped first, so the window can be topped up right before the token
+        const bool closed  = skip_blank(lexer);
+        const size_t ahead = (size_t)(lexer->end - lexer->current);
+        if (stream->eof || (closed && ahead >= stream->capacity / 2)) {
+            break;
+        }
+        if (closed && ahead >= LEXER_LOOKAHEAD) {
+            // keeping half a window ahead lexes every shorter token in one go, so a token is never interned twice
+            refill(lexer, lexer->current);
+        } else {
+            // whitespace already skipped is dropped, only a comment the window cuts off is kept to be skipped again
+            advance_window(lexer, lexer->current);
+        }
+    }
+
+    for (;;) {
+        char* start            = lexer->current;
+        struct mcc_token token = lex(lexer);
+        if (stream->eof || (size_t)(lexer->end - lexer->current) >= LEXER_LOOKAHEAD) {
+            token.offset += stream->base;
+            return token;
+        }
+
+        // the token may run on past the window, lex it again with more input behind it
+        lexer->current = start;
+        advance_window(lexer, start);
+    }
+}
+
+void mcc_lexer_create_stream(struct mcc_context* ctx, int fd, size_t window, struct mcc_lexer* lexer) {
+    assert(ctx && lexer && fd >= 0);
+    memset(lexer, 0, sizeof(*lexer));
+
+    if (window == 0) {
+        window = STREAM_DEFAULT_WINDOW;
+    } else if (window < STREAM_MIN_WINDOW) {
+        window = STREAM_MIN_WINDOW;
+    }
+
+    struct mcc_lexer_stream* stream = malloc(sizeof(*stream));
+    char* buffer                    = malloc(window + 1);
+    if (!stream || !buffer) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    *stream = (struct mcc_lexer_stream){
+        .fd       = fd,
+        .buffer   = buffer,
+        .capacity = window,
+    };
+
+    lexer->ctx     = ctx;
+    lexer->stream  = stream;
+    lexer->source  = buffer;
+    lexer->current = buffer;
+    lexer->end     = buffer;
+    refill(lexer, buffer);
+}
+
+static struct mcc_lexer_lookahead* lookahead_of(struct mcc_lexer* lexer) {
+    if (!lexer->lookahead) {
+        struct mcc_lexer_lookahead* lookahead = malloc(sizeof(*lookahead));
+        struct mcc_token* ring                = malloc(sizeof(*ring) * RING_INITIAL_CAPACITY);
+        if (!lookahead || !ring) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        *lookahead = (struct mcc_lexer_lookahead){
+            .ring     = ring,
+            .capacity = RING_INITIAL_CAPACITY,
+        };
+        lexer->lookahead = lookahead;
+    }
+    return lexer->lookahead;
+}
+
+static struct mcc_token* ring_at(const struct mcc_lexer_lookahead* lookahead, size_t index) {
+    return &lookahead->ring[index & (lookahead->capacity - 1)];
+}
+
+static void grow_ring(struct mcc_lexer_lookahead* lookahead) {
+    const size_t capacity  = lookahead->capacity * 2;
+    struct mcc_token* ring = malloc(sizeof(*ring) * capacity);
+    if (!ring) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t i = lookahead->first; i < lookahead->scanned; i++) {
+        ring[i & (capacity - 1)] = *ring_at(lookahead, i);
+    }
+    free(lookahead->ring);
+    lookahead->ring     = ring;
+    lookahead->capacity = capacity;
+}
+
+// scans until token index is in the ring, returns index or that of the EOF token if the input ends before it
+static size_t scan_ahead(struct mcc_lexer* lexer, size_t index) {
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+    while (lookahead->scanned <= index) {
+        if (lookahead->scanned > 0 && ring_at(lookahead, lookahead->scanned - 1)->type == MCC_TOKEN_TYPE_EOF) {
+            return lookahead->scanned - 1;
+        }
+        if (lookahead->scanned - lookahead->first == lookahead->capacity) {
+            grow_ring(lookahead);
+        }
+        *ring_at(lookahead, lookahead->scanned++) = lex(lexer);
+    }
+    return index;
+}
+
+// hands out buffered tokens once the lexer has looked ahead or set a mark, the EOF token is never stepped past
+static struct mcc_token next_buffered(struct mcc_lexer* lexer) {
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+
+    const struct mcc_token token = *ring_at(lookahead, scan_ahead(lexer, lookahead->next));
+    if (token.type != MCC_TOKEN_TYPE_EOF) {
+        lookahead->next++;
+    }
+    if (lookahead->mark_count == 0) {
+        lookahead->first = lookahead->next; // nothing can rewind to the token just handed out
+    }
+    return token;
+}
+
+struct mcc_token mcc_lexer_next_token(struct mcc_lexer* lexer) {
+    assert(lexer && lexer->source && lexer->current);
+    if (lexer->stream) {
+        return lex_stream(lexer);
+    }
+    if (lexer->lookahead) {
+        return next_buffered(lexer);
+    }
+    return lex(lexer);
+}
+
+struct mcc_token mcc_lexer_peek(struct mcc_lexer* lexer, size_t n) {
+    assert(lexer && lexer->source && lexer->current);
+    assert(!lexer->stream && "a streaming lexer's lexemes do not outlive the next token");
+
+    struct mcc_lexer_lookahead* lookahead = lookahead_of(lexer);
+    return *ring_at(lookahead, scan_ahead(lexer, lookahead->next + n));
+}
+
+size_t mcc_lexer_mark(struct mcc_lexer* lexer) {
+    assert(lexer && lexer->source && lexer->current);
+    assert(!lexer->stream && "a streaming lexer's lexemes do not outlive the next token");
+
+    struct mcc_lexer_lookahead* lookahead = lookahead_of(lexer);
+    if (lookahead->mark_count == lookahead->mark_capacity) {
+        const size_t capacity = lookahead->mark_capacity ? lookahead->mark_capacity * 2 : MARKS_INITIAL_CAPACITY;
+        size_t* marks         = realloc(lookahead->marks, sizeof(*marks) * capacity);
+        if (!marks) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        lookahead->marks         = marks;
+        lookahead->mark_capacity = capacity;
+    }
+    lookahead->marks[lookahead->mark_count] = lookahead->next;
+    return lookahead->mark_count++; // marks set at the same token still get their own handles
+}
+
+void mcc_lexer_rewind(struct mcc_lexer* lexer, size_t mark) {
+    assert(lexer && lexer->lookahead && "mcc_lexer_mark() was never called");
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+    assert(mark < lookahead->mark_count && "mark is not live");
+
+    lookahead->next       = lookahead->marks[mark];
+    lookahead->mark_count = mark; // marks nest, those set after this one go with it
+    lookahead->first      = lookahead->mark_count ? lookahead->marks[0] : lookahead->next;
+}
+
+void mcc_lexer_release(struct mcc_lexer* lexer, size_t mark) {
+    assert(lexer && lexer->lookahead && "mcc_lexer_mark() was never called");
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+    assert(mark < lookahead->mark_count && "mark is not live");
+
+    lookahead->mark_count = mark;
+    lookahead->first      = lookahead->mark_count ? lookahead->marks[0] : lookahead->next;
+}
+
+// typical C averages around 5 to 8 bytes per token, so an array sized from this grows at most once or twice
+static size_t estimate_tokens(size_t bytes) {
+    return bytes / 8 + 16;
+}
+
+static struct mcc_token* allocate_tokens(size_t capacity) {
+    struct mcc_token* array = malloc(sizeof(struct mcc_token) * capacity);
+    if (!array) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+static struct mcc_token* grow_tokens(struct mcc_token* array, size_t* capacity) {
+    struct mcc_token* new_array = realloc(array, sizeof(struct mcc_token) * (*capacity *= 2));
+    if (!new_array) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return new_array;
+}
+
+struct mcc_token_array mcc_lexer_tokenize_all(struct mcc_lexer* lexer) {
+    assert(lexer && lexer->source && lexer->current);
+    assert(!lexer->stream && "a streaming lexer's lexemes do not outlive the next token");
+
+    size_t capacity         = estimate_tokens((size_t)(lexer->end - lexer->current));
+    struct mcc_token* array = allocate_tokens(capacity);
+
+    // tokens already scanned by mcc_lexer_peek() come first
+    size_t size                           = 0;
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+    if (lookahead) {
+        assert(lookahead->mark_count == 0 && "a lexer drained with marks set could not rewind to them");
+        for (; lookahead->next < lookahead->scanned; lookahead->next++) {
+            if (size == capacity) {
+                array = grow_tokens(array, &capacity);
+            }
+            array[size] = *ring_at(lookahead, lookahead->next);
+            if (array[size++].type == MCC_TOKEN_TYPE_EOF) {
+                break;
+            }
+        }
+        lookahead->first = lookahead->next;
+    }
+    while (size == 0 || array[size - 1].type != MCC_TOKEN_TYPE_EOF) {
+        if (size == capacity) {
+            array = grow_tokens(array, &capacity);
+        }
+        array[size++] = lex(lexer);
+    }
+
+    mcc_context_store(lexer->ctx, array); // context owns the token array
+
+    return (struct mcc_token_array){
+        .data = array,
+        .size = size,
+    };
+}
+
+static size_t literal_chars(const struct mcc_string_literal* literal) {
+    if (literal->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING) {
+        return literal->value.wstring.size;
+    }
+    return literal->value.string.size;
+}
+
+// merges tokens[begin, end) into tokens[begin], the run is measured from the sizes its literals hold and every literal
+// is decoded from its spelling straight into one allocation of the exact size, narrow ones as wide characters if the
+// run is wide, so nothing is copied twice
+static void concatenate_run(struct mcc_lexer* lexer, struct mcc_token* tokens, size_t begin, size_t end) {
+    size_t chars = 0;
+    bool is_wide = false;
+    for (size_t i = begin; i < end; i++) {
+        is_wide = is_wide || tokens[i].value.string_literal.type == MCC_STRING_LITERAL_TYPE_WIDE_STRING;
+        chars += literal_chars(&tokens[i].value.string_literal);
+    }
+
+    const size_t char_size = is_wide ? sizeof(wchar_t) : sizeof(char);
+    char* string           = mcc_context_alloc(lexer->ctx, char_size * (chars + 1));
+    STATS_LITERAL(lexer->ctx, char_size * (chars + 1));
+
+    char* at = string;
+    for (size_t i = begin; i < end; i++) {
+        const struct mcc_string_view lexeme = tokens[i].lexeme;
+        const size_t prefix                 = lexeme.data[0] == 'L' ? 2 : 1;
+        const struct mcc_string_view body   = {lexeme.data + prefix, lexeme.size - prefix - 1}; // between the quotes
+        const size_t decoded                = decode_string(lexer->ctx, body, is_wide, at);
+        assert(decoded == literal_chars(&tokens[i].value.string_literal) && "a literal decodes to as many characters");
+        at += decoded * char_size;
+    }
+    if (is_wide) {
+        *(wchar_t*)at = 0;
+    } else {
+        *at = 0;
+    }
+
+    const struct mcc_string_view last  = tokens[end - 1].lexeme;
+    tokens[begin].lexeme               = mcc_string_view_from_ptrs(tokens[begin].lexeme.data, last.data + last.size);
+    tokens[begin].value.string_literal = (struct mcc_string_literal){
+        .type  = is_wide ? MCC_STRING_LITERAL_TYPE_WIDE_STRING : MCC_STRING_LITERAL_TYPE_STRING,
+        .value = {{string, chars}},
+    };
+}
+
+struct mcc_token_array mcc_lexer_concatenate_strings(struct mcc_lexer* lexer, struct mcc_token_array tokens) {
+    assert(lexer && (tokens.data || tokens.size == 0));
+
+    size_t size = 0;
+    for (size_t i = 0; i < tokens.size;) {
+        size_t end = i + 1;
+        if (tokens.data[i].type == MCC_TOKEN_TYPE_STRING_LITERAL) {
+            while (end < tokens.size && tokens.data[end].type == MCC_TOKEN_TYPE_STRING_LITERAL) {
+                end++;
+            }
+            if (end - i > 1) {
+                concatenate_run(lexer, tokens.data, i, end);
+            }
+        }
+        tokens.data[size++] = tokens.data[i];
+        i                   = end;
+    }
+
+    return (struct mcc_token_array){
+        .data = tokens.data,
+        .size = size,
+    };
+}
+
+#define PARALLEL_MIN_CHUNK         (64 * 1024) // smaller chunks cost more in thread handoff than they save
+#define PARALLEL_CHUNKS_PER_THREAD 4           // spare chunks keep threads busy when some chunks lex slower
+
+struct lex_chunk {
+    size_t begin;             // offset of the chunk's first byte, always the start of a line
+    size_t end;               // offset of the next chunk's first byte
+    struct mcc_context* ctx;  // private to the worker, symbols are renumbered and memory absorbed on merge
+    struct mcc_token* tokens; // tokens starting in [begin, end), ending with EOF if the chunk reached it
+    size_t size;
+    size_t next_offset; // offset of the first token at or past end, where the next chunk should pick up
+};
+
+struct lex_pool {
+    char* source;
+    char* end;
+    struct lex_chunk* chunks;
+};
+
+// the worker lexes as if the whole source started at its chunk, lexing is a function of the position alone so its
+// tokens match the sequential ones from the first token both streams share
+static void lex_chunk(const struct lex_pool* pool, struct lex_chunk* chunk) {
+    struct mcc_lexer lexer = {
+        .ctx     = chunk->ctx,
+        .source  = pool->source,
+        .current = pool->source + chunk->begin,
+        .end     = pool->end,
+    };
+
+    size_t capacity = estimate_tokens(chunk->end - chunk->begin);
+    chunk->tokens   = allocate_tokens(capacity);
+    chunk->size     = 0;
+
+    for (;;) {
+        const struct mcc_token token = lex(&lexer);
+        chunk->next_offset           = token.offset;
+        if (token.type != MCC_TOKEN_TYPE_EOF && token.offset >= chunk->end) {
+            break;
+        }
+        if (chunk->size == capacity) {
+            chunk->tokens = grow_tokens(chunk->tokens, &capacity);
+        }
+        chunk->tokens[chunk->size++] = token;
+        if (token.type == MCC_TOKEN_TYPE_EOF) {
+            break;
+        }
+    }
+}
+
+static void lex_worker(void* arg, size_t chunk) {
+    const struct lex_pool* pool = arg;
+    lex_chunk(pool, &pool->chunks[chunk]);
+}
+
+// cuts [begin, length) into at most count chunks of about equal size, each starting right after a newline
+static size_t split_chunks(const char* source, size_t begin, size_t length, size_t count, struct lex_chunk* chunks) {
+    const size_t target = (length - begin) / count;
+
+    size_t n = 0;
+    for (size_t start = begin; start < length; n++) {
+        chunks[n].begin = start;
+
+        const char* newline = NULL;
+        if (n + 1 < count && start + target < length) {
+            newline = memchr(source + start + target, '\n', length - start - target);
+        }
+        start         = newline ? (size_t)(newline - source) + 1 : length;
+        chunks[n].end = start;
+    }
+    return n;
+}
+
+// binary search, chunk tokens are sorted by offset
+static size_t find_token(const struct lex_chunk* chunk, size_t offset) {
+    size_t lo = 0;
+    size_t hi = chunk->size;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (chunk->tokens[mid].offset < offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < chunk->size && chunk->tokens[lo].offset == offset ? lo : SIZE_MAX;
+}
+
+struct token_list {
+    struct mcc_token* data;
+    size_t size;
+    size_t capacity;
+};
+
+static void push_token(struct token_list* list, struct mcc_token token) {
+    if (list->size == list->capacity) {
+        list->data = grow_tokens(list->data, &list->capacity);
+    }
+    list->data[list->size++] = token;
+}
+
+// appends a chunk's tokens from index from on, renumbering identifiers in order of appearance as the sequential
+// lexer would have, returns true if the EOF token was appended
+static bool adopt_tokens(struct mcc_context* ctx,
+                         const struct lex_chunk* chunk,
+                         size_t from,
+                         uint32_t* remap,
+                         struct token_list* out) {
+    for (size_t i = from; i < chunk->size; i++) {
+        struct mcc_token token = chunk->tokens[i];
+        if (token.type == MCC_TOKEN_TYPE_IDENTIFIER) {
+            const uint32_t local = token.value.identifier;
+            if (remap[local] == UINT32_MAX) {
+                const struct mcc_string_view name = mcc_context_symbol_name(chunk->ctx, local);
+                remap[local]                      = mcc_context_intern(ctx, name.data, name.size);
+            }
+            token.value.identifier = remap[local];
+        }
+        push_token(out, token);
+        if (token.type == MCC_TOKEN_TYPE_EOF) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// walks the chunks in order, a chunk whose first token is not where the sequential stream continues started inside a
+// token (a string, character constant or comment running across its first line) and is relexed sequentially until
+// the two streams meet on a common token offset
+static struct mcc_token_array merge_chunks(struct mcc_lexer* lexer, struct lex_chunk* chunks, size_t count) {
+    size_t total = 16;
+    for (size_t i = 0; i < count; i++) {
+        total += chunks[i].size;
+    }
+    struct token_list out = {allocate_tokens(total), 0, total};
+
+    size_t next = chunks[0].begin; // where the sequential stream continues
+    bool done   = false;
+    for (size_t i = 0; i < count && !done; i++) {
+        struct lex_chunk* chunk = &chunks[i];
+
+        const size_t symbol_count = mcc_context_symbol_count(chunk->ctx);
+        uint32_t* remap           = malloc(sizeof(uint32_t) * (symbol_count ? symbol_count : 1));
+        if (!remap) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        memset(remap, 0xFF, sizeof(uint32_t) * symbol_count);
+
+        const size_t first = chunk->size ? chunk->tokens[0].offset : chunk->next_offset;
+        if (next == chunk->begin || next == first) {
+            done = adopt_tokens(lexer->ctx, chunk, 0, remap, &out);
+            next = chunk->next_offset;
+        } else {
+            lexer->current = lexer->source + next;
+            for (;;) {
+                const struct mcc_token token = lex(lexer);
+                if (token.type == MCC_TOKEN_TYPE_EOF) {
+                    push_token(&out, token);
+                    done = true;
+                    break;
+                }
+                if (token.offset >= chunk->end) {
+                    next = token.offset;
+                    break;
+                }
+                const size_t match = find_token(chunk, token.offset);
+                if (match != SIZE_MAX) {
+                    done = adopt_tokens(lexer->ctx, chunk, match, remap, &out);
+                    next = chunk->next_offset;
+                    break;
+                }
+                push_token(&out, token);
+            }
+        }
+        free(remap);
+    }
+    assert(done && out.data[out.size - 1].type == MCC_TOKEN_TYPE_EOF);
+
+    lexer->current = lexer->source + out.data[out.size - 1].offset;
+    mcc_context_store(lexer->ctx, out.data); // context owns the token array
+
+    return (struct mcc_token_array){
+        .data = out.data,
+        .size = out.size,
+    };
+}
+
+struct mcc_token_array mcc_lexer_tokenize_parallel(struct mcc_lexer* lexer, size_t threads) {
+    assert(lexer && lexer->source && lexer->current);
+    assert(!lexer->stream && "a streaming lexer's lexemes do not outlive the next token");
+    assert((!lexer->lookahead || lexer->lookahead->next == lexer->lookahead->scanned) &&
+           "tokens peeked ahead would be lexed again");
+
+    if (threads == 0) {
+        threads = thread_hardware_concurrency();
+    }
+    const size_t begin  = (size_t)(lexer->current - lexer->source);
+    const size_t length = (size_t)(lexer->end - lexer->source);
+
+    size_t count = threads * PARALLEL_CHUNKS_PER_THREAD;
+    if (count > (length - begin) / PARALLEL_MIN_CHUNK) {
+        count = (length - begin) / PARALLEL_MIN_CHUNK;
+    }
+    if (threads < 2 || count < 2) {
+        return mcc_lexer_tokenize_all(lexer);
+    }
+
+    struct lex_chunk* chunks = malloc(sizeof(*chunks) * count);
+    if (!chunks) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    count = split_chunks(lexer->source, begin, length, count, chunks);
+    for (size_t i = 0; i < count; i++) {
+        chunks[i].ctx = mcc_context_create();
+    }
+
+    struct lex_pool pool = {
+        .source = lexer->source,
+        .end    = lexer->end,
+        .chunks = chunks,
+    };
+    pool_run(count, threads, lex_worker, &pool);
+
+    const struct mcc_token_array tokens = merge_chunks(lexer, chunks, count);
+
+    // string literal data lives in the chunk contexts
+    for (size_t i = 0; i < count; i++) {
+        free(chunks[i].tokens);
+        mcc_context_absorb(lexer->ctx, chunks[i].ctx);
+    }
+    free(chunks);
+    return tokens;
+}
+
+// replaces [offset, offset + removed) of the source with text, moving the source into the lexer's own buffer
+static void apply_edit(struct mcc_lexer* lexer, size_t offset, size_t removed, const char* text, size_t length) {
+    struct mcc_lexer_edits* edits = lexer->edits;
+
+    const size_t old_length = (size_t)(lexer->end - lexer->source);
+    const size_t new_length = old_length - removed + length;
+    const size_t tail       = old_length - offset - removed;
+
+    if (lexer->source == edits->source && new_length <= edits->capacity) {
+        memmove(edits->source + offset + length, edits->source + offset + removed, tail);
+        memcpy(edits->source + offset, text, length);
+    } else {
+        size_t capacity = edits->capacity * 2;
+        if (capacity < new_length) {
+            capacity = new_length + new_length / 2;
+        }
+        char* source = malloc(capacity + 1);
+        if (!source) {
+            perror("malloc");
+            exit(EXIT_FAILURE);
+        }
+        memcpy(source, lexer->source, offset);
+        memcpy(source + offset, text, length);
+        memcpy(source + offset + length, lexer->source + offset + removed, tail);
+
+        free(edits->source);
+        edits->source   = source;
+        edits->capacity = capacity;
+    }
+
+    lexer->source = edits->source;
+    lexer->end    = edits->source + new_length;
+    *lexer->end   = '\0';
+
+    free(lexer->line_starts); // rebuilt on the next mcc_lexer_location()
+    lexer->line_starts = NULL;
+    lexer->line_count  = 0;
+}
+
+// widens an edit over a backslash before it and the line break after it and splices the text it inserts, returns the
+// spliced text or NULL when the edit cannot form a splice
+static char* splice_edit(const struct mcc_lexer* lexer,
+                         size_t* offset,
+                         size_t* removed,
+                         const char** text,
+                         size_t* length,
+                         struct splice_map* inserted) {
+    const char* source = lexer->source;
+    const size_t size  = (size_t)(lexer->end - lexer->source);
+
+    size_t before = 0;
+    if (*offset >= 1 && source[*offset - 1] == '\\') {
+        before = 1;
+    } else if (*offset >= 2 && source[*offset - 2] == '\\' && source[*offset - 1] == '\r') {
+        before = 2;
+    }
+    if (!before && (*length == 0 || !memchr(*text, '\\', *length))) {
+        return NULL;
+    }
+
+    const size_t lo    = *offset - before;
+    const size_t hi    = *offset + *removed;
+    const size_t after = size - hi < 2 ? size - hi : 2;
+
+    char* spliced = malloc(before + *length + after + 1);
+    if (!spliced) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(spliced, source + lo, before);
+    if (*length) {
+        memcpy(spliced + before, *text, *length);
+    }
+    memcpy(spliced + before + *length, source + hi, after);
+
+    *length  = splice_lines(spliced, spliced, spliced + before + *length + after, lo, inserted);
+    *offset  = lo;
+    *removed = hi + after - lo;
+    *text    = spliced;
+    return spliced;
+}
+
+// first token whose bytes or lookahead reach offset, every token before it lexes the same after the edit
+static size_t first_affected(struct mcc_token_array tokens, size_t offset) {
+    size_t lo = 0;
+    size_t hi = tokens.size - 1; // the EOF token sees every edit
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (tokens.data[mid].offset + tokens.data[mid].lexeme.size + LEXER_LOOKAHEAD > offset) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+// points a kept token at its offset in the edited source, a string literal lexed in place moves with its lexeme
+static void rebase_token(struct mcc_token* token, char* source) {
+    struct mcc_string_literal* literal = &token->value.string_literal;
+    const char* old_lexeme             = token->lexeme.data;
+    token->lexeme.data                 = source + token->offset;
+    if (token->type == MCC_TOKEN_TYPE_STRING_LITERAL && literal->type == MCC_STRING_LITERAL_TYPE_STRING &&
+        literal->value.string.data == old_lexeme + 1) {
+        literal->value.string.data = token->lexeme.data + 1;
+    }
+}
+
+struct mcc_token_array mcc_lexer_relex(struct mcc_lexer* lexer,
+                                       struct mcc_token_array tokens,
+                                       size_t offset,
+                                       size_t removed,
+                                       const char* text,
+                                       size_t length) {
+    assert(lexer && lexer->source && !lexer->stream);
+    assert(tokens.size > 0 && tokens.data[tokens.size - 1].type == MCC_TOKEN_TYPE_EOF);
+    assert(offset <= (size_t)(lexer->end - lexer->source));
+    assert(removed <= (size_t)(lexer->end - lexer->source) - offset);
+    assert(text || length == 0);
+
+    if (!lexer->edits) {
+        lexer->edits = calloc(1, sizeof(struct mcc_lexer_edits));
+        if (!lexer->edits) {
+            perror("calloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    struct mcc_lexer_edits* edits = lexer->edits;
+
+    // the source stays spliced, a splice the edit brings in or completes is removed as part of the edit
+    struct splice_map inserted;
+    splice_map_create(&inserted);
+    char* spliced = splice_edit(lexer, &offset, &removed, &text, &length, &inserted);
+
+    const size_t first = first_affected(tokens, offset);
+    const size_t start = first ? tokens.data[first - 1].offset + tokens.data[first - 1].lexeme.size : 0;
+
+    const char* old_source = lexer->source;
+    apply_edit(lexer, offset, removed, text, length);
+    if (inserted.count || lexer->splices) {
+        splice_map_replace(splice_map_of(lexer), offset, removed, &inserted, length);
+    }
+    splice_map_destroy(&inserted);
+    free(spliced);
+
+    // relex until a token starts past the edit where an old token started, from there on the text and therefore the
+    // tokens are the same as before, only shifted
+    struct token_list relexed = {allocate_tokens(16), 0, 16};
+    size_t resync             = first;
+    lexer->current            = lexer->source + start;
+    for (;;) {
+        const struct mcc_token token = lex(lexer);
+        if (token.offset >= offset + length) {
+            const size_t old_offset = token.offset - length + removed;
+            while (resync < tokens.size && tokens.data[resync].offset < old_offset) {
+                resync++;
+            }
+            if (resync < tokens.size && tokens.data[resync].offset == old_offset) {
+                break;
+            }
+        }
+        push_token(&relexed, token);
+        if (token.type == MCC_TOKEN_TYPE_EOF) {
+            resync = tokens.size;
+            break;
+        }
+    }
+
+    // splice: tokens [0, first) stay, [first, resync) are replaced by the relexed ones, [resync, size) shift
+    const size_t kept_tail = tokens.size - resync;
+    const size_t size      = first + relexed.size + kept_tail;
+    if (tokens.data == edits->tokens) {
+        if (size > edits->token_capacity) {
+            edits->token_capacity = size + size / 2;
+            edits->tokens         = realloc(edits->tokens, sizeof(struct mcc_token) * edits->token_capacity);
+            if (!edits->tokens) {
+                perror("realloc");
+                exit(EXIT_FAILURE);
+            }
+        }
+        memmove(edits->tokens + first + relexed.size, edits->tokens + resync, sizeof(struct mcc_token) * kept_tail);
+    } else {
+        struct mcc_token* array = allocate_tokens(size + size / 2);
+        memcpy(array, tokens.data, sizeof(struct mcc_token) * first);
+        memcpy(array + first + relexed.size, tokens.data + resync, sizeof(struct mcc_token) * kept_tail);
+
+        free(edits->tokens);
+        edits->tokens         = array;
+        edits->token_capacity = size + size / 2;
+    }
+    memcpy(edits->tokens + first, relexed.data, sizeof(struct mcc_token) * relexed.size);
+    free(relexed.data);
+
+    // lexemes point into the source, which may have moved
+    if (lexer->source != old_source) {
+        for (size_t i = 0; i < first; i++) {
+            rebase_token(&edits->tokens[i], lexer->source);
+        }
+    }
+    for (size_t i = first + relexed.size; i < size; i++) {
+        edits->tokens[i].offset = edits->tokens[i].offset - removed + length;
+        rebase_token(&edits->tokens[i], lexer->source);
+    }
+
+    lexer->current = lexer->source + edits->tokens[size - 1].offset;
+
+    // tokens looked at before the edit are stale, and checkpoints would rewind into the old source
+    struct mcc_lexer_lookahead* lookahead = lexer->lookahead;
+    if (lookahead) {
+        lookahead->first      = 0;
+        lookahead->next       = 0;
+        lookahead->scanned    = 0;
+        lookahead->mark_count = 0;
+    }
+
+    return (struct mcc_token_array){
+        .data = edits->tokens,
+        .size = size,
+    };
+}
+
+static void build_line_index(struct mcc_lexer* lexer) {
+    // count first so the index is allocated exactly once
+    const size_t line_count = count_byte(lexer->source, lexer->end, '\n') + 1;
+
+    lexer->line_starts = malloc(sizeof(size_t) * line_count);
+    if (!lexer->line_starts) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    size_t n                = 0;
+    lexer->line_starts[n++] = 0;
+    for (const char* p = lexer->source; (p = memchr(p, '\n', (size_t)(lexer->end - p))) != NULL; p++) {
+        lexer->line_starts[n++] = (size_t)(p + 1 - lexer->source);
+    }
+    assert(n == line_count);
+    lexer->line_count = line_count;
+}
+
+// a streaming lexer only has the window, lines before it are counted as they scroll out
+static struct mcc_source_location stream_location(const struct mcc_lexer* lexer, size_t offset) {
+    const struct mcc_lexer_stream* stream = lexer->stream;
+    assert(offset >= stream->base && offset - stream->base <= (size_t)(lexer->end - stream->buffer));
+
+    size_t line       = stream->line;
+    size_t line_start = stream->line_start;
+
+    const char* end = stream->buffer + (offset - stream->base);
+    for (const char* p = stream->buffer; (p = memchr(p, '\n', (size_t)(end - p))) != NULL; p++) {
+        line++;
+        line_start = splice_original(&stream->splices, stream->base + (size_t)(p - stream->buffer)) + 1;
+    }
+
+    // each splice removed a line break too
+    size_t splice_start;
+    line += splice_count(&stream->splices, offset, &splice_start);
+    if (splice_start > line_start) {
+        line_start = splice_start;
+    }
+
+    return (struct mcc_source_location){
+        .line   = line,
+        .column = splice_original(&stream->splices, offset) - line_start,
+    };
+}
+
+struct mcc_source_location mcc_lexer_location(struct mcc_lexer* lexer, size_t offset) {
+    assert(lexer && lexer->source);
+    if (lexer->stream) {
+        return stream_location(lexer, offset);
+    }
+    assert(offset <= (size_t)(lexer->end - lexer->source));
+
+    if (!lexer->line_starts) {
+        build_line_index(lexer);
+    }
+
+    // find the last line starting at or before offset
+    size_t lo = 0;
+    size_t hi = lexer->line_count;
+    while (hi - lo > 1) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (lexer->line_starts[mid] <= offset) {
+            lo = mid;
+        } else {
+            hi = mid;
+        }
+    }
+
+    if (!lexer->splices) {
+        return (struct mcc_source_location){
+            .line   = lo,
+            .column = offset - lexer->line_starts[lo],
+        };
+    }
+
+    // lines and columns count in the text as written, with the splices put back
+    const struct splice_map* map = &lexer->splices->map;
+    size_t splice_start;
+    const size_t splices = splice_count(map, offset, &splice_start);
+    const size_t start   = lo ? splice_original(map, lexer->line_starts[lo] - 1) + 1 : 0;
+
+    return (struct mcc_source_location){
+        .line   = lo + splices,
+        .column = splice_original(map, offset) - (splice_start > start ? splice_start : start),
+    };
 }
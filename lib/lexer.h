@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <stdint.h>
 #include "context.h"
 #include "defs.h"
 
@@ -91,6 +92,9 @@ enum mcc_string_literal_type {
     MCC_STRING_LITERAL_TYPE_WIDE_STRING,
 };
 
+/// @brief Characters of a string literal, their count excludes any terminator.
+/// @note A narrow literal without escape sequences is not copied, it points just past its opening quote in the source
+///       and is followed by its closing quote. Every other literal is decoded into a copy followed by a null character.
 union mcc_string_literal_value {
     struct mcc_string_view string;
     struct mcc_wstring_view wstring;
@@ -165,7 +169,7 @@ enum mcc_token_type {
 
 union mcc_token_value {
     enum mcc_keyword keyword;
-    struct mcc_string_view identifier;
+    uint32_t identifier; // symbol from mcc_context_intern(), the name is the token's lexeme
     struct mcc_constant constant;
     struct mcc_string_literal string_literal;
     enum mcc_punctuator punctuator;
@@ -174,18 +178,46 @@ union mcc_token_value {
 
 struct mcc_token {
     enum mcc_token_type type;
+    size_t offset; // byte offset of the lexeme in the spliced source, see mcc_lexer_location()
     union mcc_token_value value;
     struct mcc_string_view lexeme;
+};
+
+/// @brief A contiguous, context-owned array of tokens.
+struct mcc_token_array {
+    struct mcc_token* data; ///< Pointer to the first token.
+    size_t size;            ///< Number of tokens, including the trailing EOF token.
+};
+
+/// @brief A zero-based line and column in the source text.
+struct mcc_source_location {
     size_t line;
     size_t column;
 };
 
+/// @brief Input window of a lexer created with mcc_lexer_create_stream().
+struct mcc_lexer_stream;
+
+/// @brief Edited source and token array of a lexer that mcc_lexer_relex() was called on.
+struct mcc_lexer_edits;
+
+/// @brief Line splices removed from the source of a lexer, see lib/private/splice.h.
+struct mcc_lexer_splices;
+
+/// @brief Tokens a lexer scanned ahead with mcc_lexer_peek() or kept for mcc_lexer_rewind().
+struct mcc_lexer_lookahead;
+
 struct mcc_lexer {
     struct mcc_context* ctx;
     char* source;
     char* current;
-    size_t line;
-    size_t column;
+    char* end;           // points at the null terminator
+    size_t* line_starts; // offset of the first character of each line, built on first mcc_lexer_location()
+    size_t line_count;
+    struct mcc_lexer_stream* stream;       // NULL unless created with mcc_lexer_create_stream()
+    struct mcc_lexer_edits* edits;         // NULL until the first mcc_lexer_relex()
+    struct mcc_lexer_splices* splices;     // NULL unless the source has line splices
+    struct mcc_lexer_lookahead* lookahead; // NULL until the first mcc_lexer_peek() or mcc_lexer_mark()
 };
 
 /// @brief Initializes a lexer with the given source text and its length.
@@ -193,8 +225,32 @@ struct mcc_lexer {
 /// @param source Pointer to the source text to be lexed.
 /// @param length Length of the source text in bytes (excluding NULL terminator).
 /// @param lexer Pointer to the lexer structure to initialize.
+/// @note Line splices (a backslash ending a line) are removed as the source is copied, the lexer and its token offsets
+///       work on the spliced text.
 void mcc_lexer_create(struct mcc_context* ctx, const char* source, size_t length, struct mcc_lexer* lexer);
 
+/// @brief Initializes a lexer that lexes a buffer in place instead of copying it.
+/// @param ctx MCC context
+/// @param source Pointer to the source text, source[length] must be '\0'. It must outlive every token produced by the
+///               lexer, e.g. a buffer returned by mcc_context_map_file().
+/// @param length Length of the source text in bytes (excluding NULL terminator).
+/// @param lexer Pointer to the lexer structure to initialize.
+/// @note A source with line splices is copied into the context with them removed, any other source is lexed in place.
+void mcc_lexer_create_borrowed(struct mcc_context* ctx, char* source, size_t length, struct mcc_lexer* lexer);
+
+/// @brief Initializes a lexer that reads its source from a file descriptor through a fixed-size window.
+/// @param ctx MCC context
+/// @param fd File descriptor to read from, e.g. a pipe or standard input. It is not closed by the lexer.
+/// @param window Size of the input window in bytes, 0 picks a default of 64 KiB. Windows below 4 KiB are enlarged.
+/// @param lexer Pointer to the lexer structure to initialize.
+/// @note Memory stays constant however long the input is, except that a single token or comment longer than half the
+///       window (a huge string literal, say) widens the window to fit it. Line splices are removed as input is read
+///       and token offsets count from the start of the spliced stream. Lexemes point into the window and are only
+///       valid until the next mcc_lexer_next_token() call, decoded values such as string literals live in the context
+///       as usual. Only mcc_lexer_next_token() can drain a streaming lexer, and mcc_lexer_location() only knows offsets
+///       still in the window, e.g. those of the last token.
+void mcc_lexer_create_stream(struct mcc_context* ctx, int fd, size_t window, struct mcc_lexer* lexer);
+
 /// @brief Destroys a lexer object and releases any resources associated with it.
 /// @param lexer Pointer to the lexer object to be destroyed.
 void mcc_lexer_destroy(struct mcc_lexer* lexer);
@@ -203,3 +259,84 @@ void mcc_lexer_destroy(struct mcc_lexer* lexer);
 /// @param lexer Pointer to the lexer from which to retrieve the next token.
 /// @return The next token from the lexer. If the end of the input is reached, MCC_TOKEN_TYPE_EOF is returned.
 struct mcc_token mcc_lexer_next_token(struct mcc_lexer* lexer);
+
+/// @brief Looks at a token ahead of the lexer without consuming it.
+/// @param lexer Pointer to a lexer that is not streaming.
+/// @param n Number of tokens to look past, 0 is the token the next mcc_lexer_next_token() call returns.
+/// @return The token, or the EOF token if the input ends before it.
+/// @note Tokens scanned to look ahead wait in a ring buffer until mcc_lexer_next_token() or mcc_lexer_tokenize_all()
+///       hands them out, so each token is scanned and decoded once however far ahead it was seen.
+struct mcc_token mcc_lexer_peek(struct mcc_lexer* lexer, size_t n);
+
+/// @brief Sets a checkpoint in the token stream to backtrack to.
+/// @param lexer Pointer to a lexer that is not streaming.
+/// @return The checkpoint, for mcc_lexer_rewind() or mcc_lexer_release(). It is the checkpoint's nesting depth rather
+///         than a token index, so checkpoints set at the same token are told apart.
+/// @note Tokens handed out after the oldest live checkpoint stay in the ring buffer, so rewinding never scans them
+///       again. Checkpoints nest: each is given back exactly once, and giving one back drops those set after it.
+size_t mcc_lexer_mark(struct mcc_lexer* lexer);
+
+/// @brief Returns to a checkpoint, the next token is the one that came next when it was set.
+/// @param lexer Pointer to the lexer.
+/// @param mark Checkpoint from mcc_lexer_mark(), it is dropped.
+void mcc_lexer_rewind(struct mcc_lexer* lexer, size_t mark);
+
+/// @brief Drops a checkpoint without returning to it, e.g. once the tokens after it are parsed for good.
+/// @param lexer Pointer to the lexer.
+/// @param mark Checkpoint from mcc_lexer_mark().
+void mcc_lexer_release(struct mcc_lexer* lexer, size_t mark);
+
+/// @brief Lexes all remaining input in one pass into a contiguous token array.
+/// @param lexer Pointer to the lexer to drain.
+/// @return The tokens up to and including the EOF token. The array is owned by the lexer's context and stays valid
+///         until mcc_context_destroy(), so it can be indexed, rewound and looked ahead freely.
+struct mcc_token_array mcc_lexer_tokenize_all(struct mcc_lexer* lexer);
+
+/// @brief Lexes all remaining input like mcc_lexer_tokenize_all(), splitting it across worker threads.
+/// @param lexer Pointer to the lexer to drain.
+/// @param threads Number of threads to lex on, the calling thread included. 0 uses one per online processor.
+/// @return The same tokens mcc_lexer_tokenize_all() returns, offsets, lexemes and symbols included.
+/// @note The input is cut at line starts into chunks of at least 64 KiB, smaller inputs are lexed sequentially. A cut
+///       that lands inside a token is detected when the previous chunk's tokens do not end on it, and the tokens
+///       around it are lexed again sequentially.
+struct mcc_token_array mcc_lexer_tokenize_parallel(struct mcc_lexer* lexer, size_t threads);
+
+/// @brief Concatenates each run of adjacent string literal tokens into a single token, translation phase 6.
+/// @param lexer Pointer to the lexer that produced the tokens.
+/// @param tokens Tokens from mcc_lexer_tokenize_all() or mcc_lexer_tokenize_parallel(), rewritten in place.
+/// @return The same array without the tokens merged away. A merged token's lexeme spans its literals and whatever lies
+///         between them, its value is one null-terminated literal that is wide if any literal of the run is.
+/// @note A run is measured from the sizes its literals already hold, and each literal is decoded from its spelling
+///       straight into one allocation of exactly that size. The rewritten array can no longer be passed to
+///       mcc_lexer_relex().
+struct mcc_token_array mcc_lexer_concatenate_strings(struct mcc_lexer* lexer, struct mcc_token_array tokens);
+
+/// @brief Applies an edit to the lexer's source and updates its tokens, relexing only the tokens the edit can change.
+/// @param lexer Pointer to the lexer that produced the tokens.
+/// @param tokens Tokens of the whole source, from mcc_lexer_tokenize_all() on a new lexer or the last
+///               mcc_lexer_relex().
+/// @param offset Byte offset of the edit in the current source, the spliced text token offsets refer to.
+/// @param removed Number of bytes the edit removes at offset.
+/// @param text Replacement text inserted at offset, need not be null-terminated and must not point into the source.
+/// @param length Length of the replacement text.
+/// @return The tokens of the edited source, owned by the lexer and valid until the next mcc_lexer_relex() or
+///         mcc_lexer_destroy().
+/// @note Relexing starts at the first token that the edit or the lexer's lookahead reaches and stops at the first
+///       token after the edit that starts where an old token started, later tokens are kept and shifted. The lexer
+///       works on its own copy of the source from the first edit on, so a borrowed or mapped source is never written.
+///       Identifiers new to the source get new symbols, so symbol numbers can differ from lexing the edited source
+///       afresh. Line splices the edit inserts or completes are removed, the edit is widened over them. Tokens peeked
+///       and checkpoints set before the edit are dropped.
+struct mcc_token_array mcc_lexer_relex(struct mcc_lexer* lexer,
+                                       struct mcc_token_array tokens,
+                                       size_t offset,
+                                       size_t removed,
+                                       const char* text,
+                                       size_t length);
+
+/// @brief Maps a byte offset in the lexer's source to a line and column.
+/// @param lexer Pointer to the lexer that produced the offset.
+/// @param offset Byte offset into the spliced source, e.g. mcc_token::offset.
+/// @return The zero-based line and column of the offset in the text as written, line splices included.
+/// @note The line index is only built on the first call, lexing itself never tracks lines.
+struct mcc_source_location mcc_lexer_location(struct mcc_lexer* lexer, size_t offset);
@@ -0,0 +1,113 @@
+#include "arena.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// every allocation is aligned for the strictest basic type
+union arena_align {
+    long double ld;
+    long long ll;
+    double d;
+    void* p;
+};
+
+#define ARENA_ALIGNMENT sizeof(union arena_align)
+
+#define ALIGN_UP(_Size) (((_Size) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+struct arena_chunk {
+    struct arena_chunk* next;
+    size_t size; // usable bytes after the header
+    size_t used;
+};
+
+#define CHUNK_HEADER_SIZE ALIGN_UP(sizeof(struct arena_chunk))
+
+static char* chunk_data(struct arena_chunk* chunk) {
+    return (char*)chunk + CHUNK_HEADER_SIZE;
+}
+
+static struct arena_chunk* chunk_create(size_t size) {
+    struct arena_chunk* chunk = malloc(CHUNK_HEADER_SIZE + size);
+    if (!chunk) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void arena_create(struct arena* arena) {
+    assert(arena);
+    arena->head       = NULL;
+    arena->last_chunk = NULL;
+    arena->last       = NULL;
+}
+
+void arena_destroy(struct arena* arena) {
+    assert(arena);
+    for (struct arena_chunk* chunk = arena->head; chunk;) {
+        struct arena_chunk* next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena_create(arena);
+}
+
+void* arena_alloc(struct arena* arena, size_t size) {
+    assert(arena);
+    size = ALIGN_UP(size);
+
+    struct arena_chunk* chunk = arena->head;
+    if (size > ARENA_CHUNK_SIZE / 4) {
+        // dedicated chunk, linked behind the head so the head keeps serving small allocations
+        chunk = chunk_create(size);
+        if (arena->head) {
+            chunk->next       = arena->head->next;
+            arena->head->next = chunk;
+        } else {
+            arena->head = chunk;
+        }
+    } else if (!chunk || chunk->size - chunk->used < size) {
+        chunk       = chunk_create(ARENA_CHUNK_SIZE);
+        chunk->next = arena->head;
+        arena->head = chunk;
+    }
+
+    char* ptr = chunk_data(chunk) + chunk->used;
+    chunk->used += size;
+
+    arena->last_chunk = chunk;
+    arena->last       = ptr;
+    return ptr;
+}
+
+void arena_absorb(struct arena* arena, struct arena* other) {
+    assert(arena && other && arena != other);
+    if (!other->head) {
+        return;
+    }
+
+    struct arena_chunk* tail = other->head;
+    while (tail->next) {
+        tail = tail->next;
+    }
+    if (arena->head) {
+        tail->next        = arena->head->next;
+        arena->head->next = other->head;
+    } else {
+        arena->head = other->head;
+    }
+    arena_create(other);
+}
+
+void arena_trim(struct arena* arena, void* ptr, size_t size) {
+    assert(arena && ptr == arena->last && "only the most recent allocation can be trimmed");
+    struct arena_chunk* chunk = arena->last_chunk;
+    const size_t offset       = (size_t)((char*)ptr - chunk_data(chunk));
+    assert(offset + ALIGN_UP(size) <= chunk->used && "trim cannot grow an allocation");
+    chunk->used = offset + ALIGN_UP(size);
+}
@@ -0,0 +1,48 @@
+/// @file lib/private/arena.h
+/// @brief Chunked bump allocator.
+///
+/// Allocations are carved sequentially out of large chunks and are never freed individually, the whole arena is
+/// released at once with arena_destroy(). Requests larger than a quarter of a chunk get a dedicated chunk so they do
+/// not waste the tail of the current one.
+
+#pragma once
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE (64 * 1024) ///< Usable bytes in a regular chunk.
+
+struct arena_chunk;
+
+struct arena {
+    struct arena_chunk* head;       // chunk small allocations are bumped from, followed by all older chunks
+    struct arena_chunk* last_chunk; // chunk holding the most recent allocation
+    char* last;                     // most recent allocation, the only one arena_trim() accepts
+};
+
+/// @brief Initializes an empty arena, no memory is allocated until the first arena_alloc().
+/// @param arena Pointer to the arena to initialize.
+void arena_create(struct arena* arena);
+
+/// @brief Releases every chunk owned by the arena.
+/// @param arena Pointer to the arena to destroy.
+/// @note All pointers returned by arena_alloc() become invalid.
+void arena_destroy(struct arena* arena);
+
+/// @brief Allocates memory from the arena.
+/// @param arena Pointer to the arena.
+/// @param size Number of bytes to allocate.
+/// @return A pointer suitably aligned for any type. Never returns NULL; exits on allocation failure.
+void* arena_alloc(struct arena* arena, size_t size);
+
+/// @brief Moves every chunk of one arena into another, leaving the source empty.
+/// @param arena Pointer to the arena taking over the chunks.
+/// @param other Pointer to the arena giving them up.
+/// @note Pointers into either arena stay valid. The chunks are linked behind the head, so the most recent allocation of
+/// @p arena can still be trimmed.
+void arena_absorb(struct arena* arena, struct arena* other);
+
+/// @brief Shrinks the most recent allocation, returning its tail to the arena.
+/// @param arena Pointer to the arena.
+/// @param ptr The pointer returned by the most recent arena_alloc().
+/// @param size The new size, must not exceed the size it was allocated with.
+void arena_trim(struct arena* arena, void* ptr, size_t size);
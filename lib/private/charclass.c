@@ -0,0 +1,29 @@
+#include "charclass.h"
+
+#define NO 0
+#define WS CHAR_SPACE
+#define OC (CHAR_IDENT | CHAR_DIGIT | CHAR_XDIGIT | CHAR_ODIGIT)
+#define DE (CHAR_IDENT | CHAR_DIGIT | CHAR_XDIGIT)
+#define HX (CHAR_IDENT_START | CHAR_IDENT | CHAR_XDIGIT)
+#define AL (CHAR_IDENT_START | CHAR_IDENT)
+
+// clang-format off
+const uint8_t char_class_table[256] = {
+    NO, NO, NO, NO, NO, NO, NO, NO, NO, WS, WS, WS, WS, WS, NO, NO, // 0x00
+    NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, // 0x10
+    WS, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, NO, // 0x20
+    OC, OC, OC, OC, OC, OC, OC, OC, DE, DE, NO, NO, NO, NO, NO, NO, // 0x30
+    NO, HX, HX, HX, HX, HX, HX, AL, AL, AL, AL, AL, AL, AL, AL, AL, // 0x40
+    AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, NO, NO, NO, NO, AL, // 0x50
+    NO, HX, HX, HX, HX, HX, HX, AL, AL, AL, AL, AL, AL, AL, AL, AL, // 0x60
+    AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, AL, NO, NO, NO, NO, NO, // 0x70
+    // bytes 0x80 and up belong to no class
+};
+// clang-format on
+
+#undef NO
+#undef WS
+#undef OC
+#undef DE
+#undef HX
+#undef AL
@@ -0,0 +1,70 @@
+/// @file lib/private/charclass.h
+/// @brief Locale-free character classification.
+///
+/// Every predicate is a load from char_class_table and a mask, no branches and no calls into the C runtime, so the
+/// lexer classifies bytes the same way whatever setlocale() a host application has called. Only ASCII is classified,
+/// bytes 0x80 and up belong to no class.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define CHAR_IDENT_START (1u << 0) ///< [A-Za-z_]
+#define CHAR_IDENT       (1u << 1) ///< [A-Za-z0-9_]
+#define CHAR_DIGIT       (1u << 2) ///< [0-9]
+#define CHAR_XDIGIT      (1u << 3) ///< [0-9A-Fa-f]
+#define CHAR_ODIGIT      (1u << 4) ///< [0-7]
+#define CHAR_SPACE       (1u << 5) ///< ' ', '\\t', '\\n', '\\v', '\\f', '\\r'
+
+/// @brief The CHAR_* classes of every byte.
+extern const uint8_t char_class_table[256];
+
+/// @brief Checks if a character is a letter or underscore, the characters an identifier can start with.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_ident_start(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_IDENT_START;
+}
+
+/// @brief Checks if a character is a letter, digit or underscore.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_ident(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_IDENT;
+}
+
+/// @brief Checks if a character is a letter or digit.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_alnum(char c) {
+    return is_ident(c) && c != '_';
+}
+
+/// @brief Checks if a character is a decimal digit.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_digit(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_DIGIT;
+}
+
+/// @brief Checks if a character is a hexadecimal digit.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_xdigit(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_XDIGIT;
+}
+
+/// @brief Checks if a character is an octal digit.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_odigit(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_ODIGIT;
+}
+
+/// @brief Checks if a character is whitespace in the C locale.
+/// @param c The character to check.
+/// @return true if it is, false otherwise.
+static inline bool is_space(char c) {
+    return char_class_table[(unsigned char)c] & CHAR_SPACE;
+}
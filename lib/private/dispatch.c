@@ -0,0 +1,140 @@
+#include "dispatch.h"
+
+// clang-format off
+const uint8_t token_start_table[256] = {
+    ['\0'] = TOKEN_START_END,
+    ['\''] = TOKEN_START_CHAR,
+    ['"'] = TOKEN_START_STRING,
+    ['.'] = TOKEN_START_DOT,
+    ['L'] = TOKEN_START_WIDE,
+    ['_'] = TOKEN_START_IDENT,
+    ['0'] = TOKEN_START_DIGIT, ['1'] = TOKEN_START_DIGIT, ['2'] = TOKEN_START_DIGIT, ['3'] = TOKEN_START_DIGIT,
+    ['4'] = TOKEN_START_DIGIT, ['5'] = TOKEN_START_DIGIT, ['6'] = TOKEN_START_DIGIT, ['7'] = TOKEN_START_DIGIT,
+    ['8'] = TOKEN_START_DIGIT, ['9'] = TOKEN_START_DIGIT,
+    ['A'] = TOKEN_START_IDENT, ['B'] = TOKEN_START_IDENT, ['C'] = TOKEN_START_IDENT, ['D'] = TOKEN_START_IDENT,
+    ['E'] = TOKEN_START_IDENT, ['F'] = TOKEN_START_IDENT, ['G'] = TOKEN_START_IDENT, ['H'] = TOKEN_START_IDENT,
+    ['I'] = TOKEN_START_IDENT, ['J'] = TOKEN_START_IDENT, ['K'] = TOKEN_START_IDENT, ['M'] = TOKEN_START_IDENT,
+    ['N'] = TOKEN_START_IDENT, ['O'] = TOKEN_START_IDENT, ['P'] = TOKEN_START_IDENT, ['Q'] = TOKEN_START_IDENT,
+    ['R'] = TOKEN_START_IDENT, ['S'] = TOKEN_START_IDENT, ['T'] = TOKEN_START_IDENT, ['U'] = TOKEN_START_IDENT,
+    ['V'] = TOKEN_START_IDENT, ['W'] = TOKEN_START_IDENT, ['X'] = TOKEN_START_IDENT, ['Y'] = TOKEN_START_IDENT,
+    ['Z'] = TOKEN_START_IDENT,
+    ['a'] = TOKEN_START_IDENT, ['b'] = TOKEN_START_IDENT, ['c'] = TOKEN_START_IDENT, ['d'] = TOKEN_START_IDENT,
+    ['e'] = TOKEN_START_IDENT, ['f'] = TOKEN_START_IDENT, ['g'] = TOKEN_START_IDENT, ['h'] = TOKEN_START_IDENT,
+    ['i'] = TOKEN_START_IDENT, ['j'] = TOKEN_START_IDENT, ['k'] = TOKEN_START_IDENT, ['l'] = TOKEN_START_IDENT,
+    ['m'] = TOKEN_START_IDENT, ['n'] = TOKEN_START_IDENT, ['o'] = TOKEN_START_IDENT, ['p'] = TOKEN_START_IDENT,
+    ['q'] = TOKEN_START_IDENT, ['r'] = TOKEN_START_IDENT, ['s'] = TOKEN_START_IDENT, ['t'] = TOKEN_START_IDENT,
+    ['u'] = TOKEN_START_IDENT, ['v'] = TOKEN_START_IDENT, ['w'] = TOKEN_START_IDENT, ['x'] = TOKEN_START_IDENT,
+    ['y'] = TOKEN_START_IDENT, ['z'] = TOKEN_START_IDENT,
+};
+// clang-format on
+
+const uint8_t punctuator_column[256] = {
+    ['!'] = 1,
+    ['#'] = 2,
+    ['%'] = 3,
+    ['&'] = 4,
+    ['('] = 5,
+    [')'] = 6,
+    ['*'] = 7,
+    ['+'] = 8,
+    [','] = 9,
+    ['-'] = 10,
+    ['.'] = 11,
+    ['/'] = 12,
+    [':'] = 13,
+    [';'] = 14,
+    ['<'] = 15,
+    ['='] = 16,
+    ['>'] = 17,
+    ['?'] = 18,
+    ['['] = 19,
+    [']'] = 20,
+    ['^'] = 21,
+    ['{'] = 22,
+    ['|'] = 23,
+    ['}'] = 24,
+    ['~'] = 25,
+};
+
+const int8_t punctuator_accept[PUNCTUATOR_STATES] = {
+    [ 0] = MCC_PUNCTUATOR_INVALID,                      // dead
+    [ 1] = MCC_PUNCTUATOR_BANG,                         // !
+    [ 2] = MCC_PUNCTUATOR_HASH,                         // #
+    [ 3] = MCC_PUNCTUATOR_PERCENT,                      // %
+    [ 4] = MCC_PUNCTUATOR_AMPERSAND,                    // &
+    [ 5] = MCC_PUNCTUATOR_LEFT_PARENTHESIS,             // (
+    [ 6] = MCC_PUNCTUATOR_RIGHT_PARENTHESIS,            // )
+    [ 7] = MCC_PUNCTUATOR_ASTERISK,                     // *
+    [ 8] = MCC_PUNCTUATOR_PLUS,                         // +
+    [ 9] = MCC_PUNCTUATOR_COMMA,                        // ,
+    [10] = MCC_PUNCTUATOR_MINUS,                        // -
+    [11] = MCC_PUNCTUATOR_DOT,                          // .
+    [12] = MCC_PUNCTUATOR_SLASH,                        // /
+    [13] = MCC_PUNCTUATOR_COLON,                        // :
+    [14] = MCC_PUNCTUATOR_SEMICOLON,                    // ;
+    [15] = MCC_PUNCTUATOR_LEFT_CHEVRON,                 // <
+    [16] = MCC_PUNCTUATOR_EQUAL,                        // =
+    [17] = MCC_PUNCTUATOR_RIGHT_CHEVRON,                // >
+    [18] = MCC_PUNCTUATOR_QUESTION_MARK,                // ?
+    [19] = MCC_PUNCTUATOR_LEFT_BRACKET,                 // [
+    [20] = MCC_PUNCTUATOR_RIGHT_BRACKET,                // ]
+    [21] = MCC_PUNCTUATOR_CARET,                        // ^
+    [22] = MCC_PUNCTUATOR_LEFT_BRACE,                   // {
+    [23] = MCC_PUNCTUATOR_PIPE,                         // |
+    [24] = MCC_PUNCTUATOR_RIGHT_BRACE,                  // }
+    [25] = MCC_PUNCTUATOR_TILDE,                        // ~
+    [26] = MCC_PUNCTUATOR_BANG_EQUAL,                   // !=
+    [27] = MCC_PUNCTUATOR_HASH_HASH,                    // ##
+    [28] = MCC_PUNCTUATOR_HASH,                         // %:
+    [29] = MCC_PUNCTUATOR_PERCENT_EQUAL,                // %=
+    [30] = MCC_PUNCTUATOR_RIGHT_BRACE,                  // %>
+    [31] = MCC_PUNCTUATOR_AMPERSAND_AMPERSAND,          // &&
+    [32] = MCC_PUNCTUATOR_AMPERSAND_EQUAL,              // &=
+    [33] = MCC_PUNCTUATOR_ASTERISK_EQUAL,               // *=
+    [34] = MCC_PUNCTUATOR_PLUS_PLUS,                    // ++
+    [35] = MCC_PUNCTUATOR_PLUS_EQUAL,                   // +=
+    [36] = MCC_PUNCTUATOR_MINUS_MINUS,                  // --
+    [37] = MCC_PUNCTUATOR_MINUS_EQUAL,                  // -=
+    [38] = MCC_PUNCTUATOR_ARROW,                        // ->
+    [39] = MCC_PUNCTUATOR_INVALID,                      // ..
+    [40] = MCC_PUNCTUATOR_SLASH_EQUAL,                  // /=
+    [41] = MCC_PUNCTUATOR_RIGHT_BRACKET,                // :>
+    [42] = MCC_PUNCTUATOR_LEFT_BRACE,                   // <%
+    [43] = MCC_PUNCTUATOR_LEFT_BRACKET,                 // <:
+    [44] = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON,          // <<
+    [45] = MCC_PUNCTUATOR_LEFT_CHEVRON_EQUAL,           // <=
+    [46] = MCC_PUNCTUATOR_EQUAL_EQUAL,                  // ==
+    [47] = MCC_PUNCTUATOR_RIGHT_CHEVRON_EQUAL,          // >=
+    [48] = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON,         // >>
+    [49] = MCC_PUNCTUATOR_CARET_EQUAL,                  // ^=
+    [50] = MCC_PUNCTUATOR_PIPE_EQUAL,                   // |=
+    [51] = MCC_PUNCTUATOR_PIPE_PIPE,                    // ||
+    [52] = MCC_PUNCTUATOR_INVALID,                      // %:%
+    [53] = MCC_PUNCTUATOR_ELLIPSIS,                     // ...
+    [54] = MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON_EQUAL,    // <<=
+    [55] = MCC_PUNCTUATOR_DOUBLE_RIGHT_CHEVRON_EQUAL,   // >>=
+    [56] = MCC_PUNCTUATOR_HASH_HASH,                    // %:%:
+};
+
+const uint8_t punctuator_transitions[PUNCTUATOR_STATES][PUNCTUATOR_COLUMNS] = {
+    [ 1] = {[16] = 26},                                  // !
+    [ 2] = {[ 2] = 27},                                  // #
+    [ 3] = {[13] = 28, [16] = 29, [17] = 30},            // %
+    [ 4] = {[ 4] = 31, [16] = 32},                       // &
+    [ 7] = {[16] = 33},                                  // *
+    [ 8] = {[ 8] = 34, [16] = 35},                       // +
+    [10] = {[10] = 36, [16] = 37, [17] = 38},            // -
+    [11] = {[11] = 39},                                  // .
+    [12] = {[16] = 40},                                  // /
+    [13] = {[17] = 41},                                  // :
+    [15] = {[ 3] = 42, [13] = 43, [15] = 44, [16] = 45}, // <
+    [16] = {[16] = 46},                                  // =
+    [17] = {[16] = 47, [17] = 48},                       // >
+    [21] = {[16] = 49},                                  // ^
+    [23] = {[16] = 50, [23] = 51},                       // |
+    [28] = {[ 3] = 52},                                  // %:
+    [39] = {[11] = 53},                                  // ..
+    [44] = {[16] = 54},                                  // <<
+    [48] = {[16] = 55},                                  // >>
+    [52] = {[13] = 56},                                  // %:%
+};
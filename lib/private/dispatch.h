@@ -0,0 +1,64 @@
+/// @file lib/private/dispatch.h
+/// @brief Lookup tables for token start classification and punctuator scanning.
+///
+/// The first byte of a token selects its scanner through token_start_table, a single indexed load instead of a chain
+/// of character tests. Punctuators are then matched by a small DFA: punctuator_column folds a byte into one of
+/// PUNCTUATOR_COLUMNS classes and punctuator_transitions steps through the states, each state standing for one prefix
+/// of a punctuator spelling. The tables were generated from the C99 punctuator and digraph spellings, if that set ever
+/// changes they must be regenerated.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+
+#define PUNCTUATOR_STATES  57 ///< Number of DFA states, state 0 is the dead state.
+#define PUNCTUATOR_COLUMNS 26 ///< Number of byte classes, column 0 holds every byte that is not a punctuator character.
+
+/// @brief What the first byte of a token says about the token.
+enum token_start {
+    TOKEN_START_OTHER,  ///< A punctuator, or a byte that starts no token at all.
+    TOKEN_START_END,    ///< The null terminator.
+    TOKEN_START_DIGIT,  ///< A decimal digit, always a number.
+    TOKEN_START_DOT,    ///< A number if a digit follows, a punctuator otherwise.
+    TOKEN_START_IDENT,  ///< A letter or underscore, a keyword or identifier.
+    TOKEN_START_WIDE,   ///< 'L', a wide character or string prefix if a quote follows, an identifier otherwise.
+    TOKEN_START_CHAR,   ///< A single quote.
+    TOKEN_START_STRING, ///< A double quote.
+};
+
+/// @brief Maps every byte to its enum token_start.
+extern const uint8_t token_start_table[256];
+
+/// @brief Maps every byte to its column in punctuator_transitions.
+/// @note Single character punctuators are numbered so that a byte's column is also the state it leads to from the
+/// start, which lets the first step skip the transition table.
+extern const uint8_t punctuator_column[256];
+
+/// @brief The punctuator each state accepts, or MCC_PUNCTUATOR_INVALID for the prefixes ".." and "%:%" which are only
+/// valid on the way to "..." and "%:%:".
+extern const int8_t punctuator_accept[PUNCTUATOR_STATES];
+
+/// @brief Next state for each state and column, 0 ends the match.
+extern const uint8_t punctuator_transitions[PUNCTUATOR_STATES][PUNCTUATOR_COLUMNS];
+
+/// @brief Finds the longest punctuator at the start of a string.
+/// @param str Pointer to the candidate punctuator, must be null-terminated somewhere after it.
+/// @param punctuator Pointer to where the matched punctuator will be stored.
+/// @return Length of the match, or 0 if no punctuator starts at @p str.
+/// @note The scan remembers the last accepting state, so "..x" matches "." and "%:%x" matches "%:".
+static inline size_t punctuator_match(const char* str, enum mcc_punctuator* punctuator) {
+    size_t state = punctuator_column[(unsigned char)str[0]];
+    size_t len   = 0;
+
+    *punctuator = MCC_PUNCTUATOR_INVALID;
+    for (size_t i = 1; state != 0; i++) {
+        if (punctuator_accept[state] != MCC_PUNCTUATOR_INVALID) {
+            *punctuator = (enum mcc_punctuator)punctuator_accept[state];
+            len         = i;
+        }
+        state = punctuator_transitions[state][punctuator_column[(unsigned char)str[i]]];
+    }
+    return len;
+}
@@ -0,0 +1,810 @@
+#include "float_parse.h"
+
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+#define MAX_EXPONENT 100000 // exponents are clamped here, anything larger over- or underflows every format
+
+#define DECIMAL_MAX_DIGITS 800 // enough for every digit that can affect rounding of a double
+#define DECIMAL_MAX_SHIFT  60  // largest single binary shift that cannot overflow a 64-bit accumulator
+
+enum range {
+    RANGE_OK,
+    RANGE_OVERFLOW,  // rounds to infinity
+    RANGE_UNDERFLOW, // nonzero value rounds to zero
+};
+
+struct float_format {
+    int mant_dig;   // significand bits including the implicit bit, <float.h> *_MANT_DIG
+    int min_exp;    // <float.h> *_MIN_EXP, normalized values are in [0.5, 1) * 2^e with e >= min_exp
+    int max_exp;    // <float.h> *_MAX_EXP
+    int max_10_exp; // <float.h> *_MAX_10_EXP
+    // Eisel-Lemire parameters, only used for IEEE binary32 and binary64
+    int minimum_exponent;
+    int infinite_power;
+    int min_exponent_round_to_even;
+    int max_exponent_round_to_even;
+    int smallest_power_of_ten;
+    int largest_power_of_ten;
+};
+
+static const struct float_format binary32 = {
+    .mant_dig                   = FLT_MANT_DIG,
+    .min_exp                    = FLT_MIN_EXP,
+    .max_exp                    = FLT_MAX_EXP,
+    .max_10_exp                 = FLT_MAX_10_EXP,
+    .minimum_exponent           = -127,
+    .infinite_power             = 0xFF,
+    .min_exponent_round_to_even = -17,
+    .max_exponent_round_to_even = 10,
+    .smallest_power_of_ten      = -65,
+    .largest_power_of_ten       = 38,
+};
+
+static const struct float_format binary64 = {
+    .mant_dig                   = DBL_MANT_DIG,
+    .min_exp                    = DBL_MIN_EXP,
+    .max_exp                    = DBL_MAX_EXP,
+    .max_10_exp                 = DBL_MAX_10_EXP,
+    .minimum_exponent           = -1023,
+    .infinite_power             = 0x7FF,
+    .min_exponent_round_to_even = -4,
+    .max_exponent_round_to_even = 23,
+    .smallest_power_of_ten      = -342,
+    .largest_power_of_ten       = 308,
+};
+
+#if LDBL_MANT_DIG != DBL_MANT_DIG && LDBL_MANT_DIG <= 64
+static const struct float_format extended = {
+    .mant_dig   = LDBL_MANT_DIG,
+    .min_exp    = LDBL_MIN_EXP,
+    .max_exp    = LDBL_MAX_EXP,
+    .max_10_exp = LDBL_MAX_10_EXP,
+};
+#endif
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool is_digit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static int hex_digit_value(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+static bool is_hex_prefix(const char* begin, const char* end) {
+    return end - begin > 2 && begin[0] == '0' && (begin[1] == 'x' || begin[1] == 'X');
+}
+
+// x must be nonzero
+static int leading_zeros(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, x);
+    return 63 - (int)index;
+#else
+    int n = 0;
+    for (; !(x & 0x8000000000000000); x <<= 1) {
+        n++;
+    }
+    return n;
+#endif
+}
+
+// full 64x64 -> 128 bit product, returns the low word
+static uint64_t multiply(uint64_t a, uint64_t b, uint64_t* high) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ typedef unsigned __int128 uint128;
+    const uint128 product = (uint128)a * b;
+    *high                 = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, high);
+#else
+    const uint64_t a_lo = (uint32_t)a, a_hi = a >> 32;
+    const uint64_t b_lo = (uint32_t)b, b_hi = b >> 32;
+    const uint64_t p0 = a_lo * b_lo, p1 = a_lo * b_hi, p2 = a_hi * b_lo, p3 = a_hi * b_hi;
+    const uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+    *high              = p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+    return (mid << 32) | (uint32_t)p0;
+#endif
+}
+
+static int clamp_exponent(long exponent) {
+    return exponent > MAX_EXPONENT ? MAX_EXPONENT : exponent < -MAX_EXPONENT ? -MAX_EXPONENT : (int)exponent;
+}
+
+// reads the optional exponent part ([eEpP][+-]?digits) at p, the marker has already been matched by the caller
+static int parse_exponent(const char* p, const char* end) {
+    bool negative = false;
+    if (p != end && (*p == '+' || *p == '-')) {
+        negative = *p++ == '-';
+    }
+    long exponent = 0;
+    for (; p != end && is_digit(*p); p++) {
+        if (exponent < MAX_EXPONENT) {
+            exponent = exponent * 10 + (*p - '0');
+        }
+    }
+    return clamp_exponent(negative ? -exponent : exponent);
+}
+
+// =============================================================================
+// Decimal scan
+// =============================================================================
+
+struct decimal_scan {
+    uint64_t mantissa; // first 19 significant digits
+    int exponent;      // power of ten that scales mantissa to the value
+    bool truncated;    // nonzero digits did not fit in mantissa
+};
+
+#define SCAN_MAX_DIGITS 19 // 10^19 - 1 is the largest run of nines that fits in 64 bits
+
+static struct decimal_scan scan_decimal(const char* p, const char* end) {
+    struct decimal_scan scan = {0};
+    int digits               = 0;
+    long exponent            = 0;
+
+    for (; p != end && is_digit(*p); p++) {
+        if (digits == 0 && *p == '0') {
+            continue;
+        }
+        if (digits < SCAN_MAX_DIGITS) {
+            scan.mantissa = scan.mantissa * 10 + (uint64_t)(*p - '0');
+            digits++;
+        } else {
+            exponent++;
+            scan.truncated |= *p != '0';
+        }
+    }
+    if (p != end && *p == '.') {
+        for (p++; p != end && is_digit(*p); p++) {
+            if (digits == 0 && *p == '0') {
+                exponent--;
+            } else if (digits < SCAN_MAX_DIGITS) {
+                scan.mantissa = scan.mantissa * 10 + (uint64_t)(*p - '0');
+                digits++;
+                exponent--;
+            } else {
+                scan.truncated |= *p != '0';
+            }
+        }
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        exponent += parse_exponent(p + 1, end);
+    }
+
+    scan.exponent = clamp_exponent(exponent);
+    return scan;
+}
+
+// =============================================================================
+// Eisel-Lemire
+// =============================================================================
+
+// floor(log2(10^q)) + 63, exact for q in [-342, 308]
+static int power_of_ten_to_two(int q) {
+    return (((152170 + 65536) * q) >> 16) + 63;
+}
+
+// computes the IEEE mantissa field and biased exponent of w * 10^q, w must be nonzero.
+// returns false when the truncated product lies too close to a rounding boundary to decide
+static bool eisel_lemire(uint64_t w, int q, const struct float_format* format, uint64_t* mantissa, int* power2) {
+    const int explicit_bits = format->mant_dig - 1;
+
+    if (q < format->smallest_power_of_ten) {
+        *mantissa = 0;
+        *power2   = 0;
+        return true;
+    }
+    if (q > format->largest_power_of_ten) {
+        *mantissa = 0;
+        *power2   = format->infinite_power;
+        return true;
+    }
+
+    const int lz = leading_zeros(w);
+    w <<= lz;
+
+    const uint64_t* pow5 = pow5_table[q - POW5_MIN_EXPONENT];
+    uint64_t high;
+    uint64_t low = multiply(w, pow5[0], &high);
+
+    // only when the bits below the ones that matter are all set can the second word carry into them
+    const uint64_t precision_mask = UINT64_MAX >> (explicit_bits + 3);
+    if ((high & precision_mask) == precision_mask) {
+        uint64_t second_high;
+        multiply(w, pow5[1], &second_high);
+        low += second_high;
+        if (second_high > low) {
+            high++;
+        }
+    }
+    if (low == UINT64_MAX && (q < -27 || q > 55)) {
+        return false; // 5^q is not exact in 128 bits so the error term could still carry
+    }
+
+    const int upper_bit = (int)(high >> 63);
+    const int shift     = upper_bit + 64 - explicit_bits - 3;
+    uint64_t m          = high >> shift;
+    int p2              = power_of_ten_to_two(q) + upper_bit - lz - format->minimum_exponent;
+
+    if (p2 <= 0) { // subnormal
+        if (-p2 + 1 >= 64) {
+            *mantissa = 0;
+            *power2   = 0;
+            return true;
+        }
+        m >>= -p2 + 1;
+        m += m & 1;
+        m >>= 1;
+        *mantissa = m;
+        *power2   = m < ((uint64_t)1 << explicit_bits) ? 0 : 1;
+        return true;
+    }
+
+    // an exact halfway product is only possible for small q, round it to even rather than up
+    if (low <= 1 && q >= format->min_exponent_round_to_even && q <= format->max_exponent_round_to_even &&
+        (m & 3) == 1 && (m << shift) == high) {
+        m &= ~(uint64_t)1;
+    }
+
+    m += m & 1;
+    m >>= 1;
+    if (m >= ((uint64_t)2 << explicit_bits)) {
+        m = (uint64_t)1 << explicit_bits;
+        p2++;
+    }
+    m &= ~((uint64_t)1 << explicit_bits);
+
+    if (p2 >= format->infinite_power) {
+        m  = 0;
+        p2 = format->infinite_power;
+    }
+
+    *mantissa = m;
+    *power2   = p2;
+    return true;
+}
+
+// runs Eisel-Lemire on a scan, a truncated mantissa is bracketed by w and w + 1 and must round the same either way
+static bool eisel_lemire_scan(const struct decimal_scan* scan,
+                              const struct float_format* format,
+                              uint64_t* mantissa,
+                              int* power2) {
+    if (!eisel_lemire(scan->mantissa, scan->exponent, format, mantissa, power2)) {
+        return false;
+    }
+    if (scan->truncated) {
+        uint64_t upper_mantissa;
+        int upper_power2;
+        if (!eisel_lemire(scan->mantissa + 1, scan->exponent, format, &upper_mantissa, &upper_power2) ||
+            upper_mantissa != *mantissa || upper_power2 != *power2) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static enum range eisel_lemire_range(uint64_t mantissa, int power2, const struct float_format* format) {
+    if (power2 == format->infinite_power) {
+        return RANGE_OVERFLOW;
+    }
+    return mantissa == 0 && power2 == 0 ? RANGE_UNDERFLOW : RANGE_OK;
+}
+
+// =============================================================================
+// Exact decimal fallback
+// =============================================================================
+
+// arbitrary precision decimal in [0, 1) * 10^point, with just enough arithmetic to scale by powers of two
+struct decimal {
+    uint8_t digits[DECIMAL_MAX_DIGITS]; // digit values, most significant first, no trailing zeros
+    int count;                          // digits in use
+    int point;                          // position of the decimal point relative to digits[0]
+    bool truncated;                     // nonzero digits were dropped past digits[DECIMAL_MAX_DIGITS - 1]
+};
+
+static void decimal_trim(struct decimal* d) {
+    while (d->count > 0 && d->digits[d->count - 1] == 0) {
+        d->count--;
+    }
+    if (d->count == 0) {
+        d->point = 0;
+    }
+}
+
+static void decimal_parse(struct decimal* d, const char* p, const char* end) {
+    d->count     = 0;
+    d->point     = 0;
+    d->truncated = false;
+
+    bool seen_point = false;
+    for (; p != end; p++) {
+        if (*p == '.' && !seen_point) {
+            seen_point = true;
+            continue;
+        }
+        if (!is_digit(*p)) {
+            break;
+        }
+        if (d->count == 0 && *p == '0') {
+            d->point -= seen_point; // leading zeros only move the point once they follow it
+            continue;
+        }
+        if (d->count < DECIMAL_MAX_DIGITS) {
+            d->digits[d->count++] = (uint8_t)(*p - '0');
+        } else {
+            d->truncated |= *p != '0';
+        }
+        d->point += !seen_point;
+    }
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        d->point = clamp_exponent((long)d->point + parse_exponent(p + 1, end));
+    }
+    decimal_trim(d);
+}
+
+// divides by 2^k, k <= DECIMAL_MAX_SHIFT
+static void decimal_right_shift(struct decimal* d, unsigned k) {
+    int r      = 0;
+    int w      = 0;
+    uint64_t n = 0;
+
+    // pick up enough leading digits to produce the first output digit
+    for (; (n >> k) == 0; r++) {
+        if (r >= d->count) {
+            if (n == 0) {
+                d->count = 0;
+                d->point = 0;
+                return;
+            }
+            while ((n >> k) == 0) {
+                n *= 10;
+                r++;
+            }
+            break;
+        }
+        n = n * 10 + d->digits[r];
+    }
+    d->point -= r - 1;
+
+    const uint64_t mask = ((uint64_t)1 << k) - 1;
+    for (; r < d->count; r++) {
+        const uint64_t digit = d->digits[r];
+        d->digits[w++]       = (uint8_t)(n >> k);
+        n                    = (n & mask) * 10 + digit;
+    }
+    while (n > 0) {
+        const uint64_t digit = n >> k;
+        n                    = (n & mask) * 10;
+        if (w < DECIMAL_MAX_DIGITS) {
+            d->digits[w++] = (uint8_t)digit;
+        } else if (digit > 0) {
+            d->truncated = true;
+        }
+    }
+
+    d->count = w;
+    decimal_trim(d);
+}
+
+// multiplies by 2^k, k <= DECIMAL_MAX_SHIFT
+static void decimal_left_shift(struct decimal* d, unsigned k) {
+    uint8_t reversed[DECIMAL_MAX_DIGITS + 20]; // least significant first, a shift adds at most 19 digits
+    int size       = 0;
+    uint64_t carry = 0;
+
+    for (int r = d->count - 1; r >= 0; r--) {
+        carry += (uint64_t)d->digits[r] << k;
+        reversed[size++] = (uint8_t)(carry % 10);
+        carry /= 10;
+    }
+    for (; carry > 0; carry /= 10) {
+        reversed[size++] = (uint8_t)(carry % 10);
+    }
+
+    d->point += size - d->count;
+    d->count = size < DECIMAL_MAX_DIGITS ? size : DECIMAL_MAX_DIGITS;
+    for (int i = 0; i < size - d->count; i++) {
+        d->truncated |= reversed[i] != 0;
+    }
+    for (int i = 0; i < d->count; i++) {
+        d->digits[i] = reversed[size - 1 - i];
+    }
+    decimal_trim(d);
+}
+
+static void decimal_shift(struct decimal* d, int k) {
+    for (; k > DECIMAL_MAX_SHIFT; k -= DECIMAL_MAX_SHIFT) {
+        decimal_left_shift(d, DECIMAL_MAX_SHIFT);
+    }
+    for (; k < -DECIMAL_MAX_SHIFT; k += DECIMAL_MAX_SHIFT) {
+        decimal_right_shift(d, DECIMAL_MAX_SHIFT);
+    }
+    if (k > 0) {
+        decimal_left_shift(d, (unsigned)k);
+    } else if (k < 0) {
+        decimal_right_shift(d, (unsigned)-k);
+    }
+}
+
+// rounds to the nearest integer, ties to even. *carry is set if the result is 2^64
+static uint64_t decimal_rounded_integer(const struct decimal* d, bool* carry) {
+    uint64_t n = 0;
+    int i      = 0;
+    for (; i < d->point && i < d->count; i++) {
+        n = n * 10 + d->digits[i];
+    }
+    for (; i < d->point; i++) {
+        n *= 10;
+    }
+
+    bool round_up = false;
+    if (d->point >= 0 && d->point < d->count) {
+        if (d->digits[d->point] == 5 && d->point + 1 == d->count && !d->truncated) {
+            round_up = d->point > 0 && d->digits[d->point - 1] % 2 == 1;
+        } else {
+            round_up = d->digits[d->point] >= 5;
+        }
+    }
+
+    *carry = round_up && n == UINT64_MAX;
+    return n + round_up;
+}
+
+// converts to mantissa * 2^exponent with mantissa rounded to the format's precision, exact for every input
+static enum range decimal_to_binary(struct decimal* d,
+                                    const struct float_format* format,
+                                    uint64_t* mantissa,
+                                    int* exponent) {
+    // shifts to scale a number with n integer digits below 1, 2^powers[n] >= 10^n
+    static const int powers[] = {1, 3, 6, 9, 13, 16, 19, 23, 26};
+    static const int max_power = 27;
+
+    *mantissa = 0;
+    *exponent = 0;
+
+    if (d->count == 0) {
+        return RANGE_OK;
+    }
+    if (d->point > format->max_10_exp + 1) {
+        return RANGE_OVERFLOW;
+    }
+    // below half the smallest subnormal, 30103 / 100000 approximates log10(2) and the -1 covers its error
+    if (d->point < (format->min_exp - format->mant_dig - 1) * 30103 / 100000 - 1) {
+        return RANGE_UNDERFLOW;
+    }
+
+    // scale into [0.5, 1) tracking the binary exponent
+    int exp = 0;
+    while (d->point > 0) {
+        const int n = d->point < (int)(sizeof(powers) / sizeof(*powers)) ? powers[d->point] : max_power;
+        decimal_shift(d, -n);
+        exp += n;
+    }
+    while (d->point < 0 || (d->point == 0 && d->digits[0] < 5)) {
+        const int n = -d->point < (int)(sizeof(powers) / sizeof(*powers)) ? powers[-d->point] : max_power;
+        decimal_shift(d, n);
+        exp -= n;
+    }
+
+    // subnormal, give up precision to bring the exponent into range
+    if (exp < format->min_exp) {
+        decimal_shift(d, -(format->min_exp - exp));
+        exp = format->min_exp;
+    }
+    if (exp > format->max_exp) {
+        return RANGE_OVERFLOW;
+    }
+
+    decimal_shift(d, format->mant_dig);
+    bool carry;
+    uint64_t m = decimal_rounded_integer(d, &carry);
+
+    // rounding carried into a new bit
+    if (carry || (format->mant_dig < 64 && m == (uint64_t)1 << format->mant_dig)) {
+        m = (uint64_t)1 << (format->mant_dig - 1);
+        if (++exp > format->max_exp) {
+            return RANGE_OVERFLOW;
+        }
+    }
+    if (m == 0) {
+        return RANGE_UNDERFLOW;
+    }
+
+    *mantissa = m;
+    *exponent = exp - format->mant_dig;
+    return RANGE_OK;
+}
+
+static enum range decimal_fallback(const char* begin,
+                                   const char* end,
+                                   const struct float_format* format,
+                                   uint64_t* mantissa,
+                                   int* exponent) {
+    struct decimal* d = malloc(sizeof(*d)); // rare path, keep the 800 digits off the stack
+    if (!d) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    decimal_parse(d, begin, end);
+    const enum range range = decimal_to_binary(d, format, mantissa, exponent);
+    free(d);
+    return range;
+}
+
+// =============================================================================
+// Hexadecimal
+// =============================================================================
+
+// converts exactly to mantissa * 2^exponent rounded to the format's precision
+static enum range hex_to_binary(const char* p,
+                                const char* end,
+                                const struct float_format* format,
+                                uint64_t* mantissa,
+                                int* exponent) {
+    uint64_t m    = 0;
+    long exp      = 0;
+    bool guard    = false; // first bit that did not fit in m
+    bool sticky   = false; // any later bit that did not fit in m was set
+    bool full     = false; // all 64 bits of m are in use
+    bool fraction = false;
+
+    for (p += 2; p != end; p++) {
+        if (*p == '.' && !fraction) {
+            fraction = true;
+            continue;
+        }
+        const int digit = hex_digit_value(*p);
+        if (digit < 0) {
+            break;
+        }
+        if (full) {
+            sticky |= digit != 0;
+            exp += fraction ? 0 : 4;
+            continue;
+        }
+        const int room = m == 0 ? 64 : leading_zeros(m);
+        if (room >= 4) {
+            m = m << 4 | (uint64_t)digit;
+            exp -= fraction ? 4 : 0;
+            continue;
+        }
+        // split the digit, its high bits fill m and the rest become the guard and sticky bits
+        const int spill = 4 - room;
+        m               = m << room | (uint64_t)digit >> spill;
+        guard           = (digit >> (spill - 1)) & 1;
+        sticky          = (digit & ((1 << (spill - 1)) - 1)) != 0;
+        exp += fraction ? -room : spill;
+        full = true;
+    }
+    if (p != end && (*p == 'p' || *p == 'P')) {
+        exp += parse_exponent(p + 1, end);
+    }
+
+    *mantissa = 0;
+    *exponent = 0;
+    if (m == 0) {
+        return RANGE_OK;
+    }
+
+    // keep mant_dig bits, fewer once the value is below the normal range
+    const int length = 64 - leading_zeros(m);
+    const long top   = length + exp; // value is in [0.5, 1) * 2^top
+    long bits        = format->mant_dig;
+    if (top < format->min_exp) {
+        bits -= format->min_exp - top;
+    }
+
+    // round to nearest even, the guard and sticky bits sit just below bit 0 of m
+    const long drop = length - bits;
+    if (drop >= 0) {
+        uint64_t kept = 0;
+        bool half     = guard;
+        bool rest     = sticky;
+        if (drop == 0) {
+            kept = m;
+        } else if (drop > 64) {
+            half = false;
+            rest = true;
+        } else if (drop == 64) {
+            half = m >> 63;
+            rest |= guard || (m << 1) != 0;
+        } else {
+            kept = m >> drop;
+            half = (m >> (drop - 1)) & 1;
+            rest |= guard || (m & (((uint64_t)1 << (drop - 1)) - 1)) != 0;
+        }
+        if (half && (rest || (kept & 1))) {
+            kept++;
+        }
+        exp += drop;
+        if (drop == 0 && kept == 0) { // 2^64 - 1 rounded up
+            kept = (uint64_t)1 << 63;
+            exp++;
+        }
+        m = kept;
+    }
+
+    if (m == 0) {
+        return RANGE_UNDERFLOW;
+    }
+    if (64 - leading_zeros(m) + exp > format->max_exp) {
+        return RANGE_OVERFLOW;
+    }
+
+    *mantissa = m;
+    *exponent = (int)exp;
+    return RANGE_OK;
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+bool parse_float(const char* begin, const char* end, float* value) {
+    uint64_t mantissa;
+    int exponent;
+    enum range range;
+
+    if (is_hex_prefix(begin, end)) {
+        range  = hex_to_binary(begin, end, &binary32, &mantissa, &exponent);
+        *value = ldexpf((float)mantissa, exponent);
+    } else {
+        const struct decimal_scan scan = scan_decimal(begin, end);
+        if (scan.mantissa == 0) {
+            *value = 0.0f;
+            return true;
+        }
+
+#if FLT_EVAL_METHOD == 0
+        // Clinger: both operands are exact so the single rounding of the operation is the correct one
+        static const float powers_of_ten[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+        if (!scan.truncated && scan.mantissa <= (uint64_t)1 << FLT_MANT_DIG && scan.exponent >= -10 &&
+            scan.exponent <= 10) {
+            const float m = (float)scan.mantissa;
+            *value        = scan.exponent < 0 ? m / powers_of_ten[-scan.exponent] : m * powers_of_ten[scan.exponent];
+            return true;
+        }
+#endif
+
+        int power2;
+        if (eisel_lemire_scan(&scan, &binary32, &mantissa, &power2)) {
+            const uint32_t bits = (uint32_t)(mantissa | (uint64_t)power2 << (FLT_MANT_DIG - 1));
+            memcpy(value, &bits, sizeof(*value));
+            return eisel_lemire_range(mantissa, power2, &binary32) == RANGE_OK;
+        }
+
+        range  = decimal_fallback(begin, end, &binary32, &mantissa, &exponent);
+        *value = ldexpf((float)mantissa, exponent);
+    }
+
+    if (range == RANGE_OVERFLOW) {
+        *value = HUGE_VALF;
+    }
+    return range == RANGE_OK;
+}
+
+bool parse_double(const char* begin, const char* end, double* value) {
+    uint64_t mantissa;
+    int exponent;
+    enum range range;
+
+    if (is_hex_prefix(begin, end)) {
+        range  = hex_to_binary(begin, end, &binary64, &mantissa, &exponent);
+        *value = ldexp((double)mantissa, exponent);
+    } else {
+        const struct decimal_scan scan = scan_decimal(begin, end);
+        if (scan.mantissa == 0) {
+            *value = 0.0;
+            return true;
+        }
+
+#if FLT_EVAL_METHOD == 0 || FLT_EVAL_METHOD == 1
+        // Clinger: both operands are exact so the single rounding of the operation is the correct one
+        static const double powers_of_ten[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+        if (!scan.truncated && scan.mantissa <= (uint64_t)1 << DBL_MANT_DIG && scan.exponent >= -22 &&
+            scan.exponent <= 22) {
+            const double m = (double)scan.mantissa;
+            *value         = scan.exponent < 0 ? m / powers_of_ten[-scan.exponent] : m * powers_of_ten[scan.exponent];
+            return true;
+        }
+#endif
+
+        int power2;
+        if (eisel_lemire_scan(&scan, &binary64, &mantissa, &power2)) {
+            const uint64_t bits = mantissa | (uint64_t)power2 << (DBL_MANT_DIG - 1);
+            memcpy(value, &bits, sizeof(*value));
+            return eisel_lemire_range(mantissa, power2, &binary64) == RANGE_OK;
+        }
+
+        range  = decimal_fallback(begin, end, &binary64, &mantissa, &exponent);
+        *value = ldexp((double)mantissa, exponent);
+    }
+
+    if (range == RANGE_OVERFLOW) {
+        *value = HUGE_VAL;
+    }
+    return range == RANGE_OK;
+}
+
+bool parse_long_double(const char* begin, const char* end, long double* value) {
+#if LDBL_MANT_DIG == DBL_MANT_DIG
+    double d;
+    const bool in_range = parse_double(begin, end, &d);
+    *value              = d;
+    return in_range;
+#elif LDBL_MANT_DIG <= 64
+    uint64_t mantissa;
+    int exponent;
+    enum range range;
+
+    if (is_hex_prefix(begin, end)) {
+        range = hex_to_binary(begin, end, &extended, &mantissa, &exponent);
+    } else {
+        const struct decimal_scan scan = scan_decimal(begin, end);
+        if (scan.mantissa == 0) {
+            *value = 0.0L;
+            return true;
+        }
+
+        // Clinger: 10^27 still fits in 64 significand bits
+        static const long double powers_of_ten[] = {1e0L,  1e1L,  1e2L,  1e3L,  1e4L,  1e5L,  1e6L,
+                                                    1e7L,  1e8L,  1e9L,  1e10L, 1e11L, 1e12L, 1e13L,
+                                                    1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L,
+                                                    1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L};
+        if (LDBL_MANT_DIG == 64 && !scan.truncated && scan.exponent >= -27 && scan.exponent <= 27) {
+            const long double m = (long double)scan.mantissa;
+            *value = scan.exponent < 0 ? m / powers_of_ten[-scan.exponent] : m * powers_of_ten[scan.exponent];
+            return true;
+        }
+
+        range = decimal_fallback(begin, end, &extended, &mantissa, &exponent);
+    }
+
+    *value = range == RANGE_OVERFLOW ? HUGE_VALL : ldexpl((long double)mantissa, exponent);
+    return range == RANGE_OK;
+#else
+    // no exact path for wider formats, strtold needs a terminated copy
+    const size_t length = (size_t)(end - begin);
+    char* copy          = malloc(length + 1);
+    if (!copy) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(copy, begin, length);
+    copy[length] = '\0';
+    errno        = 0;
+    *value       = strtold(copy, NULL);
+    free(copy);
+    return errno != ERANGE;
+#endif
+}
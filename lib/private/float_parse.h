@@ -0,0 +1,43 @@
+/// @file lib/private/float_parse.h
+/// @brief Correctly rounded, locale-independent parsing of C floating constants.
+///
+/// Decimal constants take Clinger's exact fast path when the significand and power of ten are both exactly
+/// representable, then the Eisel-Lemire algorithm, which decides almost every remaining input with one or two 64x128
+/// bit multiplications. The rare inputs it cannot decide fall back to an exact big-decimal conversion. Hexadecimal
+/// constants are converted exactly with a single rounding step. Neither path needs the input to be null-terminated.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define POW5_MIN_EXPONENT -342 ///< Smallest power of five in pow5_table.
+#define POW5_MAX_EXPONENT 308  ///< Largest power of five in pow5_table.
+
+/// @brief 128-bit approximations of 5^q for q in [POW5_MIN_EXPONENT, POW5_MAX_EXPONENT], most significant word first.
+/// @note Each entry is normalized so the top bit is set. Positive powers are truncated, negative powers are the
+/// reciprocal rounded up, as required by the Eisel-Lemire algorithm.
+extern const uint64_t pow5_table[POW5_MAX_EXPONENT - POW5_MIN_EXPONENT + 1][2];
+
+/// @brief Parses a decimal or hexadecimal floating constant as a float.
+/// @param begin Pointer to the first character of the constant.
+/// @param end Pointer one past the last character, parsing also stops at the first character that cannot continue
+/// the constant so a trailing suffix is ignored.
+/// @param value Pointer to the variable that receives the correctly rounded value.
+/// @return false if the value overflows to infinity or a nonzero value rounds to zero, true otherwise.
+bool parse_float(const char* begin, const char* end, float* value);
+
+/// @brief Parses a decimal or hexadecimal floating constant as a double.
+/// @param begin Pointer to the first character of the constant.
+/// @param end Pointer one past the last character, a trailing suffix is ignored.
+/// @param value Pointer to the variable that receives the correctly rounded value.
+/// @return false if the value overflows to infinity or a nonzero value rounds to zero, true otherwise.
+bool parse_double(const char* begin, const char* end, double* value);
+
+/// @brief Parses a decimal or hexadecimal floating constant as a long double.
+/// @param begin Pointer to the first character of the constant.
+/// @param end Pointer one past the last character, a trailing suffix is ignored.
+/// @param value Pointer to the variable that receives the correctly rounded value.
+/// @return false if the value overflows to infinity or a nonzero value rounds to zero, true otherwise.
+/// @note Long doubles with more than 64 significand bits (IEEE quad, double-double) are handed to strtold().
+bool parse_long_double(const char* begin, const char* end, long double* value);
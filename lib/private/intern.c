@@ -0,0 +1,95 @@
+#include "intern.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define INITIAL_CAPACITY 256
+#define EMPTY_SYMBOL     UINT32_MAX
+
+// first empty slot on the probe sequence of a hash
+static size_t find_empty_slot(const struct intern_table* table, uint32_t hash) {
+    const size_t mask = table->capacity - 1;
+    size_t i          = hash & mask;
+    while (table->slots[i].symbol != EMPTY_SYMBOL) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void resize(struct intern_table* table, size_t capacity) {
+    struct intern_entry* old_slots = table->slots;
+    const size_t old_capacity      = table->capacity;
+
+    table->slots = malloc(sizeof(*table->slots) * capacity);
+    if (!table->slots) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(table->slots, 0xFF, sizeof(*table->slots) * capacity);
+    table->capacity = capacity;
+
+    // the stored hashes are enough to place every entry, no name is touched
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old_slots[i].symbol != EMPTY_SYMBOL) {
+            table->slots[find_empty_slot(table, old_slots[i].hash)] = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+void intern_table_create(struct intern_table* table) {
+    assert(table);
+    memset(table, 0, sizeof(*table));
+}
+
+void intern_table_destroy(struct intern_table* table) {
+    assert(table);
+    free(table->slots);
+    free(table->names);
+    memset(table, 0, sizeof(*table));
+}
+
+uint32_t intern_table_insert(struct intern_table* table,
+                             struct arena* arena,
+                             const char* str,
+                             size_t len,
+                             uint32_t hash) {
+    assert(table && arena && (str || len == 0));
+
+    if (table->capacity) {
+        const size_t mask = table->capacity - 1;
+        for (size_t i = hash & mask; table->slots[i].symbol != EMPTY_SYMBOL; i = (i + 1) & mask) {
+            const struct intern_entry entry = table->slots[i];
+            if (entry.hash == hash && table->names[entry.symbol].size == len &&
+                memcmp(table->names[entry.symbol].data, str, len) == 0) {
+                return entry.symbol;
+            }
+        }
+    }
+
+    assert(table->size < EMPTY_SYMBOL && "symbol space exhausted");
+
+    // keep the load factor at or below 3/4
+    if ((table->size + 1) * 4 > table->capacity * 3) {
+        resize(table, table->capacity ? table->capacity * 2 : INITIAL_CAPACITY);
+    }
+    if (table->size == table->names_capacity) {
+        table->names_capacity             = table->names_capacity ? table->names_capacity * 2 : INITIAL_CAPACITY;
+        struct mcc_string_view* new_names = realloc(table->names, sizeof(*table->names) * table->names_capacity);
+        if (!new_names) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        table->names = new_names;
+    }
+
+    char* name = arena_alloc(arena, len + 1);
+    memcpy(name, str, len);
+    name[len] = '\0';
+
+    const uint32_t symbol                      = (uint32_t)table->size++;
+    table->names[symbol]                       = (struct mcc_string_view){name, len};
+    table->slots[find_empty_slot(table, hash)] = (struct intern_entry){hash, symbol};
+    return symbol;
+}
@@ -0,0 +1,72 @@
+/// @file lib/private/intern.h
+/// @brief Identifier interning table.
+///
+/// Each distinct name is stored once and identified by a dense 32-bit symbol, assigned in order of first appearance
+/// starting at 0. The table is open addressed with linear probing and stores each name's hash next to its symbol, so
+/// lookups only touch the name on a full hash match and growing never rehashes a string.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "arena.h"
+#include "defs.h"
+
+#define INTERN_HASH_MULTIPLIER 0x517CC1B727220A95 ///< Odd 64-bit multiplier, the one FxHash uses.
+
+struct intern_entry {
+    uint32_t hash;
+    uint32_t symbol; // UINT32_MAX marks an empty slot
+};
+
+struct intern_table {
+    struct intern_entry* slots;    // open addressed, capacity is a power of two
+    size_t capacity;               // number of slots
+    struct mcc_string_view* names; // name of each symbol, indexed by symbol
+    size_t size;                   // number of symbols
+    size_t names_capacity;
+};
+
+/// @brief Hashes a name eight bytes at a time.
+/// @param str Pointer to the name.
+/// @param len Length of the name.
+/// @return A 32-bit hash of the name.
+/// @note Meant to run right after the identifier scan, while its bytes are still in L1.
+static inline uint32_t intern_hash(const char* str, size_t len) {
+    uint64_t hash = 0;
+    uint64_t word;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        memcpy(&word, str + i, 8);
+        hash = ((hash << 5 | hash >> 59) ^ word) * INTERN_HASH_MULTIPLIER;
+    }
+    if (i < len) {
+        word = 0;
+        memcpy(&word, str + i, len - i);
+        hash = ((hash << 5 | hash >> 59) ^ word) * INTERN_HASH_MULTIPLIER;
+    }
+    hash = ((hash << 5 | hash >> 59) ^ len) * INTERN_HASH_MULTIPLIER;
+    return (uint32_t)(hash >> 32);
+}
+
+/// @brief Initializes an empty table, no memory is allocated until the first intern_table_insert().
+/// @param table Pointer to the table to initialize.
+void intern_table_create(struct intern_table* table);
+
+/// @brief Releases the table's slot and name arrays, the names themselves live in the arena.
+/// @param table Pointer to the table to destroy.
+void intern_table_destroy(struct intern_table* table);
+
+/// @brief Looks a name up, adding it if it is new.
+/// @param table Pointer to the table.
+/// @param arena Arena new names are copied into, null-terminated.
+/// @param str Pointer to the name, need not be null-terminated.
+/// @param len Length of the name.
+/// @param hash intern_hash() of the name.
+/// @return The name's symbol.
+uint32_t intern_table_insert(struct intern_table* table,
+                             struct arena* arena,
+                             const char* str,
+                             size_t len,
+                             uint32_t hash);
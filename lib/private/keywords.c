@@ -0,0 +1,41 @@
+#include "keywords.h"
+
+const struct keyword_entry keyword_hash_table[KEYWORD_HASH_SLOTS] = {
+    [ 3] = {"goto",        4, MCC_KEYWORD_GOTO},
+    [ 6] = {"if",          2, MCC_KEYWORD_IF},
+    [ 7] = {"short",       5, MCC_KEYWORD_SHORT},
+    [ 8] = {"sizeof",      6, MCC_KEYWORD_SIZEOF},
+    [11] = {"switch",      6, MCC_KEYWORD_SWITCH},
+    [12] = {"void",        4, MCC_KEYWORD_VOID},
+    [13] = {"struct",      6, MCC_KEYWORD_STRUCT},
+    [16] = {"else",        4, MCC_KEYWORD_ELSE},
+    [19] = {"inline",      6, MCC_KEYWORD_INLINE},
+    [21] = {"while",       5, MCC_KEYWORD_WHILE},
+    [22] = {"static",      6, MCC_KEYWORD_STATIC},
+    [23] = {"continue",    8, MCC_KEYWORD_CONTINUE},
+    [24] = {"default",     7, MCC_KEYWORD_DEFAULT},
+    [27] = {"restrict",    8, MCC_KEYWORD_RESTRICT},
+    [28] = {"return",      6, MCC_KEYWORD_RETURN},
+    [30] = {"_Complex",    8, MCC_KEYWORD_COMPLEX},
+    [32] = {"for",         3, MCC_KEYWORD_FOR},
+    [34] = {"case",        4, MCC_KEYWORD_CASE},
+    [38] = {"break",       5, MCC_KEYWORD_BREAK},
+    [39] = {"unsigned",    8, MCC_KEYWORD_UNSIGNED},
+    [41] = {"volatile",    8, MCC_KEYWORD_VOLATILE},
+    [42] = {"double",      6, MCC_KEYWORD_DOUBLE},
+    [43] = {"signed",      6, MCC_KEYWORD_SIGNED},
+    [44] = {"do",          2, MCC_KEYWORD_DO},
+    [45] = {"extern",      6, MCC_KEYWORD_EXTERN},
+    [46] = {"_Imaginary", 10, MCC_KEYWORD_IMAGINARY},
+    [47] = {"typedef",     7, MCC_KEYWORD_TYPEDEF},
+    [49] = {"long",        4, MCC_KEYWORD_LONG},
+    [50] = {"char",        4, MCC_KEYWORD_CHAR},
+    [51] = {"int",         3, MCC_KEYWORD_INT},
+    [54] = {"const",       5, MCC_KEYWORD_CONST},
+    [55] = {"enum",        4, MCC_KEYWORD_ENUM},
+    [56] = {"float",       5, MCC_KEYWORD_FLOAT},
+    [59] = {"_Bool",       5, MCC_KEYWORD_BOOL},
+    [61] = {"union",       5, MCC_KEYWORD_UNION},
+    [62] = {"register",    8, MCC_KEYWORD_REGISTER},
+    [63] = {"auto",        4, MCC_KEYWORD_AUTO},
+};
@@ -0,0 +1,50 @@
+/// @file lib/private/keywords.h
+/// @brief Perfect hash lookup for C99 keywords.
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include "lexer.h"
+
+#define KEYWORD_MIN_LEN    2  ///< Length of the shortest keyword ("do", "if").
+#define KEYWORD_MAX_LEN    10 ///< Length of the longest keyword ("_Imaginary").
+#define KEYWORD_HASH_BITS  6
+#define KEYWORD_HASH_SLOTS (1 << KEYWORD_HASH_BITS)
+
+struct keyword_entry {
+    const char* key;
+    size_t len;
+    enum mcc_keyword value;
+};
+
+/// @brief Hash table indexed by keyword_hash(), empty slots have a len of 0.
+extern const struct keyword_entry keyword_hash_table[KEYWORD_HASH_SLOTS];
+
+/// @brief Collision-free hash over the 37 C99 keywords.
+/// @param str Pointer to the identifier, must be at least KEYWORD_MIN_LEN characters long.
+/// @param len Length of the identifier.
+/// @return A slot index in [0, KEYWORD_HASH_SLOTS).
+/// @note The first, second and last character are packed with the length and run through a multiplicative hash. The
+/// multiplier was found by search, if the keyword set ever changes a new one must be picked.
+static inline unsigned keyword_hash(const char* str, size_t len) {
+    const uint32_t key = (uint32_t)(unsigned char)str[0] | (uint32_t)(unsigned char)str[1] << 8 |
+                         (uint32_t)(unsigned char)str[len - 1] << 16 | (uint32_t)len << 24;
+    return (unsigned)((uint32_t)(key * UINT32_C(0xE8E63A4F)) >> (32 - KEYWORD_HASH_BITS));
+}
+
+/// @brief Looks up a keyword with a single probe of the perfect hash table.
+/// @param str Pointer to the identifier (not null-terminated).
+/// @param len Length of the identifier.
+/// @return The keyword, or MCC_KEYWORD_NOT_FOUND if the identifier is not a keyword.
+static inline enum mcc_keyword keyword_lookup(const char* str, size_t len) {
+    if (len < KEYWORD_MIN_LEN || len > KEYWORD_MAX_LEN) {
+        return MCC_KEYWORD_NOT_FOUND;
+    }
+    const struct keyword_entry* entry = &keyword_hash_table[keyword_hash(str, len)];
+    if (entry->len != len || memcmp(entry->key, str, len) != 0) {
+        return MCC_KEYWORD_NOT_FOUND;
+    }
+    return entry->value;
+}
@@ -0,0 +1,118 @@
+#include "pool.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "thread.h"
+
+// the jobs a worker has left, the owner takes from the front and thieves from the back
+struct deque {
+    size_t front;
+    size_t back;
+    struct mutex lock;
+};
+
+struct pool {
+    struct deque* deques;
+    size_t threads;
+    pool_job_fn fn;
+    void* arg;
+};
+
+struct worker {
+    struct pool* pool;
+    size_t index;
+    struct thread thread;
+};
+
+static bool take_front(struct deque* deque, size_t* job) {
+    mutex_lock(&deque->lock);
+    const bool found = deque->front < deque->back;
+    if (found) {
+        *job = deque->front++;
+    }
+    mutex_unlock(&deque->lock);
+    return found;
+}
+
+static bool take_back(struct deque* deque, size_t* job) {
+    mutex_lock(&deque->lock);
+    const bool found = deque->front < deque->back;
+    if (found) {
+        *job = --deque->back;
+    }
+    mutex_unlock(&deque->lock);
+    return found;
+}
+
+// no job is added once the pool runs, so a pass over every deque that finds nothing means the work is done
+static bool steal(struct pool* pool, size_t thief, size_t* job) {
+    for (size_t i = 1; i < pool->threads; i++) {
+        if (take_back(&pool->deques[(thief + i) % pool->threads], job)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void work(void* arg) {
+    struct worker* worker = arg;
+    struct pool* pool     = worker->pool;
+
+    size_t job;
+    while (take_front(&pool->deques[worker->index], &job) || steal(pool, worker->index, &job)) {
+        pool->fn(pool->arg, job);
+    }
+}
+
+void pool_run(size_t count, size_t threads, pool_job_fn fn, void* arg) {
+    assert(fn);
+    if (count == 0) {
+        return;
+    }
+    if (threads > count) {
+        threads = count;
+    }
+    if (threads < 2) {
+        for (size_t i = 0; i < count; i++) {
+            fn(arg, i);
+        }
+        return;
+    }
+
+    struct pool pool = {
+        .deques  = malloc(sizeof(struct deque) * threads),
+        .threads = threads,
+        .fn      = fn,
+        .arg     = arg,
+    };
+    struct worker* workers = malloc(sizeof(struct worker) * threads);
+    if (!pool.deques || !workers) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        pool.deques[i].front = count * i / threads;
+        pool.deques[i].back  = count * (i + 1) / threads;
+        mutex_create(&pool.deques[i].lock);
+
+        workers[i].pool  = &pool;
+        workers[i].index = i;
+    }
+
+    for (size_t i = 1; i < threads; i++) {
+        thread_start(&workers[i].thread, work, &workers[i]);
+    }
+    work(&workers[0]); // the calling thread works too
+    for (size_t i = 1; i < threads; i++) {
+        thread_join(&workers[i].thread);
+    }
+
+    for (size_t i = 0; i < threads; i++) {
+        mutex_destroy(&pool.deques[i].lock);
+    }
+    free(workers);
+    free(pool.deques);
+}
@@ -0,0 +1,21 @@
+/// @file lib/private/pool.h
+/// @brief Work-stealing thread pool for running a fixed set of independent jobs.
+
+#pragma once
+
+#include <stddef.h>
+
+/// @brief Runs one job.
+/// @param arg The argument passed to pool_run().
+/// @param job Index of the job, less than the job count.
+typedef void (*pool_job_fn)(void* arg, size_t job);
+
+/// @brief Runs jobs 0 to count - 1 across threads and waits for all of them.
+/// @param count Number of jobs.
+/// @param threads Number of threads, the calling thread included. Clamped to [1, count].
+/// @param fn Function to run every job with.
+/// @param arg Argument passed to fn.
+/// @note Each thread starts on its own contiguous range of jobs and, once that is drained, steals single jobs from
+///       the back of the other ranges, so a few slow jobs do not leave the other threads idle. The order jobs run in
+///       is unspecified, callers that need ordered results must store them per job.
+void pool_run(size_t count, size_t threads, pool_job_fn fn, void* arg);
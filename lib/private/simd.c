@@ -0,0 +1,454 @@
+#include "simd.h"
+
+#include <stddef.h>
+#include "charclass.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define SIMD_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_AVX2
+#endif
+
+typedef size_t (*span_fn)(const char* begin, const char* end);
+typedef size_t (*count_fn)(const char* begin, const char* end, char c);
+typedef size_t (*pair_fn)(const char* begin, const char* end, char first, char second, char alternative);
+typedef size_t (*any_fn)(const char* begin, const char* end, char a, char b, char c, char d);
+typedef void (*widen_fn)(const char* begin, const char* end, wchar_t* out);
+
+// =============================================================================
+// Scalar
+// =============================================================================
+
+static size_t span_whitespace_scalar(const char* begin, const char* end) {
+    const char* p = begin;
+    while (p < end && is_space(*p)) {
+        p++;
+    }
+    return (size_t)(p - begin);
+}
+
+static size_t span_ident_scalar(const char* begin, const char* end) {
+    const char* p = begin;
+    while (p < end && is_ident(*p)) {
+        p++;
+    }
+    return (size_t)(p - begin);
+}
+
+static size_t count_byte_scalar(const char* begin, const char* end, char c) {
+    size_t count = 0;
+    for (const char* p = begin; p < end; p++) {
+        count += (size_t)(*p == c);
+    }
+    return count;
+}
+
+// first byte equal to first followed by one equal to second or alternative
+static size_t find_pair_scalar(const char* begin, const char* end, char first, char second, char alternative) {
+    const char* p = begin;
+    while (end - p >= 2 && !(p[0] == first && (p[1] == second || p[1] == alternative))) {
+        p++;
+    }
+    return end - p >= 2 ? (size_t)(p - begin) : (size_t)(end - begin);
+}
+
+// first byte equal to any of a, b, c and d
+static size_t find_any_scalar(const char* begin, const char* end, char a, char b, char c, char d) {
+    const char* p = begin;
+    while (p < end && *p != a && *p != b && *p != c && *p != d) {
+        p++;
+    }
+    return (size_t)(p - begin);
+}
+
+static void widen_chars_scalar(const char* begin, const char* end, wchar_t* out) {
+    for (const char* p = begin; p < end; p++) {
+        *out++ = (wchar_t)(unsigned char)*p;
+    }
+}
+
+#ifdef SIMD_X86_64
+
+static unsigned count_trailing_zeros(unsigned x) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (unsigned)index;
+#else
+    return (unsigned)__builtin_ctz(x);
+#endif
+}
+
+// =============================================================================
+// SSE2
+// =============================================================================
+
+// unsigned (lo <= v <= lo + range) per byte lane
+static __m128i sse2_in_range(__m128i v, char lo, char range) {
+    const __m128i t = _mm_sub_epi8(v, _mm_set1_epi8(lo));
+    return _mm_cmpeq_epi8(_mm_min_epu8(t, _mm_set1_epi8(range)), t);
+}
+
+static __m128i sse2_whitespace_mask(__m128i v) {
+    return _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), sse2_in_range(v, '\t', '\r' - '\t'));
+}
+
+static __m128i sse2_ident_mask(__m128i v) {
+    const __m128i alpha = sse2_in_range(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z' - 'a');
+    const __m128i digit = sse2_in_range(v, '0', 9);
+    return _mm_or_si128(_mm_or_si128(alpha, digit), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+}
+
+static size_t span_whitespace_sse2(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 16) {
+        const __m128i v     = _mm_loadu_si128((const __m128i*)p);
+        const unsigned miss = ~(unsigned)_mm_movemask_epi8(sse2_whitespace_mask(v)) & 0xFFFFu;
+        if (miss) {
+            return (size_t)(p - begin) + count_trailing_zeros(miss);
+        }
+        p += 16;
+    }
+    return (size_t)(p - begin) + span_whitespace_scalar(p, end);
+}
+
+static size_t span_ident_sse2(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 16) {
+        const __m128i v     = _mm_loadu_si128((const __m128i*)p);
+        const unsigned miss = ~(unsigned)_mm_movemask_epi8(sse2_ident_mask(v)) & 0xFFFFu;
+        if (miss) {
+            return (size_t)(p - begin) + count_trailing_zeros(miss);
+        }
+        p += 16;
+    }
+    return (size_t)(p - begin) + span_ident_scalar(p, end);
+}
+
+static size_t count_byte_sse2(const char* begin, const char* end, char c) {
+    const __m128i needle = _mm_set1_epi8(c);
+    const char* p        = begin;
+    size_t count         = 0;
+    while (end - p >= 16) {
+        // matches are -1 per lane, subtracting them counts up to 255 per lane before the byte counters must be
+        // folded into 64-bit sums with psadbw
+        __m128i counters = _mm_setzero_si128();
+        for (int i = 0; i < 255 && end - p >= 16; i++, p += 16) {
+            const __m128i v = _mm_loadu_si128((const __m128i*)p);
+            counters        = _mm_sub_epi8(counters, _mm_cmpeq_epi8(v, needle));
+        }
+        const __m128i sums = _mm_sad_epu8(counters, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si64(sums) + (size_t)_mm_cvtsi128_si64(_mm_unpackhi_epi64(sums, sums));
+    }
+    return count + count_byte_scalar(p, end, c);
+}
+
+// compares every position with the byte at it and the byte after it, so 17 bytes are loaded for 16 candidates
+static size_t find_pair_sse2(const char* begin, const char* end, char first, char second, char alternative) {
+    const __m128i a = _mm_set1_epi8(first);
+    const __m128i b = _mm_set1_epi8(second);
+    const __m128i c = _mm_set1_epi8(alternative);
+    const char* p   = begin;
+    while (end - p >= 17) {
+        const __m128i here    = _mm_loadu_si128((const __m128i*)p);
+        const __m128i next    = _mm_loadu_si128((const __m128i*)(p + 1));
+        const __m128i follows = _mm_or_si128(_mm_cmpeq_epi8(next, b), _mm_cmpeq_epi8(next, c));
+        const unsigned hit    = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(here, a), follows));
+        if (hit) {
+            return (size_t)(p - begin) + count_trailing_zeros(hit);
+        }
+        p += 16;
+    }
+    return (size_t)(p - begin) + find_pair_scalar(p, end, first, second, alternative);
+}
+
+static size_t find_any_sse2(const char* begin, const char* end, char a, char b, char c, char d) {
+    const __m128i va = _mm_set1_epi8(a);
+    const __m128i vb = _mm_set1_epi8(b);
+    const __m128i vc = _mm_set1_epi8(c);
+    const __m128i vd = _mm_set1_epi8(d);
+    const char* p    = begin;
+    while (end - p >= 16) {
+        const __m128i v    = _mm_loadu_si128((const __m128i*)p);
+        const __m128i ab   = _mm_or_si128(_mm_cmpeq_epi8(v, va), _mm_cmpeq_epi8(v, vb));
+        const __m128i cd   = _mm_or_si128(_mm_cmpeq_epi8(v, vc), _mm_cmpeq_epi8(v, vd));
+        const unsigned hit = (unsigned)_mm_movemask_epi8(_mm_or_si128(ab, cd));
+        if (hit) {
+            return (size_t)(p - begin) + count_trailing_zeros(hit);
+        }
+        p += 16;
+    }
+    return (size_t)(p - begin) + find_any_scalar(p, end, a, b, c, d);
+}
+
+// zero-extends 16 bytes at a time through 16-bit lanes, only picked where wchar_t is 32 bits wide
+static void widen_chars_sse2(const char* begin, const char* end, wchar_t* out) {
+    const __m128i zero = _mm_setzero_si128();
+    const char* p      = begin;
+    while (end - p >= 16) {
+        const __m128i v  = _mm_loadu_si128((const __m128i*)p);
+        const __m128i lo = _mm_unpacklo_epi8(v, zero);
+        const __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i*)out, _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(out + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(out + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)(out + 12), _mm_unpackhi_epi16(hi, zero));
+        p += 16;
+        out += 16;
+    }
+    widen_chars_scalar(p, end, out);
+}
+
+// =============================================================================
+// AVX2
+// =============================================================================
+
+SIMD_TARGET_AVX2 static __m256i avx2_in_range(__m256i v, char lo, char range) {
+    const __m256i t = _mm256_sub_epi8(v, _mm256_set1_epi8(lo));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(t, _mm256_set1_epi8(range)), t);
+}
+
+SIMD_TARGET_AVX2 static size_t span_whitespace_avx2(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 32) {
+        const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i m =
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')), avx2_in_range(v, '\t', '\r' - '\t'));
+        const unsigned miss = ~(unsigned)_mm256_movemask_epi8(m);
+        if (miss) {
+            return (size_t)(p - begin) + count_trailing_zeros(miss);
+        }
+        p += 32;
+    }
+    return (size_t)(p - begin) + span_whitespace_sse2(p, end);
+}
+
+SIMD_TARGET_AVX2 static size_t span_ident_avx2(const char* begin, const char* end) {
+    const char* p = begin;
+    while (end - p >= 32) {
+        const __m256i v     = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i alpha = avx2_in_range(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z' - 'a');
+        const __m256i digit = avx2_in_range(v, '0', 9);
+        const __m256i m = _mm256_or_si256(_mm256_or_si256(alpha, digit), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+        const unsigned miss = ~(unsigned)_mm256_movemask_epi8(m);
+        if (miss) {
+            return (size_t)(p - begin) + count_trailing_zeros(miss);
+        }
+        p += 32;
+    }
+    return (size_t)(p - begin) + span_ident_sse2(p, end);
+}
+
+SIMD_TARGET_AVX2 static size_t count_byte_avx2(const char* begin, const char* end, char c) {
+    const __m256i needle = _mm256_set1_epi8(c);
+    const char* p        = begin;
+    size_t count         = 0;
+    while (end - p >= 32) {
+        __m256i counters = _mm256_setzero_si256();
+        for (int i = 0; i < 255 && end - p >= 32; i++, p += 32) {
+            const __m256i v = _mm256_loadu_si256((const __m256i*)p);
+            counters        = _mm256_sub_epi8(counters, _mm256_cmpeq_epi8(v, needle));
+        }
+        const __m256i sums = _mm256_sad_epu8(counters, _mm256_setzero_si256());
+        count += (size_t)_mm256_extract_epi64(sums, 0) + (size_t)_mm256_extract_epi64(sums, 1) +
+                 (size_t)_mm256_extract_epi64(sums, 2) + (size_t)_mm256_extract_epi64(sums, 3);
+    }
+    return count + count_byte_sse2(p, end, c);
+}
+
+SIMD_TARGET_AVX2 static size_t find_pair_avx2(const char* begin,
+                                              const char* end,
+                                              char first,
+                                              char second,
+                                              char alternative) {
+    const __m256i a = _mm256_set1_epi8(first);
+    const __m256i b = _mm256_set1_epi8(second);
+    const __m256i c = _mm256_set1_epi8(alternative);
+    const char* p   = begin;
+    while (end - p >= 33) {
+        const __m256i here    = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i next    = _mm256_loadu_si256((const __m256i*)(p + 1));
+        const __m256i follows = _mm256_or_si256(_mm256_cmpeq_epi8(next, b), _mm256_cmpeq_epi8(next, c));
+        const unsigned hit    = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(here, a), follows));
+        if (hit) {
+            return (size_t)(p - begin) + count_trailing_zeros(hit);
+        }
+        p += 32;
+    }
+    return (size_t)(p - begin) + find_pair_sse2(p, end, first, second, alternative);
+}
+
+SIMD_TARGET_AVX2 static size_t find_any_avx2(const char* begin, const char* end, char a, char b, char c, char d) {
+    const __m256i va = _mm256_set1_epi8(a);
+    const __m256i vb = _mm256_set1_epi8(b);
+    const __m256i vc = _mm256_set1_epi8(c);
+    const __m256i vd = _mm256_set1_epi8(d);
+    const char* p    = begin;
+    while (end - p >= 32) {
+        const __m256i v    = _mm256_loadu_si256((const __m256i*)p);
+        const __m256i ab   = _mm256_or_si256(_mm256_cmpeq_epi8(v, va), _mm256_cmpeq_epi8(v, vb));
+        const __m256i cd   = _mm256_or_si256(_mm256_cmpeq_epi8(v, vc), _mm256_cmpeq_epi8(v, vd));
+        const unsigned hit = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(ab, cd));
+        if (hit) {
+            return (size_t)(p - begin) + count_trailing_zeros(hit);
+        }
+        p += 32;
+    }
+    return (size_t)(p - begin) + find_any_sse2(p, end, a, b, c, d);
+}
+
+SIMD_TARGET_AVX2 static void widen_chars_avx2(const char* begin, const char* end, wchar_t* out) {
+    const char* p = begin;
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128((const __m128i*)p);
+        _mm256_storeu_si256((__m256i*)out, _mm256_cvtepu8_epi32(v));
+        _mm256_storeu_si256((__m256i*)(out + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(v, 8)));
+        p += 16;
+        out += 16;
+    }
+    widen_chars_scalar(p, end, out);
+}
+
+static int cpu_has_avx2(void) {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return 0;
+    }
+    __cpuid(info, 1);
+    const int osxsave = (info[2] >> 27) & 1;
+    if (!osxsave || (_xgetbv(0) & 0x6) != 0x6) { // OS must save XMM and YMM state
+        return 0;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] >> 5) & 1;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif // SIMD_X86_64
+
+// =============================================================================
+// Dispatch
+// =============================================================================
+
+static size_t span_whitespace_resolve(const char* begin, const char* end);
+static size_t span_ident_resolve(const char* begin, const char* end);
+static size_t count_byte_resolve(const char* begin, const char* end, char c);
+static size_t find_pair_resolve(const char* begin, const char* end, char first, char second, char alternative);
+static size_t find_any_resolve(const char* begin, const char* end, char a, char b, char c, char d);
+static void widen_chars_resolve(const char* begin, const char* end, wchar_t* out);
+
+// resolved on first call by whichever threads get there first, they all store the same values. The pointers are only
+// accessed atomically so that race is well defined
+static span_fn span_whitespace_impl = span_whitespace_resolve;
+static span_fn span_ident_impl      = span_ident_resolve;
+static count_fn count_byte_impl     = count_byte_resolve;
+static pair_fn find_pair_impl       = find_pair_resolve;
+static any_fn find_any_impl         = find_any_resolve;
+static widen_fn widen_chars_impl    = widen_chars_resolve;
+
+// relaxed, as nothing but the pointer is published. MSVC loads and stores aligned volatile pointers atomically
+#if defined(__GNUC__) || defined(__clang__)
+#define LOAD_IMPL(type, impl)         __atomic_load_n(&(impl), __ATOMIC_RELAXED)
+#define STORE_IMPL(type, impl, value) __atomic_store_n(&(impl), (value), __ATOMIC_RELAXED)
+#else
+#define LOAD_IMPL(type, impl)         (*(const volatile type*)&(impl))
+#define STORE_IMPL(type, impl, value) (*(volatile type*)&(impl) = (value))
+#endif
+
+static void resolve(void) {
+#ifdef SIMD_X86_64
+    if (cpu_has_avx2()) {
+        STORE_IMPL(span_fn, span_whitespace_impl, span_whitespace_avx2);
+        STORE_IMPL(span_fn, span_ident_impl, span_ident_avx2);
+        STORE_IMPL(count_fn, count_byte_impl, count_byte_avx2);
+        STORE_IMPL(pair_fn, find_pair_impl, find_pair_avx2);
+        STORE_IMPL(any_fn, find_any_impl, find_any_avx2);
+        STORE_IMPL(widen_fn, widen_chars_impl, sizeof(wchar_t) == 4 ? widen_chars_avx2 : widen_chars_scalar);
+    } else {
+        STORE_IMPL(span_fn, span_whitespace_impl, span_whitespace_sse2);
+        STORE_IMPL(span_fn, span_ident_impl, span_ident_sse2);
+        STORE_IMPL(count_fn, count_byte_impl, count_byte_sse2);
+        STORE_IMPL(pair_fn, find_pair_impl, find_pair_sse2);
+        STORE_IMPL(any_fn, find_any_impl, find_any_sse2);
+        STORE_IMPL(widen_fn, widen_chars_impl, sizeof(wchar_t) == 4 ? widen_chars_sse2 : widen_chars_scalar);
+    }
+#else
+    STORE_IMPL(span_fn, span_whitespace_impl, span_whitespace_scalar);
+    STORE_IMPL(span_fn, span_ident_impl, span_ident_scalar);
+    STORE_IMPL(count_fn, count_byte_impl, count_byte_scalar);
+    STORE_IMPL(pair_fn, find_pair_impl, find_pair_scalar);
+    STORE_IMPL(any_fn, find_any_impl, find_any_scalar);
+    STORE_IMPL(widen_fn, widen_chars_impl, widen_chars_scalar);
+#endif
+}
+
+static size_t span_whitespace_resolve(const char* begin, const char* end) {
+    resolve();
+    return LOAD_IMPL(span_fn, span_whitespace_impl)(begin, end);
+}
+
+static size_t span_ident_resolve(const char* begin, const char* end) {
+    resolve();
+    return LOAD_IMPL(span_fn, span_ident_impl)(begin, end);
+}
+
+static size_t count_byte_resolve(const char* begin, const char* end, char c) {
+    resolve();
+    return LOAD_IMPL(count_fn, count_byte_impl)(begin, end, c);
+}
+
+static size_t find_pair_resolve(const char* begin, const char* end, char first, char second, char alternative) {
+    resolve();
+    return LOAD_IMPL(pair_fn, find_pair_impl)(begin, end, first, second, alternative);
+}
+
+static size_t find_any_resolve(const char* begin, const char* end, char a, char b, char c, char d) {
+    resolve();
+    return LOAD_IMPL(any_fn, find_any_impl)(begin, end, a, b, c, d);
+}
+
+static void widen_chars_resolve(const char* begin, const char* end, wchar_t* out) {
+    resolve();
+    LOAD_IMPL(widen_fn, widen_chars_impl)(begin, end, out);
+}
+
+size_t span_whitespace(const char* begin, const char* end) {
+    return LOAD_IMPL(span_fn, span_whitespace_impl)(begin, end);
+}
+
+size_t span_ident(const char* begin, const char* end) {
+    return LOAD_IMPL(span_fn, span_ident_impl)(begin, end);
+}
+
+size_t count_byte(const char* begin, const char* end, char c) {
+    return LOAD_IMPL(count_fn, count_byte_impl)(begin, end, c);
+}
+
+size_t find_comment_end(const char* begin, const char* end) {
+    return LOAD_IMPL(pair_fn, find_pair_impl)(begin, end, '*', '/', '/');
+}
+
+size_t find_line_splice(const char* begin, const char* end) {
+    return LOAD_IMPL(pair_fn, find_pair_impl)(begin, end, '\\', '\n', '\r');
+}
+
+size_t find_literal_stop(const char* begin, const char* end, char quote) {
+    return LOAD_IMPL(any_fn, find_any_impl)(begin, end, quote, '\\', '\n', '\0');
+}
+
+void widen_chars(const char* begin, const char* end, wchar_t* out) {
+    LOAD_IMPL(widen_fn, widen_chars_impl)(begin, end, out);
+}
@@ -0,0 +1,58 @@
+/// @file lib/private/simd.h
+/// @brief Vectorized scanning and copying primitives with runtime CPU dispatch.
+///
+/// Each primitive has a portable scalar implementation and, on x86-64, SSE2 and AVX2 implementations. The widest
+/// implementation supported by the running CPU is picked on first use. Vector loads never read past the end pointer,
+/// so the primitives are safe on buffers that are not padded.
+
+#pragma once
+
+#include <stddef.h>
+#include <wchar.h>
+
+/// @brief Measures the run of whitespace characters (' ', '\\t', '\\n', '\\v', '\\f', '\\r') at the start of a range.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @return Number of leading whitespace characters in [begin, end).
+size_t span_whitespace(const char* begin, const char* end);
+
+/// @brief Measures the run of identifier characters ([A-Za-z0-9_]) at the start of a range.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @return Number of leading identifier characters in [begin, end).
+size_t span_ident(const char* begin, const char* end);
+
+/// @brief Counts the occurrences of a byte in a range.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @param c The byte to count.
+/// @return Number of characters in [begin, end) equal to c.
+size_t count_byte(const char* begin, const char* end, char c);
+
+/// @brief Finds the first "*" followed by "/", the end of a block comment.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @return Offset of the "*" of the first "*/" in [begin, end), or end - begin if there is none.
+size_t find_comment_end(const char* begin, const char* end);
+
+/// @brief Finds the first backslash followed by a newline or carriage return, a line splice candidate.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @return Offset of the backslash in [begin, end), or end - begin if there is none. A backslash followed by a carriage
+///         return is only a line splice if a newline follows, the caller checks.
+size_t find_line_splice(const char* begin, const char* end);
+
+/// @brief Finds the first byte that ends a run of plain characters in a string literal or character constant, where
+/// escape sequences start or a newline makes the literal invalid.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @param quote The closing quote, '"' or '\''.
+/// @return Offset of the first quote, backslash, newline or null character in [begin, end), or end - begin if there is
+///         none.
+size_t find_literal_stop(const char* begin, const char* end, char quote);
+
+/// @brief Copies a range of characters into wide characters, zero-extending each byte.
+/// @param begin Pointer to the first character of the range.
+/// @param end Pointer one past the last character of the range.
+/// @param out Pointer to room for end - begin wide characters.
+void widen_chars(const char* begin, const char* end, wchar_t* out);
@@ -0,0 +1,143 @@
+#include "splice.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "simd.h"
+
+void splice_map_create(struct splice_map* map) {
+    assert(map);
+    memset(map, 0, sizeof(*map));
+}
+
+void splice_map_destroy(struct splice_map* map) {
+    assert(map);
+    free(map->at);
+    free(map->removed);
+    memset(map, 0, sizeof(*map));
+}
+
+static void record(struct splice_map* map, size_t at, size_t length) {
+    if (map->count == map->capacity) {
+        map->capacity   = map->capacity ? map->capacity * 2 : 16;
+        size_t* offsets = realloc(map->at, sizeof(size_t) * map->capacity);
+        size_t* removed = realloc(map->removed, sizeof(size_t) * map->capacity);
+        if (!offsets || !removed) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+        map->at      = offsets;
+        map->removed = removed;
+    }
+    const size_t before        = map->count ? map->removed[map->count - 1] : map->forgotten_removed;
+    map->at[map->count]        = at;
+    map->removed[map->count++] = before + length;
+}
+
+size_t splice_lines(char* dst, const char* src, const char* end, size_t base, struct splice_map* map) {
+    assert(dst && src && end && map && (dst <= src || dst >= end));
+
+    size_t length = 0;
+    for (const char* p = src;;) {
+        const size_t n = find_line_splice(p, end);
+        if (p + n == end) {
+            memmove(dst + length, p, n);
+            return length + n;
+        }
+
+        // a backslash and carriage return only splice with the newline after them
+        const char* splice   = p + n;
+        const size_t spliced = splice[1] == '\n' ? 2 : (splice + 2 < end && splice[2] == '\n') ? 3 : 0;
+        if (!spliced) {
+            memmove(dst + length, p, n + 1);
+            length += n + 1;
+            p       = splice + 1;
+            continue;
+        }
+
+        memmove(dst + length, p, n);
+        length += n;
+        record(map, base + length, spliced);
+        p = splice + spliced;
+    }
+}
+
+// last splice at or before offset, count if there is none
+static size_t last_splice(const struct splice_map* map, size_t offset) {
+    size_t lo = 0;
+    size_t hi = map->count;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (map->at[mid] <= offset) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo ? lo - 1 : map->count;
+}
+
+void splice_map_replace(struct splice_map* map,
+                        size_t offset,
+                        size_t removed,
+                        const struct splice_map* inserted,
+                        size_t length) {
+    assert(map && inserted && map->forgotten == 0 && inserted->forgotten == 0);
+
+    // splices before the edit stay, those inside it go and those after it shift, the running totals are rebuilt
+    size_t first = 0;
+    while (first < map->count && map->at[first] <= offset) {
+        first++;
+    }
+    size_t last = first;
+    while (last < map->count && map->at[last] < offset + removed) {
+        last++;
+    }
+
+    struct splice_map result;
+    splice_map_create(&result);
+    for (size_t i = 0; i < first; i++) {
+        record(&result, map->at[i], map->removed[i] - (i ? map->removed[i - 1] : 0));
+    }
+    for (size_t i = 0; i < inserted->count; i++) {
+        record(&result, inserted->at[i], inserted->removed[i] - (i ? inserted->removed[i - 1] : 0));
+    }
+    for (size_t i = last; i < map->count; i++) {
+        record(&result, map->at[i] - removed + length, map->removed[i] - (i ? map->removed[i - 1] : 0));
+    }
+
+    splice_map_destroy(map);
+    *map = result;
+}
+
+size_t splice_original(const struct splice_map* map, size_t offset) {
+    assert(map);
+    const size_t k = last_splice(map, offset);
+    return offset + (k < map->count ? map->removed[k] : map->forgotten_removed);
+}
+
+size_t splice_count(const struct splice_map* map, size_t offset, size_t* line_start) {
+    assert(map && line_start);
+    const size_t k = last_splice(map, offset);
+    if (k < map->count) {
+        *line_start = map->at[k] + map->removed[k];
+        return map->forgotten + k + 1;
+    }
+    *line_start = map->forgotten ? map->forgotten_line_start : 0;
+    return map->forgotten;
+}
+
+void splice_map_forget(struct splice_map* map, size_t offset) {
+    assert(map);
+    const size_t k = last_splice(map, offset);
+    if (k == map->count) {
+        return;
+    }
+    map->forgotten_removed    = map->removed[k];
+    map->forgotten_line_start = map->at[k] + map->removed[k];
+    map->forgotten += k + 1;
+    map->count -= k + 1;
+    memmove(map->at, map->at + k + 1, sizeof(size_t) * map->count);
+    memmove(map->removed, map->removed + k + 1, sizeof(size_t) * map->count);
+}
@@ -0,0 +1,68 @@
+/// @file lib/private/splice.h
+/// @brief Line splicing, translation phase 2.
+///
+/// Every backslash directly followed by a newline (or a carriage return and newline) is deleted together with the line
+/// break, joining the two lines. The lexer works on the spliced text, a splice_map records where bytes were removed so
+/// offsets into the spliced text can be mapped back to the original text for diagnostics.
+
+#pragma once
+
+#include <stddef.h>
+
+struct splice_map {
+    size_t* at;                  // spliced offset each splice was removed at, ascending
+    size_t* removed;             // bytes removed by this splice and every splice before it
+    size_t count;
+    size_t capacity;
+    size_t forgotten;            // splices dropped by splice_map_forget()
+    size_t forgotten_removed;    // bytes removed by them
+    size_t forgotten_line_start; // original offset just past the last of them
+};
+
+/// @brief Initializes an empty map.
+/// @param map Pointer to the map to initialize.
+void splice_map_create(struct splice_map* map);
+
+/// @brief Releases the memory of a map.
+/// @param map Pointer to the map to destroy.
+void splice_map_destroy(struct splice_map* map);
+
+/// @brief Copies text with its line splices removed and records them.
+/// @param dst Pointer to the output, at least end - src bytes. It may be src itself, text is only ever moved forward.
+/// @param src Pointer to the first character of the text.
+/// @param end Pointer one past the last character of the text.
+/// @param base Spliced offset of dst, added to the offsets recorded in the map.
+/// @param map Pointer to the map to record the splices in, after any splice already in it.
+/// @return The length of the spliced text.
+size_t splice_lines(char* dst, const char* src, const char* end, size_t base, struct splice_map* map);
+
+/// @brief Updates a map for an edit of the spliced text.
+/// @param map Pointer to the map, it must not have forgotten splices.
+/// @param offset Spliced offset of the edit.
+/// @param removed Number of spliced bytes the edit removes, splices between them are dropped.
+/// @param inserted Pointer to the splices removed from the inserted text, recorded at their offsets after the edit.
+/// @param length Length of the inserted text once spliced, later splices shift by length - removed.
+void splice_map_replace(struct splice_map* map,
+                        size_t offset,
+                        size_t removed,
+                        const struct splice_map* inserted,
+                        size_t length);
+
+/// @brief Maps a spliced offset to the offset of the same character in the original text.
+/// @param map Pointer to the map.
+/// @param offset Spliced offset, at or past the last forgotten splice.
+/// @return The original offset.
+size_t splice_original(const struct splice_map* map, size_t offset);
+
+/// @brief Counts the splices removed at or before a spliced offset, each of which ended a line of the original text.
+/// @param map Pointer to the map.
+/// @param offset Spliced offset.
+/// @param line_start Pointer to a variable where the original offset just past the last of them is stored, 0 if there
+///                   is none.
+/// @return The number of splices, forgotten ones included.
+size_t splice_count(const struct splice_map* map, size_t offset, size_t* line_start);
+
+/// @brief Drops the splices at or before an offset, keeping only their totals.
+/// @param map Pointer to the map.
+/// @param offset Spliced offset, later queries must not ask about offsets before it.
+void splice_map_forget(struct splice_map* map, size_t offset);
@@ -0,0 +1,67 @@
+/// @file lib/private/stats.h
+/// @brief Instrumentation hooks behind MCC_STATS, see mcc_context_stats().
+///
+/// Every hook is a macro that expands to nothing unless MCC_STATS is defined, so the hot paths carry no trace of the
+/// counters in a normal build. A timed call is bracketed by STATS_START and STATS_STOP naming the same timer.
+
+#pragma once
+
+#include <stdint.h>
+#include "context.h"
+
+#ifdef MCC_STATS
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define STATS_RDTSC
+#else
+#include <time.h>
+#endif
+
+/// @brief The context's counters, for the hooks below.
+struct mcc_stats* context_stats(struct mcc_context* ctx);
+
+/// @brief A cycle count, or processor time in clock() ticks where there is no time stamp counter.
+static inline uint64_t stats_cycles(void) {
+#ifdef STATS_RDTSC
+    return (uint64_t)__rdtsc();
+#else
+    return (uint64_t)clock();
+#endif
+}
+
+#define STATS_START(timer) const uint64_t timer = stats_cycles()
+
+#define STATS_STOP(ctx, function, timer)                                    \
+    do {                                                                    \
+        struct mcc_stats* stats_ = context_stats(ctx);                      \
+        stats_->calls[function]++;                                          \
+        stats_->cycles[function] += stats_cycles() - (timer);               \
+    } while (0)
+
+#define STATS_TOKEN(ctx, token)                                             \
+    do {                                                                    \
+        struct mcc_stats* stats_ = context_stats(ctx);                      \
+        stats_->tokens[(token)->type + 1]++;                                \
+        stats_->bytes[(token)->type + 1] += (token)->lexeme.size;           \
+    } while (0)
+
+#define STATS_LITERAL(ctx, size)                                            \
+    do {                                                                    \
+        struct mcc_stats* stats_ = context_stats(ctx);                      \
+        stats_->stored_literals++;                                          \
+        stats_->stored_literal_bytes += (size);                             \
+    } while (0)
+
+#else
+
+#define STATS_START(timer)               ((void)0)
+#define STATS_STOP(ctx, function, timer) ((void)0)
+#define STATS_TOKEN(ctx, token)          ((void)0)
+#define STATS_LITERAL(ctx, size)         ((void)0)
+
+#endif
@@ -0,0 +1,111 @@
+#include "thread.h"
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+static DWORD WINAPI thread_main(LPVOID arg) {
+    struct thread* thread = arg;
+    thread->fn(thread->arg);
+    return 0;
+}
+
+void thread_start(struct thread* thread, thread_fn fn, void* arg) {
+    assert(thread && fn);
+    thread->fn     = fn;
+    thread->arg    = arg;
+    thread->handle = CreateThread(NULL, 0, thread_main, thread, 0, NULL);
+    if (!thread->handle) {
+        fprintf(stderr, "CreateThread: error %lu\n", GetLastError());
+        exit(EXIT_FAILURE);
+    }
+}
+
+void thread_join(struct thread* thread) {
+    assert(thread);
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+size_t thread_hardware_concurrency(void) {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (size_t)info.dwNumberOfProcessors : 1;
+}
+
+void mutex_create(struct mutex* mutex) {
+    assert(mutex);
+    InitializeCriticalSection(&mutex->section);
+}
+
+void mutex_destroy(struct mutex* mutex) {
+    assert(mutex);
+    DeleteCriticalSection(&mutex->section);
+}
+
+void mutex_lock(struct mutex* mutex) {
+    assert(mutex);
+    EnterCriticalSection(&mutex->section);
+}
+
+void mutex_unlock(struct mutex* mutex) {
+    assert(mutex);
+    LeaveCriticalSection(&mutex->section);
+}
+
+#else
+
+static void* thread_main(void* arg) {
+    struct thread* thread = arg;
+    thread->fn(thread->arg);
+    return NULL;
+}
+
+void thread_start(struct thread* thread, thread_fn fn, void* arg) {
+    assert(thread && fn);
+    thread->fn      = fn;
+    thread->arg     = arg;
+    const int error = pthread_create(&thread->handle, NULL, thread_main, thread);
+    if (error) {
+        fprintf(stderr, "pthread_create: error %d\n", error);
+        exit(EXIT_FAILURE);
+    }
+}
+
+void thread_join(struct thread* thread) {
+    assert(thread);
+    pthread_join(thread->handle, NULL);
+}
+
+size_t thread_hardware_concurrency(void) {
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+void mutex_create(struct mutex* mutex) {
+    assert(mutex);
+    pthread_mutex_init(&mutex->handle, NULL);
+}
+
+void mutex_destroy(struct mutex* mutex) {
+    assert(mutex);
+    pthread_mutex_destroy(&mutex->handle);
+}
+
+void mutex_lock(struct mutex* mutex) {
+    assert(mutex);
+    pthread_mutex_lock(&mutex->handle);
+}
+
+void mutex_unlock(struct mutex* mutex) {
+    assert(mutex);
+    pthread_mutex_unlock(&mutex->handle);
+}
+
+#endif
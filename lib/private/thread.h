@@ -0,0 +1,64 @@
+/// @file lib/private/thread.h
+/// @brief Minimal threads and mutexes over pthreads or the Win32 API.
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+/// @brief Entry point of a thread started with thread_start().
+typedef void (*thread_fn)(void* arg);
+
+struct thread {
+#ifdef _WIN32
+    HANDLE handle;
+#else
+    pthread_t handle;
+#endif
+    thread_fn fn;
+    void* arg;
+};
+
+struct mutex {
+#ifdef _WIN32
+    CRITICAL_SECTION section;
+#else
+    pthread_mutex_t handle;
+#endif
+};
+
+/// @brief Starts a thread running fn(arg).
+/// @param thread Pointer to the thread, it must stay valid until thread_join().
+/// @param fn Function to run.
+/// @param arg Argument passed to fn.
+/// @note Exits on failure, like an allocation failure.
+void thread_start(struct thread* thread, thread_fn fn, void* arg);
+
+/// @brief Waits for a thread started with thread_start() to return.
+/// @param thread Pointer to the thread.
+void thread_join(struct thread* thread);
+
+/// @brief Counts the processors available to the process.
+/// @return The number of online processors, at least 1.
+size_t thread_hardware_concurrency(void);
+
+/// @brief Initializes an unlocked mutex.
+/// @param mutex Pointer to the mutex to initialize.
+void mutex_create(struct mutex* mutex);
+
+/// @brief Releases a mutex, it must not be locked.
+/// @param mutex Pointer to the mutex to destroy.
+void mutex_destroy(struct mutex* mutex);
+
+/// @brief Locks a mutex, blocking until it is available.
+/// @param mutex Pointer to the mutex.
+void mutex_lock(struct mutex* mutex);
+
+/// @brief Unlocks a mutex held by the calling thread.
+/// @param mutex Pointer to the mutex.
+void mutex_unlock(struct mutex* mutex);
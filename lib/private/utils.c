@@ -1,16 +1,33 @@
 #include "utils.h"
 
+#include <errno.h>
+#include <limits.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <share.h>
+#include <sys/stat.h>
+#endif
 
 char* read_file(const char* path, size_t* bytes_read) {
     FILE* file   = NULL;
     char* buffer = NULL;
 
     file = fopen(path, "rb");
-    if (!file) { // "rb" for binary mode
-        perror("fopen");
+    if (!file) { // "rb" for binary mode, a file that cannot be opened is left for the caller to report
         goto l_abort;
     }
 
@@ -51,3 +68,169 @@ l_abort:
     free(buffer);
     return NULL;
 }
+
+size_t read_fd(int fd, char* buffer, size_t size) {
+    size_t total = 0;
+    while (total < size) { // pipes hand out whatever has been written so far, keep reading until full
+#ifdef _WIN32
+        const size_t chunk = size - total < INT_MAX ? size - total : INT_MAX;
+        const int n        = _read(fd, buffer + total, (unsigned)chunk);
+#else
+        const ssize_t n = read(fd, buffer + total, size - total);
+#endif
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("read");
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        total += (size_t)n;
+    }
+    return total;
+}
+
+#ifdef HAVE_MMAP
+// reads fd to its end into a buffer that doubles as it fills, for pipes and devices whose size is not known up front
+static char* read_all_fd(int fd, size_t* bytes_read) {
+    size_t capacity = 64 * 1024;
+    size_t length   = 0;
+    char* buffer    = malloc(capacity + 1);
+    if (!buffer) {
+        perror("malloc");
+        return NULL;
+    }
+
+    for (;;) {
+        const size_t wanted = capacity - length;
+        const size_t got    = read_fd(fd, buffer + length, wanted);
+        length += got;
+        if (got < wanted) {
+            break;
+        }
+        capacity *= 2;
+        char* grown = realloc(buffer, capacity + 1);
+        if (!grown) {
+            perror("realloc");
+            free(buffer);
+            return NULL;
+        }
+        buffer = grown;
+    }
+    buffer[length] = '\0';
+
+    *bytes_read = length;
+    return buffer;
+}
+#endif
+
+bool write_file_atomic(const char* path, const void* data, size_t size) {
+    char temporary[4096];
+    if (snprintf(temporary, sizeof(temporary), "%s.XXXXXX", path) >= (int)sizeof(temporary)) {
+        errno = ENAMETOOLONG;
+        return false;
+    }
+
+    // the name is picked and the file created exclusively in one step, so no other writer can end up sharing it
+#ifdef _WIN32
+    int fd = -1;
+    if (_mktemp_s(temporary, strlen(temporary) + 1) != 0 ||
+        _sopen_s(&fd, temporary, _O_CREAT | _O_EXCL | _O_WRONLY | _O_BINARY, _SH_DENYNO, _S_IREAD | _S_IWRITE) != 0) {
+        return false;
+    }
+    FILE* file = _fdopen(fd, "wb");
+#else
+    const int fd = mkstemp(temporary);
+    if (fd < 0) {
+        return false;
+    }
+    FILE* file = fdopen(fd, "wb");
+#endif
+    if (!file) {
+#ifdef _WIN32
+        _close(fd);
+#else
+        close(fd);
+#endif
+        remove(temporary);
+        return false;
+    }
+    const bool written = fwrite(data, 1, size, file) == size;
+    if (fclose(file) != 0 || !written) {
+        remove(temporary);
+        return false;
+    }
+#ifdef _WIN32
+    remove(path); // rename does not replace an existing file here
+#endif
+    if (rename(temporary, path) != 0) {
+        remove(temporary);
+        return false;
+    }
+    return true;
+}
+
+char* map_file(const char* path, size_t* size, size_t* mapping_size) {
+#ifdef HAVE_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) { // left for the caller to report, a missing file is a user error
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("fstat");
+        close(fd);
+        return NULL;
+    }
+    if (!S_ISREG(st.st_mode)) { // pipes and devices can be neither mapped nor measured, they are read as they come
+        char* data = read_all_fd(fd, size);
+        close(fd);
+        *mapping_size = 0;
+        return data;
+    }
+
+    const size_t file_size = (size_t)st.st_size;
+    const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+
+    // bytes past the end of the file in its last page read as zero, reserving one page more than the file needs
+    // covers files that end exactly on a page boundary, so there is always a '\0' behind the contents
+    const size_t length = (file_size / page_size + 1) * page_size;
+
+    char* data = mmap(NULL, length, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) {
+        perror("mmap");
+        close(fd);
+        return NULL;
+    }
+    if (file_size > 0 &&
+        mmap(data, file_size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+        perror("mmap");
+        munmap(data, length);
+        close(fd);
+        return NULL;
+    }
+    close(fd);
+
+    *size         = file_size;
+    *mapping_size = length;
+    return data;
+#else
+    *mapping_size = 0;
+    return read_file(path, size);
+#endif
+}
+
+void unmap_file(char* data, size_t mapping_size) {
+#ifdef HAVE_MMAP
+    if (mapping_size) {
+        munmap(data, mapping_size);
+        return;
+    }
+#endif
+    (void)mapping_size;
+    free(data);
+}
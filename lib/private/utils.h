@@ -2,36 +2,48 @@
 
 #pragma once
 
-#include <ctype.h>
+#include <stdbool.h>
 #include <stddef.h>
 
 /// @brief Calculates the number of elements in a static array.
 #define ARRAY_SIZE(_Array) (sizeof(_Array) / sizeof(*_Array))
 
-/// @brief Checks if a character is an octal digit ('0' to '7').
-/// @param c The character to check, represented as an integer.
-/// @return Nonzero if the character is an octal digit; otherwise, zero.
-static inline int isodigit(int c) {
-    return (c >= '0' && c <= '7');
-}
-
-/// @brief Checks if a character is a valid starting character for an identifier.
-/// @param c The character to check, represented as an integer.
-/// @return Nonzero if the character is an underscore or an English letter (uppercase or lowercase); zero otherwise.
-static inline int isident_start(int c) {
-    return (isalpha(c) || c == '_');
-}
-
-/// @brief Checks if a character is a valid C identifier character (letter, digit, or underscore).
-/// @param c The character to check, represented as an integer.
-/// @return Nonzero if the character is a letter, digit, or underscore; zero otherwise.
-static inline int isident(int c) {
-    return (isalnum(c) || c == '_');
-}
-
 /// @brief Reads the contents of a file into a dynamically allocated buffer.
 /// @param path The path to the file to be read.
 /// @param bytes_read Pointer to a variable where the number of bytes read will be stored.
 /// @return A pointer to a buffer containing the file's contents, or NULL if the file could not be read. The caller is
 /// responsible for freeing the buffer.
+/// @note A file that cannot be opened is not reported, errno tells why. Other failures are reported with perror().
 char* read_file(const char* path, size_t* bytes_read);
+
+/// @brief Reads from a file descriptor until a buffer is full or the input ends.
+/// @param fd The file descriptor to read from.
+/// @param buffer Pointer to the buffer to fill.
+/// @param size Number of bytes to read.
+/// @return The number of bytes read, less than size only at the end of the input or on a read error, which is reported
+///         with perror().
+size_t read_fd(int fd, char* buffer, size_t size);
+
+/// @brief Replaces a file with new contents so that readers see either the old file or the whole new one.
+/// @param path The path to the file to write.
+/// @param data Pointer to the contents.
+/// @param size Number of bytes to write.
+/// @return true on success. The contents are written to a temporary file next to path, created under a unique name,
+///         and renamed over path. On failure the temporary file is removed and nothing is reported, errno tells why.
+bool write_file_atomic(const char* path, const void* data, size_t size);
+
+/// @brief Maps a file into memory with a guaranteed null terminator after its contents.
+/// @param path The path to the file to be mapped.
+/// @param size Pointer to a variable where the file size will be stored.
+/// @param mapping_size Pointer to a variable where the size of the mapping will be stored, pass it to unmap_file().
+/// @return A pointer to the file's contents followed by at least one '\0', or NULL if the file could not be mapped.
+/// @note Pipes, devices and files on platforms without mmap are read into a heap buffer instead, unmap_file() handles
+///       both.
+/// @note A file that cannot be opened is not reported, errno tells why. Other failures are reported with perror().
+/// @note The mapping is read-only, the lexer never writes into its source.
+char* map_file(const char* path, size_t* size, size_t* mapping_size);
+
+/// @brief Releases a mapping returned by map_file().
+/// @param data The pointer returned by map_file().
+/// @param mapping_size The mapping size returned by map_file().
+void unmap_file(char* data, size_t mapping_size);
@@ -0,0 +1,159 @@
+#include "token_buffer.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lexer.h"
+
+#define INITIAL_CAPACITY 64
+
+static void* resize(void* array, size_t capacity, size_t element_size) {
+    void* new_array = realloc(array, capacity * element_size);
+    if (!new_array) {
+        perror("realloc");
+        exit(EXIT_FAILURE);
+    }
+    return new_array;
+}
+
+static void* grow(void* array, size_t* capacity, size_t element_size) {
+    *capacity = *capacity ? *capacity * 2 : INITIAL_CAPACITY;
+    return resize(array, *capacity, element_size);
+}
+
+static uint32_t push_constant(struct mcc_token_buffer* buffer, struct mcc_constant constant) {
+    if (buffer->constants_size == buffer->constants_capacity) {
+        buffer->constants = grow(buffer->constants, &buffer->constants_capacity, sizeof(*buffer->constants));
+    }
+    buffer->constants[buffer->constants_size] = constant;
+    return (uint32_t)buffer->constants_size++;
+}
+
+static uint32_t push_string_literal(struct mcc_token_buffer* buffer, struct mcc_string_literal string_literal) {
+    if (buffer->string_literals_size == buffer->string_literals_capacity) {
+        buffer->string_literals =
+            grow(buffer->string_literals, &buffer->string_literals_capacity, sizeof(*buffer->string_literals));
+    }
+    buffer->string_literals[buffer->string_literals_size] = string_literal;
+    return (uint32_t)buffer->string_literals_size++;
+}
+
+static uint32_t push_error_message(struct mcc_token_buffer* buffer, const char* error_message) {
+    if (buffer->error_messages_size == buffer->error_messages_capacity) {
+        buffer->error_messages =
+            grow(buffer->error_messages, &buffer->error_messages_capacity, sizeof(*buffer->error_messages));
+    }
+    buffer->error_messages[buffer->error_messages_size] = error_message;
+    return (uint32_t)buffer->error_messages_size++;
+}
+
+void mcc_token_buffer_create(char* source, struct mcc_token_buffer* buffer) {
+    assert(source && buffer);
+    memset(buffer, 0, sizeof(*buffer));
+    buffer->source = source;
+}
+
+void mcc_token_buffer_destroy(struct mcc_token_buffer* buffer) {
+    assert(buffer);
+    free(buffer->kinds);
+    free(buffer->offsets);
+    free(buffer->lengths);
+    free(buffer->values);
+    free(buffer->constants);
+    free(buffer->string_literals);
+    free(buffer->error_messages);
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+void mcc_token_buffer_push(struct mcc_token_buffer* buffer, const struct mcc_token* token) {
+    assert(buffer && token);
+    assert(token->offset <= UINT32_MAX && token->lexeme.size <= UINT32_MAX && "token buffers are limited to 4 GiB");
+    assert(token->lexeme.data == buffer->source + token->offset && "token must come from the buffer's source");
+
+    if (buffer->size == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? buffer->capacity * 2 : INITIAL_CAPACITY;
+        buffer->kinds    = resize(buffer->kinds, buffer->capacity, sizeof(*buffer->kinds));
+        buffer->offsets  = resize(buffer->offsets, buffer->capacity, sizeof(*buffer->offsets));
+        buffer->lengths  = resize(buffer->lengths, buffer->capacity, sizeof(*buffer->lengths));
+        buffer->values   = resize(buffer->values, buffer->capacity, sizeof(*buffer->values));
+    }
+
+    uint32_t value = 0;
+    switch (token->type) {
+        case MCC_TOKEN_TYPE_EOF:
+            break;
+        case MCC_TOKEN_TYPE_IDENTIFIER:
+            value = token->value.identifier;
+            break;
+        case MCC_TOKEN_TYPE_KEYWORD:
+            value = (uint32_t)token->value.keyword;
+            break;
+        case MCC_TOKEN_TYPE_PUNCTUATOR:
+            value = (uint32_t)token->value.punctuator;
+            break;
+        case MCC_TOKEN_TYPE_CONSTANT:
+            value = push_constant(buffer, token->value.constant);
+            break;
+        case MCC_TOKEN_TYPE_STRING_LITERAL:
+            value = push_string_literal(buffer, token->value.string_literal);
+            break;
+        case MCC_TOKEN_TYPE_INVALID:
+            value = push_error_message(buffer, token->value.error_message);
+            break;
+    }
+
+    buffer->kinds[buffer->size]   = (uint8_t)token->type;
+    buffer->offsets[buffer->size] = (uint32_t)token->offset;
+    buffer->lengths[buffer->size] = (uint32_t)token->lexeme.size;
+    buffer->values[buffer->size]  = value;
+    buffer->size++;
+}
+
+void mcc_token_buffer_lex(struct mcc_token_buffer* buffer, struct mcc_lexer* lexer) {
+    assert(buffer && lexer && buffer->source == lexer->source);
+    struct mcc_token token;
+    do {
+        token = mcc_lexer_next_token(lexer);
+        mcc_token_buffer_push(buffer, &token);
+    } while (token.type != MCC_TOKEN_TYPE_EOF);
+}
+
+struct mcc_token mcc_token_buffer_get(const struct mcc_token_buffer* buffer, size_t index) {
+    assert(buffer && index < buffer->size);
+
+    const uint32_t offset = buffer->offsets[index];
+    const uint32_t value  = buffer->values[index];
+
+    struct mcc_token token = {
+        .type   = mcc_token_buffer_type(buffer, index),
+        .offset = offset,
+        .lexeme = {buffer->source + offset, buffer->lengths[index]},
+    };
+
+    switch (token.type) {
+        case MCC_TOKEN_TYPE_EOF:
+            break;
+        case MCC_TOKEN_TYPE_IDENTIFIER:
+            token.value.identifier = value;
+            break;
+        case MCC_TOKEN_TYPE_KEYWORD:
+            token.value.keyword = (enum mcc_keyword)value;
+            break;
+        case MCC_TOKEN_TYPE_PUNCTUATOR:
+            token.value.punctuator = (enum mcc_punctuator)value;
+            break;
+        case MCC_TOKEN_TYPE_CONSTANT:
+            token.value.constant = buffer->constants[value];
+            break;
+        case MCC_TOKEN_TYPE_STRING_LITERAL:
+            token.value.string_literal = buffer->string_literals[value];
+            break;
+        case MCC_TOKEN_TYPE_INVALID:
+            token.value.error_message = buffer->error_messages[value];
+            break;
+    }
+
+    return token;
+}
@@ -0,0 +1,67 @@
+/// @file lib/token_buffer.h
+/// @brief Compact structure-of-arrays token storage.
+///
+/// A token buffer stores a token stream as parallel arrays instead of an array of struct mcc_token. Each token costs
+/// one byte of kind, a 32-bit lexeme offset, a 32-bit lexeme length and a 32-bit value, 13 bytes in total. Keywords
+/// and punctuators keep their enum in the value and identifiers their symbol, constants, string literals and error
+/// messages live in side tables and the value holds their index. Full tokens are rebuilt on demand with
+/// mcc_token_buffer_get().
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include "lexer.h"
+
+struct mcc_token_buffer {
+    char* source;       // source the offsets are relative to, not owned
+    uint8_t* kinds;     // enum mcc_token_type per token
+    uint32_t* offsets;  // lexeme offset per token
+    uint32_t* lengths;  // lexeme length per token
+    uint32_t* values;   // keyword, punctuator, symbol or side table index per token
+    size_t size;        // number of tokens
+    size_t capacity;    // allocated tokens
+    struct mcc_constant* constants;
+    size_t constants_size;
+    size_t constants_capacity;
+    struct mcc_string_literal* string_literals;
+    size_t string_literals_size;
+    size_t string_literals_capacity;
+    const char** error_messages;
+    size_t error_messages_size;
+    size_t error_messages_capacity;
+};
+
+/// @brief Initializes an empty token buffer.
+/// @param source Source text the tokens will point into, must be smaller than 4 GiB.
+/// @param buffer Pointer to the token buffer to initialize.
+void mcc_token_buffer_create(char* source, struct mcc_token_buffer* buffer);
+
+/// @brief Releases the arrays owned by a token buffer.
+/// @param buffer Pointer to the token buffer to destroy.
+/// @note String literal data is owned by the context and stays valid.
+void mcc_token_buffer_destroy(struct mcc_token_buffer* buffer);
+
+/// @brief Appends a token to the buffer.
+/// @param buffer Pointer to the token buffer.
+/// @param token The token to append, its lexeme must point into the buffer's source.
+void mcc_token_buffer_push(struct mcc_token_buffer* buffer, const struct mcc_token* token);
+
+/// @brief Lexes the remaining input of a lexer into the buffer, up to and including the EOF token.
+/// @param buffer Pointer to the token buffer, created over the lexer's source.
+/// @param lexer Pointer to the lexer to drain.
+void mcc_token_buffer_lex(struct mcc_token_buffer* buffer, struct mcc_lexer* lexer);
+
+/// @brief Rebuilds the full token at an index.
+/// @param buffer Pointer to the token buffer.
+/// @param index Index of the token, must be less than buffer->size.
+/// @return The token as it was pushed.
+struct mcc_token mcc_token_buffer_get(const struct mcc_token_buffer* buffer, size_t index);
+
+/// @brief Reads the type of the token at an index without touching the other arrays.
+/// @param buffer Pointer to the token buffer.
+/// @param index Index of the token, must be less than buffer->size.
+/// @return The token's type.
+static inline enum mcc_token_type mcc_token_buffer_type(const struct mcc_token_buffer* buffer, size_t index) {
+    return (enum mcc_token_type)(int8_t)buffer->kinds[index];
+}
@@ -0,0 +1,425 @@
+#include "token_cache.h"
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "./private/intern.h"
+#include "./private/utils.h"
+#include "build_id.h"
+#include "context.h"
+
+#define CACHE_MAGIC  "mcctoks"  // 8 bytes with its '\0'
+#define CACHE_FORMAT 3          // bump whenever the layout below changes
+#define CACHE_ORDER  0x01020304 // reads differently on a machine of the other byte order
+
+struct cache_header {
+    char magic[8];
+    char version[16]; // MCC_VERSION, '\0' padded
+    char build[24];   // MCC_BUILD_ID, '\0' padded
+    uint32_t format;
+    uint32_t order;
+    uint32_t wchar_size;
+    uint32_t constant_size;
+    uint64_t source_length;
+    uint64_t token_count;
+    uint64_t constant_count;
+    uint64_t literal_count;
+    uint64_t name_count;
+    uint64_t blob_size; // string literal data and error messages
+    uint64_t checksum;  // content_hash() of everything after the source copy
+};
+
+// the sections follow the header in this order, each starting 16-byte aligned for the long double of a constant:
+//   source       char[source_length]       copy of the source the tokens were lexed from
+//   kinds        uint8_t[token_count]      enum mcc_token_type
+//   offsets      uint32_t[token_count]
+//   lengths      uint32_t[token_count]
+//   values       uint32_t[token_count]     keyword, punctuator, name, constant or literal index, or message offset
+//   constants    struct mcc_constant[constant_count]
+//   literals     struct cache_literal[literal_count]
+//   names        struct cache_name[name_count]
+//   blob         char[blob_size]
+
+struct cache_literal {
+    uint32_t type;   // enum mcc_string_literal_type
+    uint32_t unused;
+    uint64_t offset; // of the data in the blob, 16-byte aligned
+    uint64_t size;   // in characters, like the view
+};
+
+struct cache_name {
+    uint32_t offset; // of the name in the source
+    uint32_t length;
+};
+
+struct cache_layout {
+    size_t source;
+    size_t kinds;
+    size_t offsets;
+    size_t lengths;
+    size_t values;
+    size_t constants;
+    size_t literals;
+    size_t names;
+    size_t blob;
+    size_t size;
+};
+
+static size_t align16(size_t n) {
+    return (n + 15) & ~(size_t)15;
+}
+
+static struct cache_layout layout_of(const struct cache_header* header) {
+    struct cache_layout layout;
+    const size_t tokens = (size_t)header->token_count;
+    layout.source       = align16(sizeof(struct cache_header));
+    layout.kinds        = align16(layout.source + (size_t)header->source_length);
+    layout.offsets      = align16(layout.kinds + tokens);
+    layout.lengths      = align16(layout.offsets + tokens * sizeof(uint32_t));
+    layout.values       = align16(layout.lengths + tokens * sizeof(uint32_t));
+    layout.constants    = align16(layout.values + tokens * sizeof(uint32_t));
+    layout.literals     = align16(layout.constants + (size_t)header->constant_count * sizeof(struct mcc_constant));
+    layout.names        = align16(layout.literals + (size_t)header->literal_count * sizeof(struct cache_literal));
+    layout.blob         = align16(layout.names + (size_t)header->name_count * sizeof(struct cache_name));
+    layout.size         = layout.blob + (size_t)header->blob_size;
+    return layout;
+}
+
+static void fill_header(struct cache_header* header, size_t source_length) {
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, CACHE_MAGIC, sizeof(header->magic));
+    strncpy(header->version, MCC_VERSION, sizeof(header->version) - 1);
+    strncpy(header->build, MCC_BUILD_ID, sizeof(header->build) - 1);
+    header->format        = CACHE_FORMAT;
+    header->order         = CACHE_ORDER;
+    header->wchar_size    = sizeof(wchar_t);
+    header->constant_size = sizeof(struct mcc_constant);
+    header->source_length = source_length;
+}
+
+// FxHash-style, eight bytes at a time, for naming files. Equality is decided by comparing the sources
+static uint64_t content_hash(const char* data, size_t length) {
+    uint64_t hash = length;
+    uint64_t word;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+        memcpy(&word, data + i, 8);
+        hash = ((hash << 5 | hash >> 59) ^ word) * INTERN_HASH_MULTIPLIER;
+    }
+    if (i < length) {
+        word = 0;
+        memcpy(&word, data + i, length - i);
+        hash = ((hash << 5 | hash >> 59) ^ word) * INTERN_HASH_MULTIPLIER;
+    }
+    return hash;
+}
+
+bool mcc_token_cache_path(const struct mcc_lexer* lexer, const char* directory, char* path, size_t size) {
+    assert(lexer && lexer->source && directory && path);
+    const unsigned long long length = (unsigned long long)(lexer->end - lexer->source);
+    const unsigned long long hash   = content_hash(lexer->source, (size_t)length);
+    const int n                     = snprintf(path, size, "%s/%016llx-%llx.tok", directory, hash, length);
+    return n > 0 && (size_t)n < size;
+}
+
+// every index and offset is checked, a damaged file is a miss rather than a crash
+static bool load_mapped(struct mcc_lexer* lexer, const char* data, size_t size, struct mcc_token_array* tokens) {
+    const size_t length = (size_t)(lexer->end - lexer->source);
+    if (size < sizeof(struct cache_header)) {
+        return false;
+    }
+
+    struct cache_header header;
+    struct cache_header expected;
+    memcpy(&header, data, sizeof(header));
+    fill_header(&expected, length);
+    if (memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+        memcmp(header.version, expected.version, sizeof(header.version)) != 0 ||
+        memcmp(header.build, expected.build, sizeof(header.build)) != 0 || header.format != expected.format ||
+        header.order != expected.order || header.wchar_size != expected.wchar_size ||
+        header.constant_size != expected.constant_size || header.source_length != length || header.token_count == 0 ||
+        header.token_count > length + 1 || header.constant_count > header.token_count ||
+        header.literal_count > header.token_count || header.name_count > header.token_count ||
+        header.blob_size > size) {
+        return false;
+    }
+    const struct cache_layout layout = layout_of(&header);
+    if (layout.size != size || memcmp(data + layout.source, lexer->source, length) != 0 ||
+        content_hash(data + layout.kinds, size - layout.kinds) != header.checksum) {
+        return false;
+    }
+
+    const size_t count                       = (size_t)header.token_count;
+    const uint8_t* kinds                     = (const uint8_t*)(data + layout.kinds);
+    const uint32_t* offsets                  = (const uint32_t*)(data + layout.offsets);
+    const uint32_t* lengths                  = (const uint32_t*)(data + layout.lengths);
+    const uint32_t* values                   = (const uint32_t*)(data + layout.values);
+    const struct mcc_constant* constants     = (const struct mcc_constant*)(data + layout.constants);
+    const struct cache_literal* literals     = (const struct cache_literal*)(data + layout.literals);
+    const struct cache_name* names           = (const struct cache_name*)(data + layout.names);
+    char* blob                               = (char*)data + layout.blob;
+
+    // each distinct name is interned once, tokens only look their symbol up
+    uint32_t* symbols = malloc(sizeof(uint32_t) * (header.name_count ? (size_t)header.name_count : 1));
+    struct mcc_token* array = malloc(sizeof(struct mcc_token) * count);
+    if (!symbols || !array) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    bool valid = true;
+    for (size_t i = 0; valid && i < (size_t)header.name_count; i++) {
+        valid = names[i].offset <= length && names[i].length <= length - names[i].offset;
+        if (valid) {
+            symbols[i] = mcc_context_intern(lexer->ctx, lexer->source + names[i].offset, names[i].length);
+        }
+    }
+
+    for (size_t i = 0; valid && i < count; i++) {
+        const uint32_t value = values[i];
+        struct mcc_token* t  = &array[i];
+        valid                = offsets[i] <= length && lengths[i] <= length - offsets[i];
+        t->type              = (enum mcc_token_type)(int8_t)kinds[i];
+        t->offset            = offsets[i];
+        t->lexeme            = (struct mcc_string_view){lexer->source + offsets[i], lengths[i]};
+        switch (t->type) {
+            case MCC_TOKEN_TYPE_EOF:
+                valid = valid && i == count - 1;
+                break;
+            case MCC_TOKEN_TYPE_IDENTIFIER:
+                valid               = valid && value < header.name_count;
+                t->value.identifier = valid ? symbols[value] : 0;
+                break;
+            case MCC_TOKEN_TYPE_KEYWORD:
+                t->value.keyword = (enum mcc_keyword)value;
+                break;
+            case MCC_TOKEN_TYPE_PUNCTUATOR:
+                t->value.punctuator = (enum mcc_punctuator)value;
+                break;
+            case MCC_TOKEN_TYPE_CONSTANT:
+                valid             = valid && value < header.constant_count;
+                t->value.constant = valid ? constants[value] : (struct mcc_constant){0};
+                break;
+            case MCC_TOKEN_TYPE_STRING_LITERAL: {
+                valid = valid && value < header.literal_count;
+                if (!valid) {
+                    break;
+                }
+                const struct cache_literal* literal = &literals[value];
+                const size_t char_size = literal->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING ? sizeof(wchar_t) : 1;
+                valid                  = literal->offset <= header.blob_size &&
+                        literal->size < (header.blob_size - literal->offset) / char_size; // and a terminator
+                t->value.string_literal.type = (enum mcc_string_literal_type)literal->type;
+                if (literal->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING) {
+                    t->value.string_literal.value.wstring = (struct mcc_wstring_view){
+                        (wchar_t*)(void*)(blob + literal->offset),
+                        (size_t)literal->size,
+                    };
+                } else {
+                    t->value.string_literal.value.string = (struct mcc_string_view){
+                        blob + literal->offset,
+                        (size_t)literal->size,
+                    };
+                }
+                break;
+            }
+            case MCC_TOKEN_TYPE_INVALID:
+                valid = valid && value < header.blob_size && memchr(blob + value, '\0', header.blob_size - value);
+                t->value.error_message = blob + value;
+                break;
+            default:
+                valid = false;
+                break;
+        }
+    }
+    free(symbols);
+
+    if (!valid || array[count - 1].type != MCC_TOKEN_TYPE_EOF) {
+        free(array);
+        return false;
+    }
+
+    mcc_context_store(lexer->ctx, array);
+    lexer->current = lexer->source + array[count - 1].offset;
+    *tokens        = (struct mcc_token_array){array, count};
+    return true;
+}
+
+// the tokens' literals and error messages point into the file, only a hit hands it to the context
+static bool load(struct mcc_lexer* lexer, const char* path, struct mcc_token_array* tokens) {
+    size_t size;
+    size_t mapping_size;
+    char* data = map_file(path, &size, &mapping_size);
+    if (!data) {
+        return false;
+    }
+    if (!load_mapped(lexer, data, size, tokens)) {
+        unmap_file(data, mapping_size);
+        return false;
+    }
+    mcc_context_store_mapping(lexer->ctx, data, mapping_size);
+    return true;
+}
+
+struct blob {
+    char* data;
+    size_t size;
+    size_t capacity;
+};
+
+// appends size bytes of data followed by terminator null bytes
+static size_t blob_append(struct blob* blob, const void* data, size_t size, size_t terminator) {
+    const size_t offset = align16(blob->size);
+    if (offset + size + terminator > blob->capacity) {
+        blob->capacity = (offset + size + terminator) * 2;
+        blob->data     = realloc(blob->data, blob->capacity);
+        if (!blob->data) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    memset(blob->data + blob->size, 0, offset - blob->size);
+    memcpy(blob->data + offset, data, size);
+    memset(blob->data + offset + size, 0, terminator);
+    blob->size = offset + size + terminator;
+    return offset;
+}
+
+// identifiers are stored as the index of their name among the distinct names, numbered in order of first appearance
+static void store(const struct mcc_lexer* lexer, const char* path, struct mcc_token_array tokens) {
+    const size_t length = (size_t)(lexer->end - lexer->source);
+    const size_t count  = tokens.size;
+
+    struct cache_header header;
+    fill_header(&header, length);
+    header.token_count = count;
+    for (size_t i = 0; i < count; i++) {
+        header.constant_count += tokens.data[i].type == MCC_TOKEN_TYPE_CONSTANT;
+        header.literal_count += tokens.data[i].type == MCC_TOKEN_TYPE_STRING_LITERAL;
+    }
+
+    // names, literal data and messages are collected first, their counts and sizes decide the layout
+    const size_t symbol_count      = mcc_context_symbol_count(lexer->ctx);
+    const size_t literal_count     = (size_t)header.literal_count;
+    uint32_t* name_of              = malloc(sizeof(uint32_t) * (symbol_count ? symbol_count : 1));
+    struct cache_name* names       = malloc(sizeof(struct cache_name) * count);
+    struct cache_literal* literals = malloc(sizeof(struct cache_literal) * (literal_count ? literal_count : 1));
+    uint32_t* values               = malloc(sizeof(uint32_t) * count);
+    if (!name_of || !names || !literals || !values) {
+        perror("malloc");
+        exit(EXIT_FAILURE);
+    }
+    memset(name_of, 0xFF, sizeof(uint32_t) * symbol_count);
+
+    struct blob blob      = {0};
+    size_t constant_index = 0;
+    size_t literal_index  = 0;
+    for (size_t i = 0; i < count; i++) {
+        const struct mcc_token* t = &tokens.data[i];
+        switch (t->type) {
+            case MCC_TOKEN_TYPE_IDENTIFIER:
+                if (name_of[t->value.identifier] == UINT32_MAX) {
+                    name_of[t->value.identifier] = (uint32_t)header.name_count;
+                    names[header.name_count++]   = (struct cache_name){(uint32_t)t->offset, (uint32_t)t->lexeme.size};
+                }
+                values[i] = name_of[t->value.identifier];
+                break;
+            case MCC_TOKEN_TYPE_KEYWORD:
+                values[i] = (uint32_t)t->value.keyword;
+                break;
+            case MCC_TOKEN_TYPE_PUNCTUATOR:
+                values[i] = (uint32_t)t->value.punctuator;
+                break;
+            case MCC_TOKEN_TYPE_CONSTANT:
+                values[i] = (uint32_t)constant_index++;
+                break;
+            case MCC_TOKEN_TYPE_STRING_LITERAL: {
+                const struct mcc_string_literal* literal = &t->value.string_literal;
+                const bool wide        = literal->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING;
+                const size_t size      = wide ? literal->value.wstring.size : literal->value.string.size;
+                const size_t char_size = wide ? sizeof(wchar_t) : 1;
+                const void* data       = wide ? (const void*)literal->value.wstring.data : literal->value.string.data;
+                literals[literal_index] = (struct cache_literal){
+                    .type   = (uint32_t)literal->type,
+                    .offset = blob_append(&blob, data, size * char_size, char_size), // loaded literals are copies
+                    .size   = size,
+                };
+                values[i] = (uint32_t)literal_index++;
+                break;
+            }
+            case MCC_TOKEN_TYPE_INVALID:
+                values[i] = (uint32_t)blob_append(&blob, t->value.error_message, strlen(t->value.error_message), 1);
+                break;
+            case MCC_TOKEN_TYPE_EOF:
+            default:
+                values[i] = 0;
+                break;
+        }
+    }
+    header.blob_size = blob.size;
+
+    const struct cache_layout layout = layout_of(&header);
+    char* file                       = calloc(1, layout.size);
+    if (!file) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(file + layout.source, lexer->source, length);
+    uint32_t* offsets             = (uint32_t*)(void*)(file + layout.offsets);
+    uint32_t* lengths             = (uint32_t*)(void*)(file + layout.lengths);
+    struct mcc_constant* constants = (struct mcc_constant*)(void*)(file + layout.constants);
+    constant_index                 = 0;
+    for (size_t i = 0; i < count; i++) {
+        file[layout.kinds + i] = (char)(int8_t)tokens.data[i].type;
+        offsets[i]             = (uint32_t)tokens.data[i].offset;
+        lengths[i]             = (uint32_t)tokens.data[i].lexeme.size;
+        if (tokens.data[i].type == MCC_TOKEN_TYPE_CONSTANT) {
+            constants[constant_index++] = tokens.data[i].value.constant;
+        }
+    }
+    memcpy(file + layout.values, values, sizeof(uint32_t) * count);
+    memcpy(file + layout.literals, literals, sizeof(struct cache_literal) * (size_t)header.literal_count);
+    memcpy(file + layout.names, names, sizeof(struct cache_name) * (size_t)header.name_count);
+    if (blob.size) {
+        memcpy(file + layout.blob, blob.data, blob.size);
+    }
+    header.checksum = content_hash(file + layout.kinds, layout.size - layout.kinds);
+    memcpy(file, &header, sizeof(header));
+
+    (void)write_file_atomic(path, file, layout.size); // a cache that cannot be written only costs the next lex
+
+    free(file);
+    free(blob.data);
+    free(values);
+    free(literals);
+    free(names);
+    free(name_of);
+}
+
+struct mcc_token_array mcc_token_cache_tokenize(struct mcc_lexer* lexer, const char* directory, bool* hit) {
+    assert(lexer && lexer->source && directory);
+    assert(lexer->current == lexer->source && !lexer->stream && "the cache holds the tokens of a whole source");
+
+    const size_t length = (size_t)(lexer->end - lexer->source);
+    char path[4096];
+    // token offsets are stored in 32 bits
+    const bool cacheable = length < UINT32_MAX && mcc_token_cache_path(lexer, directory, path, sizeof(path));
+
+    struct mcc_token_array tokens;
+    if (cacheable && load(lexer, path, &tokens)) {
+        if (hit) {
+            *hit = true;
+        }
+        return tokens;
+    }
+
+    tokens = mcc_lexer_tokenize_all(lexer);
+    if (cacheable) {
+        store(lexer, path, tokens);
+    }
+    if (hit) {
+        *hit = false;
+    }
+    return tokens;
+}
@@ -0,0 +1,37 @@
+/// @file lib/token_cache.h
+/// @brief Opt-in on-disk cache of token streams.
+///
+/// A cached file holds everything mcc_lexer_tokenize_all() produces for one source: the token kinds, offsets and
+/// lengths as parallel arrays like struct mcc_token_buffer, the constants, the decoded string literals, the error
+/// messages and the distinct identifier names. Sections are laid out so the file can be mapped and used in place,
+/// loading only interns each distinct name once and expands the arrays into struct mcc_token.
+///
+/// Files are named after a hash of the source, and each one starts with MCC_VERSION, the MCC_BUILD_ID hashed from the
+/// library sources at build time and the sizes and byte order it was written with, then holds a copy of the source. A
+/// file is only used when all of them match and the copy equals the source byte for byte, so a changed source or
+/// compiler can never be served stale tokens.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "lexer.h"
+
+/// @brief Lexes a source like mcc_lexer_tokenize_all(), through a cache of token streams in a directory.
+/// @param lexer Pointer to a lexer created with mcc_lexer_create() or mcc_lexer_create_borrowed() that has not
+///              produced a token yet.
+/// @param directory Directory holding the cache, it must exist. Files are written to a temporary name and renamed into
+///                  place, so concurrent compilers can share it.
+/// @param hit Pointer to a variable set to true when the tokens came from the cache, may be NULL.
+/// @return The same tokens mcc_lexer_tokenize_all() returns. Lexemes point into the lexer's source, string literal
+///         data and error messages of a cache hit point into the cache file, which the context keeps mapped.
+/// @note A cache file that cannot be read or written is treated as a miss, the source is lexed either way.
+struct mcc_token_array mcc_token_cache_tokenize(struct mcc_lexer* lexer, const char* directory, bool* hit);
+
+/// @brief Formats the path of the cache file holding the tokens of a lexer's source.
+/// @param lexer Pointer to the lexer.
+/// @param directory Directory holding the cache.
+/// @param path Buffer receiving the path.
+/// @param size Size of the buffer in bytes.
+/// @return false if the path does not fit in the buffer.
+bool mcc_token_cache_path(const struct mcc_lexer* lexer, const char* directory, char* path, size_t size);
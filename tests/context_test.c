@@ -0,0 +1,278 @@
+/// @file tests/context_test.c
+/// @brief Compiler context tests for the MCC C99 compiler.
+
+#include <lexer.h>
+#include <private/utils.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+#include "test.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static struct mcc_context* ctx;
+
+// =============================================================================
+// Tests
+// =============================================================================
+
+static void test_alloc(void) {
+    TEST_SUITE("Context — Arena allocation");
+
+    struct mcc_context* arena_ctx = mcc_context_create();
+
+    // many small allocations spanning several chunks, each must be aligned and must not overlap the others
+    unsigned char* blocks[4096];
+    bool aligned = true;
+    for (size_t i = 0; i < 4096; i++) {
+        const size_t size = 1 + i % 61;
+        blocks[i]         = mcc_context_alloc(arena_ctx, size);
+        memset(blocks[i], (int)(i & 0xFF), size);
+        aligned &= (uintptr_t)blocks[i] % sizeof(void*) == 0;
+    }
+    EXPECT(aligned, "arena allocation is misaligned");
+    bool intact = true;
+    for (size_t i = 0; i < 4096; i++) {
+        for (size_t j = 0; j < 1 + i % 61; j++) {
+            intact &= blocks[i][j] == (unsigned char)(i & 0xFF);
+        }
+    }
+    EXPECT(intact, "arena allocations overlap");
+
+    // larger than a chunk
+    const size_t big_size = 1024 * 1024;
+    char* big             = mcc_context_alloc(arena_ctx, big_size);
+    memset(big, 'x', big_size);
+    char* after_big = mcc_context_alloc(arena_ctx, 16);
+    EXPECT(after_big < big || after_big >= big + big_size, "allocation after a large block overlaps it");
+
+    // trimming the most recent allocation hands its tail to the next one
+    char* wide = mcc_context_alloc(arena_ctx, 256);
+    mcc_context_trim(arena_ctx, wide, 10);
+    char* reused = mcc_context_alloc(arena_ctx, 8);
+    EXPECT(reused > wide && reused < wide + 256, "trimmed tail was not reused");
+
+    mcc_context_destroy(arena_ctx);
+}
+
+static void test_intern(void) {
+    TEST_SUITE("Context — Identifier interning");
+
+    struct mcc_context* intern_ctx = mcc_context_create();
+
+    const uint32_t foo = mcc_context_intern(intern_ctx, "foo", 3);
+    const uint32_t bar = mcc_context_intern(intern_ctx, "bar", 3);
+    EXPECT(foo == 0 && bar == 1, "symbols are not dense: foo %u, bar %u", foo, bar);
+    EXPECT(mcc_context_intern(intern_ctx, "foobar", 3) == foo, "prefix of a longer buffer did not match 'foo'");
+    EXPECT(mcc_context_intern(intern_ctx, "fo", 2) != foo, "'fo' shares a symbol with 'foo'");
+
+    const struct mcc_string_view name = mcc_context_symbol_name(intern_ctx, bar);
+    EXPECT(name.size == 3 && strcmp(name.data, "bar") == 0, "symbol %u is not named 'bar'", bar);
+
+    // enough names to grow the table several times, every symbol must survive the rehashes
+    char buffer[32];
+    bool stable = true;
+    for (int i = 0; i < 20000; i++) {
+        const int len = sprintf(buffer, "name_%d", i);
+        stable &= mcc_context_intern(intern_ctx, buffer, (size_t)len) == (uint32_t)i + 3;
+    }
+    for (int i = 0; i < 20000; i++) {
+        const int len = sprintf(buffer, "name_%d", i);
+        stable &= mcc_context_intern(intern_ctx, buffer, (size_t)len) == (uint32_t)i + 3;
+    }
+    EXPECT(stable, "symbols changed after the table grew");
+    EXPECT(mcc_context_symbol_count(intern_ctx) == 20003,
+           "symbol count %zu != expected 20003",
+           mcc_context_symbol_count(intern_ctx));
+
+    // identifiers lexed from the same context share symbols
+    struct mcc_lexer lexer;
+    const char* src = "x = y + x;";
+    mcc_lexer_create(intern_ctx, src, strlen(src), &lexer);
+    const struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(tokens.size == 7 && tokens.data[0].value.identifier == tokens.data[4].value.identifier &&
+               tokens.data[0].value.identifier != tokens.data[2].value.identifier,
+           "repeated identifier did not get the same symbol");
+    mcc_lexer_destroy(&lexer);
+
+    mcc_context_destroy(intern_ctx);
+}
+
+static void test_map_file(void) {
+    TEST_SUITE("Context — Mapped source files");
+
+    size_t read_size;
+    char* expected = read_file("test_files/hello_world.c", &read_size);
+    if (!expected) {
+        TEST_FAIL("could not read test_files/hello_world.c");
+        return;
+    }
+
+    size_t size;
+    char* mapped = mcc_context_map_file(ctx, "test_files/hello_world.c", &size);
+    EXPECT(mapped != NULL, "mapping test_files/hello_world.c failed");
+    if (mapped) {
+        EXPECT(size == read_size, "mapped size %zu != read size %zu", size, read_size);
+        EXPECT(memcmp(mapped, expected, size) == 0, "mapped contents differ from the file");
+        EXPECT(mapped[size] == '\0', "mapping is not null-terminated");
+
+        struct mcc_lexer lexer;
+        mcc_lexer_create_borrowed(ctx, mapped, size, &lexer);
+        const struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+        EXPECT(tokens.size > 1 && tokens.data[0].type == MCC_TOKEN_TYPE_PUNCTUATOR, "expected '#' as first token");
+        EXPECT(tokens.data[0].lexeme.data == mapped, "borrowed lexer copied the source");
+        mcc_lexer_destroy(&lexer);
+    }
+    free(expected);
+
+    EXPECT(mcc_context_map_file(ctx, "test_files/does_not_exist.c", &size) == NULL, "missing file mapped");
+}
+
+static void test_map_file_page_boundary(void) {
+    TEST_SUITE("Context — Mapped file ending on a page boundary");
+
+    // 64 KiB is a multiple of every common page size, so the terminator must come from the reserved extra page
+    const char* path = "test_files/page_boundary.c";
+    const size_t len = 64 * 1024;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        TEST_FAIL("could not create %s", path);
+        return;
+    }
+    for (size_t i = 0; i < len; i++) {
+        fputc(i % 64 == 63 ? '\n' : 'x', file);
+    }
+    fclose(file);
+
+    size_t size;
+    char* mapped = mcc_context_map_file(ctx, path, &size);
+    EXPECT(mapped != NULL && size == len, "mapping %s failed", path);
+    if (mapped) {
+        EXPECT(mapped[size] == '\0', "page aligned mapping is not null-terminated");
+
+        struct mcc_lexer lexer;
+        mcc_lexer_create_borrowed(ctx, mapped, size, &lexer);
+        const struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+        EXPECT(tokens.size == len / 64 + 1, "token count %zu != expected %zu", tokens.size, len / 64 + 1);
+        mcc_lexer_destroy(&lexer);
+    }
+
+    remove(path);
+}
+
+#ifdef __linux__
+static void test_map_pipe(void) {
+    TEST_SUITE("Context — Mapped pipe");
+
+    // a pipe cannot be mapped or seeked, it is read through its descriptor the way process substitution hands it over
+    int fds[2];
+    if (pipe(fds) != 0) {
+        TEST_FAIL("could not create a pipe");
+        return;
+    }
+    const char* src = "int x = 42;\n";
+    const bool sent = write(fds[1], src, strlen(src)) == (ssize_t)strlen(src);
+    close(fds[1]);
+
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/fd/%d", fds[0]);
+    size_t size;
+    char* mapped = mcc_context_map_file(ctx, path, &size);
+    EXPECT(sent && mapped != NULL, "mapping %s failed", path);
+    if (mapped) {
+        EXPECT(size == strlen(src) && memcmp(mapped, src, size) == 0 && mapped[size] == '\0',
+               "pipe contents differ from what was written");
+    }
+    close(fds[0]);
+}
+#endif
+
+static void test_stats(void) {
+    TEST_SUITE("Context — Instrumentation counters");
+
+    struct mcc_context* stats_ctx = mcc_context_create();
+    struct mcc_lexer lexer;
+    const char* src = "int x = 42 + 'a'; char* s = \"h\\ti\"; @";
+    mcc_lexer_create(stats_ctx, src, strlen(src), &lexer);
+    (void)mcc_lexer_tokenize_all(&lexer);
+    mcc_lexer_destroy(&lexer);
+
+    struct mcc_stats stats;
+    const bool counted = mcc_context_stats(stats_ctx, &stats);
+#ifdef MCC_STATS
+    EXPECT(counted, "counters are not reported as counted with MCC_STATS defined");
+
+    // indexed by token type + 1
+    const uint64_t tokens[MCC_STATS_TOKEN_TYPES] = {1, 1, 2, 2, 2, 1, 6};
+    const uint64_t bytes[MCC_STATS_TOKEN_TYPES]  = {1, 0, 7, 2, 5, 6, 6};
+    for (size_t i = 0; i < MCC_STATS_TOKEN_TYPES; i++) {
+        EXPECT(stats.tokens[i] == tokens[i] && stats.bytes[i] == bytes[i],
+               "token type %d: %llu tokens and %llu bytes != expected %llu and %llu",
+               (int)i - 1,
+               (unsigned long long)stats.tokens[i],
+               (unsigned long long)stats.bytes[i],
+               (unsigned long long)tokens[i],
+               (unsigned long long)bytes[i]);
+    }
+
+    // '@' goes through scan_punctuator too, only the string's escape goes through parse_char
+    const uint64_t calls[MCC_STATS_FUNCTION_COUNT] = {1, 1, 2, 1, 7};
+    for (size_t i = 0; i < MCC_STATS_FUNCTION_COUNT; i++) {
+        EXPECT(stats.calls[i] == calls[i],
+               "function %zu: %llu calls != expected %llu",
+               i,
+               (unsigned long long)stats.calls[i],
+               (unsigned long long)calls[i]);
+    }
+    // only the literal with an escape is decoded into the context, with its terminator
+    EXPECT(stats.stored_literals == 1 && stats.stored_literal_bytes == 4,
+           "%llu literals and %llu bytes stored != expected 1 and 4",
+           (unsigned long long)stats.stored_literals,
+           (unsigned long long)stats.stored_literal_bytes);
+
+    // absorbing a context adds its counters
+    struct mcc_context* other = mcc_context_create();
+    mcc_lexer_create(other, src, strlen(src), &lexer);
+    (void)mcc_lexer_tokenize_all(&lexer);
+    mcc_lexer_destroy(&lexer);
+    mcc_context_absorb(stats_ctx, other);
+    struct mcc_stats absorbed;
+    (void)mcc_context_stats(stats_ctx, &absorbed);
+    EXPECT(absorbed.tokens[MCC_TOKEN_TYPE_PUNCTUATOR + 1] == 12 && absorbed.calls[MCC_STATS_PARSE_CHAR] == 4 &&
+               absorbed.stored_literals == 2,
+           "absorbed counters were not added");
+#else
+    const struct mcc_stats zero = {0};
+    EXPECT(!counted && memcmp(&stats, &zero, sizeof(stats)) == 0, "counters reported without MCC_STATS defined");
+#endif
+
+    mcc_context_destroy(stats_ctx);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    ctx = mcc_context_create();
+
+    test_alloc();
+    test_intern();
+    test_map_file();
+    test_map_file_page_boundary();
+#ifdef __linux__
+    test_map_pipe();
+#endif
+    test_stats();
+
+    mcc_context_destroy(ctx);
+
+    print_results();
+    return g_tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
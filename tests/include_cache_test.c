@@ -0,0 +1,183 @@
+/// @file tests/include_cache_test.c
+/// @brief Include cache and include guard detection tests for the MCC C99 compiler.
+
+#include <include_cache.h>
+#include <lexer.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "context.h"
+#include "test.h"
+
+static struct mcc_context* ctx;
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool write_file(const char* path, const char* text) {
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        TEST_FAIL("could not create %s", path);
+        return false;
+    }
+    fwrite(text, 1, strlen(text), file);
+    fclose(file);
+    return true;
+}
+
+// stands in for the preprocessor's macro table, a single macro is enough here
+static bool is_defined(void* user, uint32_t symbol) {
+    return *(const uint32_t*)user == symbol;
+}
+
+static const char* symbol_name(uint32_t symbol) {
+    return symbol == MCC_INCLUDE_NO_GUARD ? "(none)" : mcc_context_symbol_name(ctx, symbol).data;
+}
+
+/// @brief Writes a header, looks it up in a fresh cache and checks the guard and #pragma once found in it.
+static void expect_guard(const char* text, const char* guard, bool pragma_once) {
+    const char* path = "test_files/guard.h";
+    if (!write_file(path, text)) {
+        return;
+    }
+
+    struct mcc_include_cache cache;
+    mcc_include_cache_create(ctx, &cache);
+    bool skip;
+    const struct mcc_include_file* file = mcc_include_cache_enter(&cache, path, NULL, NULL, &skip);
+    if (!file) {
+        TEST_FAIL("'%s': could not be entered", text);
+        mcc_include_cache_destroy(&cache);
+        return;
+    }
+
+    const uint32_t expected = guard ? mcc_context_intern(ctx, guard, strlen(guard)) : MCC_INCLUDE_NO_GUARD;
+    EXPECT(file->guard == expected,
+           "'%s': guard %s != expected %s",
+           text,
+           symbol_name(file->guard),
+           symbol_name(expected));
+    EXPECT(file->pragma_once == pragma_once,
+           "'%s': #pragma once %d != expected %d",
+           text,
+           file->pragma_once,
+           pragma_once);
+
+    mcc_include_cache_destroy(&cache);
+    remove(path);
+}
+
+// =============================================================================
+// Tests
+// =============================================================================
+
+static void test_guard_detection(void) {
+    TEST_SUITE("Include Cache — Guard detection");
+
+    expect_guard("#ifndef A_H\n#define A_H\nint a;\n#endif\n", "A_H", false);
+    expect_guard("/* license */\n// more\n  #  ifndef B_H\n#define B_H\n#endif // B_H\n/* end */", "B_H", false);
+    expect_guard("#if !defined C_H\n#define C_H\n#endif", "C_H", false);
+    expect_guard("#if !defined(D_H)\n#define D_H\n#if X\nint x;\n#else\nint y;\n#endif\n#endif\n", "D_H", false);
+    expect_guard("#ifndef E_H\n#define E_H\n#pragma once\n#endif\n", "E_H", true);
+    expect_guard("#pragma once\nint f;\n", NULL, true);
+
+    // not guards
+    expect_guard("int g;\n#ifndef G_H\n#define G_H\n#endif\n", NULL, false);
+    expect_guard("#ifndef H_H\n#define H_H\n#endif\nint h;\n", NULL, false);
+    expect_guard("#ifndef I_H\n#define I_H\n#else\nint i;\n#endif\n", NULL, false);
+    expect_guard("#ifndef J_H\n#endif\n#ifndef K_H\n#endif\n", NULL, false);
+    expect_guard("#ifdef L_H\n#define L_H\n#endif\n", NULL, false);
+    expect_guard("#if !defined M_H || 1\n#endif\n", NULL, false);
+    expect_guard("#ifndef N_H\n#define N_H\n", NULL, false);
+    expect_guard("#ifndef O_H /*\n*/ #endif\n", NULL, false);
+    expect_guard("#ifndef P_H\n#if X\n#pragma once\n#endif\n#endif\n", "P_H", false);
+    expect_guard("#if X\n#pragma once\n#endif\nint q;\n", NULL, false);
+    expect_guard("", NULL, false);
+}
+
+static void test_enter(void) {
+    TEST_SUITE("Include Cache — Entering files");
+
+    const char* guarded = "test_files/guarded.h";
+    const char* once    = "test_files/once.h";
+    const char* plain   = "test_files/plain.h";
+    if (!write_file(guarded, "#ifndef GUARDED_H\n#define GUARDED_H\nint guarded;\n#endif\n") ||
+        !write_file(once, "#pragma once\nint once;\n") || !write_file(plain, "int plain;\n")) {
+        return;
+    }
+
+    struct mcc_include_cache cache;
+    mcc_include_cache_create(ctx, &cache);
+    uint32_t macro = UINT32_MAX; // nothing is defined yet
+    bool skip;
+
+    struct mcc_include_file* first = mcc_include_cache_enter(&cache, guarded, is_defined, &macro, &skip);
+    EXPECT(first && !skip, "first include of a guarded file was skipped");
+    if (!first) {
+        mcc_include_cache_destroy(&cache);
+        return;
+    }
+    EXPECT(first->tokens.size == 12, "guarded file: %zu tokens != expected 12", first->tokens.size);
+
+    // the guard is not defined yet, so the file is processed again from the cache
+    const struct mcc_include_file* again = mcc_include_cache_enter(&cache, guarded, is_defined, &macro, &skip);
+    EXPECT(again == first && !skip, "guarded file with its macro undefined was skipped or reloaded");
+
+    // files in the cache are never reopened, even once they are gone
+    remove(guarded);
+    macro = first->guard;
+    again = mcc_include_cache_enter(&cache, guarded, is_defined, &macro, &skip);
+    EXPECT(again == first && skip, "guarded file with its macro defined was not skipped");
+    EXPECT(cache.opened == 1 && cache.skipped == 1,
+           "opened %zu and skipped %zu != expected 1 and 1",
+           cache.opened,
+           cache.skipped);
+
+    const struct mcc_include_file* o = mcc_include_cache_enter(&cache, once, NULL, NULL, &skip);
+    EXPECT(o && !skip, "first include of a #pragma once file was skipped");
+    o = mcc_include_cache_enter(&cache, once, NULL, NULL, &skip);
+    EXPECT(o && skip, "second include of a #pragma once file was not skipped");
+
+    for (int i = 0; i < 3; i++) {
+        const struct mcc_include_file* p = mcc_include_cache_enter(&cache, plain, is_defined, &macro, &skip);
+        EXPECT(p && !skip && p->guard == MCC_INCLUDE_NO_GUARD, "include %d of an unguarded file was skipped", i);
+    }
+    EXPECT(cache.opened == 3, "%zu files opened != expected 3", cache.opened);
+
+    // a missing file is reported and not cached
+    EXPECT(!mcc_include_cache_enter(&cache, "test_files/missing.h", NULL, NULL, &skip), "missing file was entered");
+    EXPECT(write_file("test_files/missing.h", "int late;\n") &&
+               mcc_include_cache_enter(&cache, "test_files/missing.h", NULL, NULL, &skip) != NULL,
+           "file created after a failed include could not be entered");
+
+    // locations come from the file's own lexer
+    const struct mcc_source_location location = mcc_lexer_location(&first->lexer, first->tokens.data[7].offset);
+    EXPECT(location.line == 2 && location.column == 4,
+           "token 7 of the guarded file at %zu:%zu != expected 2:4",
+           location.line,
+           location.column);
+
+    mcc_include_cache_destroy(&cache);
+    remove(once);
+    remove(plain);
+    remove("test_files/missing.h");
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    ctx = mcc_context_create();
+
+    test_guard_detection();
+    test_enter();
+
+    mcc_context_destroy(ctx);
+
+    print_results();
+    return g_tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -1,57 +1,23 @@
 /// @file test/test_lexer.c
 /// @brief Lexer unit tests for the MCC C99 compiler.
 
+#include <ctype.h>
 #include <defs.h>
 #include <lexer.h>
+#include <locale.h>
+#include <private/charclass.h>
 #include <private/utils.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <wchar.h>
 #include "context.h"
+#include "test.h"
 
 static struct mcc_context* ctx;
 
-static int g_tests_run    = 0;
-static int g_tests_passed = 0;
-static int g_tests_failed = 0;
-
-#define TEST_PASS()       \
-    do {                  \
-        g_tests_run++;    \
-        g_tests_passed++; \
-    } while (0)
-
-#define TEST_FAIL(fmt, ...)                                                                    \
-    do {                                                                                       \
-        g_tests_run++;                                                                         \
-        g_tests_failed++;                                                                      \
-        (void)fprintf(stderr, "  FAIL [%s:%d]: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
-    } while (0)
-
-#define EXPECT(cond, fmt, ...)             \
-    do {                                   \
-        if ((cond)) {                      \
-            TEST_PASS();                   \
-        } else {                           \
-            TEST_FAIL(fmt, ##__VA_ARGS__); \
-        }                                  \
-    } while (0)
-
-#define TEST_SUITE(name)                \
-    do {                                \
-        printf("\n=== " name " ===\n"); \
-    } while (0)
-
-static void print_results(void) {
-    printf("\n----------------------------------------\n");
-    printf("Results: %d/%d passed", g_tests_passed, g_tests_run);
-    if (g_tests_failed > 0) {
-        printf(", %d FAILED", g_tests_failed);
-    }
-    printf("\n");
-}
-
 // =============================================================================
 // Lexer Helpers
 // =============================================================================
@@ -65,6 +31,16 @@ static struct mcc_token lex_one(const char* src) {
     return tok;
 }
 
+/// @brief Lex a single token and resolve its line and column.
+static struct mcc_token lex_one_at(const char* src, struct mcc_source_location* location) {
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, src, strlen(src), &lexer);
+    struct mcc_token tok = mcc_lexer_next_token(&lexer);
+    *location            = mcc_lexer_location(&lexer, tok.offset);
+    mcc_lexer_destroy(&lexer);
+    return tok;
+}
+
 // =============================================================================
 // Expect Helpers
 // =============================================================================
@@ -80,7 +56,16 @@ static void expect_keyword(const char* src, enum mcc_keyword expected) {
 
 static void expect_identifier(const char* src) {
     struct mcc_token tok = lex_one(src);
-    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "'%s': expected IDENTIFIER, got token type %d", src, tok.type);
+    if (tok.type != MCC_TOKEN_TYPE_IDENTIFIER) {
+        TEST_FAIL("'%s': expected IDENTIFIER, got token type %d", src, tok.type);
+        return;
+    }
+    const struct mcc_string_view name = mcc_context_symbol_name(ctx, tok.value.identifier);
+    EXPECT(name.size == tok.lexeme.size && memcmp(name.data, tok.lexeme.data, name.size) == 0,
+           "'%s': symbol %u is named '%s'",
+           src,
+           tok.value.identifier,
+           name.data);
 }
 
 static void expect_punctuator(const char* src, enum mcc_punctuator expected) {
@@ -295,8 +280,8 @@ static void expect_string_literal(const char* src, const char* expected, size_t
     mcc_lexer_create(ctx, src, strlen(src), &lexer);
     struct mcc_token tok = mcc_lexer_next_token(&lexer);
 
-    if (tok.type != MCC_TOKEN_TYPE_CONSTANT) {
-        TEST_FAIL("'%s': expected CONSTANT, got token type %d", src, tok.type);
+    if (tok.type != MCC_TOKEN_TYPE_STRING_LITERAL) {
+        TEST_FAIL("'%s': expected STRING_LITERAL, got token type %d", src, tok.type);
         mcc_lexer_destroy(&lexer);
         return;
     }
@@ -310,6 +295,13 @@ static void expect_string_literal(const char* src, const char* expected, size_t
     EXPECT(sv.size == expected_chars, "'%s': length %zu != expected %zu", src, sv.size, expected_chars);
     EXPECT(memcmp(sv.data, expected, expected_chars) == 0, "'%s': content mismatch", src);
 
+    // a literal without escapes is its own spelling in the (spliced) source, a decoded one is null-terminated
+    if (strchr(lexer.source, '\\') == NULL) {
+        EXPECT(sv.data == lexer.source + 1 && sv.data[sv.size] == '"', "'%s': literal without escapes was copied", src);
+    } else {
+        EXPECT(sv.data[sv.size] == '\0', "'%s': decoded literal is not null-terminated", src);
+    }
+
     mcc_lexer_destroy(&lexer);
 }
 
@@ -318,8 +310,8 @@ static void expect_wstring_literal(const char* src, const wchar_t* expected, siz
     mcc_lexer_create(ctx, src, strlen(src), &lexer);
     struct mcc_token tok = mcc_lexer_next_token(&lexer);
 
-    if (tok.type != MCC_TOKEN_TYPE_CONSTANT) {
-        TEST_FAIL("'%s': expected CONSTANT, got token type %d", src, tok.type);
+    if (tok.type != MCC_TOKEN_TYPE_STRING_LITERAL) {
+        TEST_FAIL("'%s': expected STRING_LITERAL, got token type %d", src, tok.type);
         mcc_lexer_destroy(&lexer);
         return;
     }
@@ -332,6 +324,7 @@ static void expect_wstring_literal(const char* src, const wchar_t* expected, siz
 
     EXPECT(wsv.size == expected_chars, "'%s': length %zu != expected %zu", src, wsv.size, expected_chars);
     EXPECT(memcmp(wsv.data, expected, expected_chars * sizeof(wchar_t)) == 0, "'%s': content mismatch", src);
+    EXPECT(wsv.data[wsv.size] == 0, "'%s': decoded literal is not null-terminated", src);
 
     mcc_lexer_destroy(&lexer);
 }
@@ -511,18 +504,28 @@ static void test_integer_constants(void) {
     // 0xFFFFFFFFFFFFFFFF == ULLONG_MAX, too big for long long but valid ull
     expect_ulong_constant("0xFFFFFFFFFFFFFFFF", 0xFFFFFFFFFFFFFFFFul);
 
+    // Suffixed hex/octal keeps the unsigned steps of its ladder: ll -> long long, unsigned long long
+    expect_ullong_constant("0xFFFFFFFFFFFFFFFFll", 0xFFFFFFFFFFFFFFFFull);
+    expect_ulong_constant("0x8000000000000000l", 0x8000000000000000ul);
+
+    // A u suffix on a decimal constant climbs the unsigned ladder
+    expect_ulong_constant("4294967296u", 4294967296ul);
+
     TEST_SUITE("Integer Constants — Overflow");
 
-    expect_overflow("0xFFFFFFFFFFFFFFFFll");
+    expect_overflow("0x10000000000000000");             // 65 bits
+    expect_overflow("18446744073709551615");            // decimal never becomes unsigned without a suffix
     expect_overflow("99999999999999999999999999999");    // too big for any signed type
     expect_overflow("99999999999999999999999999999ull"); // too big for ull
     expect_overflow("99999999999999999999999999999u");   // too big for unsigned ladder
 
     TEST_SUITE("Float Constants — Overflow");
 
-    expect_overflow("1e99999f"); // float overflow
-    expect_overflow("1e99999");  // double overflow
-    expect_overflow("1e99999l"); // long double overflow
+    expect_overflow("1e99999f");  // float overflow
+    expect_overflow("1e99999");   // double overflow
+    expect_overflow("1e99999l");  // long double overflow
+    expect_overflow("1e-400");    // double underflow to zero
+    expect_overflow("0x1p-1076"); // below half the smallest subnormal
 
     TEST_SUITE("Integer Constants — Invalid");
 
@@ -595,6 +598,27 @@ static void test_float_constants(void) {
     expect_double_constant("0e0", 0e0);   // zero with exponent
     expect_double_constant("1.e1", 1.e1); // dot with exponent, no fractional digits
 
+    TEST_SUITE("Float Constants — Correct Rounding");
+
+    expect_double_constant("9007199254740993.", 9007199254740993.); // 2^53 + 1, halfway, ties to even
+    expect_double_constant("9007199254740993.00000000000000000001", 9007199254740993.00000000000000000001);
+    expect_double_constant("0.1", 0.1);
+    expect_double_constant("1e23", 1e23);
+    expect_double_constant("2.2250738585072011e-308", 2.2250738585072011e-308); // largest subnormal
+    expect_double_constant("4.9406564584124654e-324", 4.9406564584124654e-324); // smallest subnormal
+    expect_double_constant("1.7976931348623157e308", 1.7976931348623157e308);   // DBL_MAX
+    expect_double_constant("123456789012345678901234567890e-10", 123456789012345678901234567890e-10);
+    expect_double_constant("0x1.fffffffffffff8p0", 0x1.fffffffffffff8p0); // halfway in hex, rounds up to 2
+    expect_double_constant("0x1p-1074", 0x1p-1074);
+
+    expect_float_constant("7.038531e-26f", 7.038531e-26f);
+    expect_float_constant("1.00000005960464477550f", 1.00000005960464477550f); // just above halfway
+    expect_float_constant("3.4028235677973366e38f", 3.4028235677973366e38f);   // rounds down to FLT_MAX
+
+    expect_ldouble_constant("0.1l", 0.1l);
+    expect_ldouble_constant("1e-4000l", 1e-4000l);
+    expect_ldouble_constant("0xFFFFFFFFFFFFFFFF8p0l", 0xFFFFFFFFFFFFFFFF8p0l); // carries into a new bit
+
     TEST_SUITE("Float Constants — Invalid");
 
     expect_invalid("1.2.3");
@@ -670,74 +694,98 @@ static void test_character_constants(void) {
     expect_invalid("'\\uDFFF'");   // surrogate
     expect_invalid("'\\u009F'");   // below 0x00A0, not an allowed exception
     expect_invalid("'\\U000000'"); // \U needs exactly 8 digits
+
+    // an unterminated constant ends at the end of the input and lexing stops there
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, "x 'abc", 6, &lexer);
+    mcc_lexer_next_token(&lexer);
+    const struct mcc_token open = mcc_lexer_next_token(&lexer);
+    const struct mcc_token eof  = mcc_lexer_next_token(&lexer);
+    EXPECT(open.type == MCC_TOKEN_TYPE_INVALID && open.lexeme.size == 4, "'x 'abc': expected a 4 byte INVALID token");
+    EXPECT(eof.type == MCC_TOKEN_TYPE_EOF && eof.offset == 6, "'x 'abc': EOF at %zu != expected 6", eof.offset);
+    mcc_lexer_destroy(&lexer);
 }
 
 static void test_string_literals(void) {
     TEST_SUITE("String Literals — Basic");
 
-    expect_string_literal("\"\"", "", 1); // just null terminator
-    expect_string_literal("\"a\"", "a", 2);
-    expect_string_literal("\"hello\"", "hello", 6);
-    expect_string_literal("\"hello world\"", "hello world", 12);
+    expect_string_literal("\"\"", "", 0);
+    expect_string_literal("\"a\"", "a", 1);
+    expect_string_literal("\"hello\"", "hello", 5);
+    expect_string_literal("\"hello world\"", "hello world", 11);
 
     TEST_SUITE("String Literals — Simple escape sequences");
 
-    expect_string_literal("\"\\n\"", "\n", 2);
-    expect_string_literal("\"\\t\"", "\t", 2);
-    expect_string_literal("\"\\r\"", "\r", 2);
-    expect_string_literal("\"\\\\\"", "\\", 2);
-    expect_string_literal("\"\\\"\"", "\"", 2);
-    expect_string_literal("\"\\a\"", "\a", 2);
-    expect_string_literal("\"\\b\"", "\b", 2);
-    expect_string_literal("\"\\f\"", "\f", 2);
-    expect_string_literal("\"\\v\"", "\v", 2);
-    expect_string_literal("\"\\?\"", "\?", 2);
-    expect_string_literal("\"\\0\"", "\0", 2); // embedded null
-    expect_string_literal("\"a\\nb\"", "a\nb", 4);
+    expect_string_literal("\"\\n\"", "\n", 1);
+    expect_string_literal("\"\\t\"", "\t", 1);
+    expect_string_literal("\"\\r\"", "\r", 1);
+    expect_string_literal("\"\\\\\"", "\\", 1);
+    expect_string_literal("\"\\\"\"", "\"", 1);
+    expect_string_literal("\"\\a\"", "\a", 1);
+    expect_string_literal("\"\\b\"", "\b", 1);
+    expect_string_literal("\"\\f\"", "\f", 1);
+    expect_string_literal("\"\\v\"", "\v", 1);
+    expect_string_literal("\"\\?\"", "\?", 1);
+    expect_string_literal("\"\\0\"", "\0", 1); // embedded null
+    expect_string_literal("\"a\\nb\"", "a\nb", 3);
+
+    TEST_SUITE("String Literals — Escaped quotes");
+
+    // an escaped quote must not end the literal, the whole source is one token
+    static const char* const quoted[] = {"\"q \\\"5\\\" b\"", "\"\\\\\"", "\"\\'\"", "'\\''", "L'\\''", "'\\\\'"};
+    for (size_t i = 0; i < sizeof(quoted) / sizeof(*quoted); i++) {
+        const struct mcc_token tok = lex_one(quoted[i]);
+        EXPECT(tok.type != MCC_TOKEN_TYPE_INVALID && tok.lexeme.size == strlen(quoted[i]),
+               "'%s': expected a single %zu byte token, got %zu bytes",
+               quoted[i],
+               strlen(quoted[i]),
+               tok.lexeme.size);
+    }
+    expect_string_literal("\"q \\\"5\\\" b\"", "q \"5\" b", 7);
 
     TEST_SUITE("String Literals — Octal escape sequences");
 
-    expect_string_literal("\"\\101\"", "A", 2);       // \101 = 'A'
-    expect_string_literal("\"\\07\"", "\07", 2);      // 2-digit octal
-    expect_string_literal("\"\\0\\0\"", "\0\0", 3);   // two embedded nulls
-    expect_string_literal("\"\\101\\102\"", "AB", 3); // \101='A', \102='B'
-    expect_string_literal("\"\\101bc\"", "Abc", 4);   // octal then regular chars
+    expect_string_literal("\"\\101\"", "A", 1);       // \101 = 'A'
+    expect_string_literal("\"\\07\"", "\07", 1);      // 2-digit octal
+    expect_string_literal("\"\\0\\0\"", "\0\0", 2);   // two embedded nulls
+    expect_string_literal("\"\\101\\102\"", "AB", 2); // \101='A', \102='B'
+    expect_string_literal("\"\\101bc\"", "Abc", 3);   // octal then regular chars
 
     TEST_SUITE("String Literals — Hex escape sequences");
 
-    expect_string_literal("\"\\x41\"", "A", 2); // \x41 = 'A'
-    expect_string_literal("\"\\x41\\x42\"", "AB", 3);
-    expect_string_literal("\"\\x0\"", "\0", 2); // hex null
+    expect_string_literal("\"\\x41\"", "A", 1); // \x41 = 'A'
+    expect_string_literal("\"\\x41\\x42\"", "AB", 2);
+    expect_string_literal("\"\\x0\"", "\0", 1); // hex null
 
     // correct version: hex stops only at non-hex char
-    expect_string_literal("\"\\x61zz\"", "azz", 4); // 'z' is not hex, stops correctly
-    expect_string_literal("\"\\xFF\"", "\xFF", 2);
+    expect_string_literal("\"\\x61zz\"", "azz", 3); // 'z' is not hex, stops correctly
+    expect_string_literal("\"\\xFF\"", "\xFF", 1);
 
     TEST_SUITE("String Literals — UCN in narrow strings (ASCII-range exceptions only)");
 
     // These three codepoints are explicitly allowed below 0x00A0
     // and map to well-known ASCII values, so the result is portable
-    expect_string_literal("\"\\u0024\"", "$", 2); // U+0024 = '$'
-    expect_string_literal("\"\\u0040\"", "@", 2); // U+0040 = '@'
-    expect_string_literal("\"\\u0060\"", "`", 2); // U+0060 = '`'
+    expect_string_literal("\"\\u0024\"", "$", 1); // U+0024 = '$'
+    expect_string_literal("\"\\u0040\"", "@", 1); // U+0040 = '@'
+    expect_string_literal("\"\\u0060\"", "`", 1); // U+0060 = '`'
 
     TEST_SUITE("String Literals — UCN in wide strings");
 
     // Wide string UCNs store the codepoint directly in wchar_t
-    expect_wstring_literal("L\"\\u00A0\"", (wchar_t[]){0x00A0, 0}, 2);             // NO-BREAK SPACE
-    expect_wstring_literal("L\"\\u0024\"", (wchar_t[]){0x0024, 0}, 2);             // $
-    expect_wstring_literal("L\"\\u0040\"", (wchar_t[]){0x0040, 0}, 2);             // @
-    expect_wstring_literal("L\"\\u0060\"", (wchar_t[]){0x0060, 0}, 2);             // `
-    expect_wstring_literal("L\"\\U000000A0\"", (wchar_t[]){0x00A0, 0}, 2);         // \U form
-    expect_wstring_literal("L\"a\\u00A0b\"", (wchar_t[]){'a', 0x00A0, 'b', 0}, 4); // mixed
+    expect_wstring_literal("L\"\\u00A0\"", (wchar_t[]){0x00A0, 0}, 1);             // NO-BREAK SPACE
+    expect_wstring_literal("L\"\\u0024\"", (wchar_t[]){0x0024, 0}, 1);             // $
+    expect_wstring_literal("L\"\\u0040\"", (wchar_t[]){0x0040, 0}, 1);             // @
+    expect_wstring_literal("L\"\\u0060\"", (wchar_t[]){0x0060, 0}, 1);             // `
+    expect_wstring_literal("L\"\\U000000A0\"", (wchar_t[]){0x00A0, 0}, 1);         // \U form
+    expect_wstring_literal("L\"a\\u00A0b\"", (wchar_t[]){'a', 0x00A0, 'b', 0}, 3); // mixed
 
     TEST_SUITE("String Literals — Wide basic");
 
-    expect_wstring_literal("L\"\"", (wchar_t[]){0}, 1);
-    expect_wstring_literal("L\"a\"", (wchar_t[]){'a', 0}, 2);
-    expect_wstring_literal("L\"hi\"", (wchar_t[]){'h', 'i', 0}, 3);
-    expect_wstring_literal("L\"\\n\"", (wchar_t[]){'\n', 0}, 2);
-    expect_wstring_literal("L\"\\101\"", (wchar_t[]){'A', 0}, 2);
+    expect_wstring_literal("L\"\"", (wchar_t[]){0}, 0);
+    expect_wstring_literal("L\"a\"", (wchar_t[]){'a', 0}, 1);
+    expect_wstring_literal("L\"hi\"", (wchar_t[]){'h', 'i', 0}, 2);
+    expect_wstring_literal("L\"\\n\"", (wchar_t[]){'\n', 0}, 1);
+    expect_wstring_literal("L\"\\101\"", (wchar_t[]){'A', 0}, 1);
 
     TEST_SUITE("String Literals — Invalid");
 
@@ -752,6 +800,104 @@ static void test_string_literals(void) {
     expect_invalid("\"\\uD800\"");   // surrogate
     expect_invalid("\"\\u009F\"");   // below 0x00A0, not an allowed exception
     expect_invalid("\"\\U000000\""); // \U needs exactly 8 digits
+    expect_invalid("\"a\nb\"");       // raw newline
+    EXPECT(strcmp(lex_one("\"open").value.error_message, "unterminated string literal") == 0,
+           "unterminated string literal reported as '%s'",
+           lex_one("\"open").value.error_message);
+
+    TEST_SUITE("String Literals — Decoded in bulk");
+
+    // a wide run longer than a vector zero-extends every byte, an escape inside it is decoded on its own
+    char wide[128] = "L\"";
+    wchar_t widened[128];
+    for (size_t i = 0; i < 60; i++) {
+        wide[2 + i] = (char)('a' + i % 26);
+        widened[i]  = (wchar_t)('a' + i % 26);
+    }
+    wide[20]    = (char)0xC3; // UTF-8 bytes widen to their value, not sign-extended
+    wide[21]    = (char)0xA9;
+    widened[18] = 0xC3;
+    widened[19] = 0xA9;
+    strcpy(wide + 62, "\"");
+    widened[60] = 0;
+    expect_wstring_literal(wide, widened, 60);
+    wide[40]    = '\\';
+    wide[41]    = 'n';
+    widened[38] = '\n';
+    memmove(widened + 39, widened + 40, 21 * sizeof(wchar_t));
+    expect_wstring_literal(wide, widened, 59);
+
+    // a blob of two-digit hex escapes covers every byte value
+    char blob[4 * 256 + 4] = "\"";
+    char bytes[257];
+    for (size_t i = 0; i < 256; i++) {
+        snprintf(blob + 1 + 4 * i, 5, "\\x%02x", (unsigned)i);
+        bytes[i] = (char)i;
+    }
+    strcpy(blob + 1 + 4 * 256, "\"");
+    bytes[256] = '\0';
+    expect_string_literal(blob, bytes, 256);
+
+    // hex escapes of other lengths take the general path, every spelling of a value decodes alike
+    expect_string_literal("\"\\x41\\x042\\x4\\x41z\"", "AB\x04" "Az", 5);
+
+    // an x and two hex digits after an escape are plain characters unless a backslash starts them
+    expect_string_literal("\"\\x41zx41\"", "Azx41", 5);
+    expect_string_literal("\"\\x41x41\"", "Ax41", 4);
+    expect_wstring_literal("L\"\\x41zx41\"", L"Azx41", 5);
+    expect_wstring_literal("L\"\\x41x41\"", L"Ax41", 4);
+
+    static const char* const spellings[][2] = {
+        {"L\"\\xff\"", "L\"\\x0ff\""},
+        {"L\"\\x80\"", "L\"\\200\""},
+        {"L\"\\x7F\"", "L\"\\177\""},
+    };
+    for (size_t i = 0; i < sizeof(spellings) / sizeof(*spellings); i++) {
+        const struct mcc_token fast = lex_one(spellings[i][0]);
+        const struct mcc_token slow = lex_one(spellings[i][1]);
+        EXPECT(fast.type == MCC_TOKEN_TYPE_STRING_LITERAL && slow.type == MCC_TOKEN_TYPE_STRING_LITERAL &&
+                   fast.value.string_literal.value.wstring.data[0] == slow.value.string_literal.value.wstring.data[0],
+               "'%s' and '%s' decode differently",
+               spellings[i][0],
+               spellings[i][1]);
+    }
+
+    TEST_SUITE("String Literals — Lexed in place");
+
+    // runs longer than a vector, the stop falls in a later block
+    char plain[128] = "\"";
+    memset(plain + 1, 'p', 100);
+    strcpy(plain + 101, "\"");
+    expect_string_literal(plain, plain + 1, 100);
+    char escaped[128];
+    memcpy(escaped, plain + 1, 100);
+    escaped[69] = '\t';
+    escaped[70] = 'p';
+    escaped[99] = '\0'; // the escape takes two characters for one
+    plain[70]   = '\\';
+    plain[71]   = 't';
+    expect_string_literal(plain, escaped, 99);
+    plain[70] = 'p';
+    plain[71] = 'p';
+    plain[40] = '\n';
+    expect_invalid(plain);
+
+    // edits that move the source move the literals lexed in place with it
+    struct mcc_context* relex_ctx = mcc_context_create();
+    struct mcc_lexer lexer;
+    const char* src = "a = \"abc\"; b = \"d\\145f\";";
+    mcc_lexer_create(relex_ctx, src, strlen(src), &lexer);
+    struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+    char grown[4096];
+    memset(grown, ' ', sizeof(grown));
+    tokens                           = mcc_lexer_relex(&lexer, tokens, 0, 0, grown, sizeof(grown));
+    const struct mcc_string_view abc = tokens.data[2].value.string_literal.value.string;
+    const struct mcc_string_view def = tokens.data[6].value.string_literal.value.string;
+    EXPECT(abc.data == tokens.data[2].lexeme.data + 1 && abc.size == 3 && memcmp(abc.data, "abc", 3) == 0,
+           "literal lexed in place did not follow the edited source");
+    EXPECT(def.size == 3 && memcmp(def.data, "def", 4) == 0, "decoded literal changed after an edit");
+    mcc_lexer_destroy(&lexer);
+    mcc_context_destroy(relex_ctx);
 }
 
 static void test_punctuators(void) {
@@ -849,6 +995,30 @@ static void test_punctuators(void) {
     expect_punctuator("*/", MCC_PUNCTUATOR_ASTERISK);
     expect_punctuator("<>", MCC_PUNCTUATOR_LEFT_CHEVRON);
 
+    TEST_SUITE("Punctuators — Partial matches");
+
+    // prefixes of "..." and "%:%:" are not punctuators, the longest one that is must be returned
+    static const struct {
+        const char* src;
+        enum mcc_punctuator punctuator;
+        size_t len;
+    } partial[] = {
+        {"..",   MCC_PUNCTUATOR_DOT,                       1},
+        {"..x",  MCC_PUNCTUATOR_DOT,                       1},
+        {"%:%",  MCC_PUNCTUATOR_HASH,                      2},
+        {"%:%>", MCC_PUNCTUATOR_HASH,                      2},
+        {"<<==", MCC_PUNCTUATOR_DOUBLE_LEFT_CHEVRON_EQUAL, 3},
+    };
+    for (size_t i = 0; i < sizeof(partial) / sizeof(*partial); i++) {
+        const struct mcc_token tok = lex_one(partial[i].src);
+        EXPECT(tok.type == MCC_TOKEN_TYPE_PUNCTUATOR && tok.value.punctuator == partial[i].punctuator &&
+                   tok.lexeme.size == partial[i].len,
+               "'%s': expected punctuator %d of length %zu",
+               partial[i].src,
+               partial[i].punctuator,
+               partial[i].len);
+    }
+
     TEST_SUITE("Punctuators — Invalid characters");
 
     expect_invalid("@");
@@ -857,6 +1027,749 @@ static void test_punctuators(void) {
     expect_invalid("\\");
 }
 
+static void test_character_classes(void) {
+    TEST_SUITE("Character classes");
+
+    // the tables must match <ctype.h> in the C locale, which is the locale every program starts in
+    int mismatch = -1;
+    for (int c = 0; c < 256 && mismatch < 0; c++) {
+        const char ch     = (char)c;
+        const bool agrees = is_ident_start(ch) == (isalpha(c) || c == '_') &&
+                            is_ident(ch) == (isalnum(c) || c == '_') && is_alnum(ch) == (isalnum(c) != 0) &&
+                            is_digit(ch) == (isdigit(c) != 0) && is_xdigit(ch) == (isxdigit(c) != 0) &&
+                            is_odigit(ch) == (c >= '0' && c <= '7') && is_space(ch) == (isspace(c) != 0);
+        if (!agrees) {
+            mismatch = c;
+        }
+    }
+    EXPECT(mismatch < 0, "byte 0x%02X is classified differently from the C locale", mismatch);
+
+    // a host application switching locales must not change how bytes outside ASCII lex
+    if (setlocale(LC_ALL, "en_US.ISO-8859-1") || setlocale(LC_ALL, "de_DE.ISO-8859-1") || setlocale(LC_ALL, "")) {
+        struct mcc_token tok = lex_one("\xE9t\xE9");
+        EXPECT(tok.type == MCC_TOKEN_TYPE_INVALID && tok.lexeme.size == 1,
+               "'\\xE9' under locale %s: expected a one byte INVALID token",
+               setlocale(LC_ALL, NULL));
+
+        tok = lex_one("caf\xE9");
+        EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER && tok.lexeme.size == 3,
+               "'caf\\xE9' under locale %s: expected the identifier 'caf'",
+               setlocale(LC_ALL, NULL));
+
+        tok = lex_one("0x1F\xE9");
+        EXPECT(tok.type == MCC_TOKEN_TYPE_CONSTANT && tok.lexeme.size == 4,
+               "'0x1F\\xE9' under locale %s: expected the constant '0x1F'",
+               setlocale(LC_ALL, NULL));
+
+        setlocale(LC_ALL, "C");
+    }
+}
+
+static void test_runs(void) {
+    TEST_SUITE("Whitespace and identifier runs");
+
+    // long enough to cross several 16 and 32 byte blocks
+    const char* long_ident = "a_very_long_identifier_name_that_spans_more_than_one_vector_block_0123456789";
+    struct mcc_token tok   = lex_one(long_ident);
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "long identifier: expected IDENTIFIER, got token type %d", tok.type);
+    EXPECT(tok.lexeme.size == strlen(long_ident),
+           "long identifier: length %zu != expected %zu",
+           tok.lexeme.size,
+           strlen(long_ident));
+
+    tok = lex_one("abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789+");
+    EXPECT(tok.lexeme.size == 63, "identifier before punctuator: length %zu != expected 63", tok.lexeme.size);
+
+    struct mcc_source_location loc;
+
+    tok = lex_one_at("                                        \t\v\f\r\n                                   x", &loc);
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "long whitespace: expected IDENTIFIER, got token type %d", tok.type);
+    EXPECT(tok.offset == 80, "long whitespace: offset %zu != expected 80", tok.offset);
+    EXPECT(loc.line == 1 && loc.column == 35,
+           "long whitespace: position %zu:%zu != expected 1:35",
+           loc.line,
+           loc.column);
+
+    tok = lex_one_at("\n\n\n    \n  y", &loc);
+    EXPECT(loc.line == 4 && loc.column == 2, "newlines: position %zu:%zu != expected 4:2", loc.line, loc.column);
+
+    tok = lex_one_at("z", &loc);
+    EXPECT(loc.line == 0 && loc.column == 0, "first line: position %zu:%zu != expected 0:0", loc.line, loc.column);
+}
+
+static void test_comments_and_splices(void) {
+    TEST_SUITE("Comments and line splices");
+
+    struct mcc_source_location loc;
+    struct mcc_token tok;
+
+    tok = lex_one_at("/* x */ b", &loc);
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER && tok.offset == 8,
+           "block comment: token type %d at %zu, expected IDENTIFIER at 8",
+           tok.type,
+           tok.offset);
+    tok = lex_one("/**/b");
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "empty block comment: expected IDENTIFIER, got %d", tok.type);
+    tok = lex_one("/*/ */x");
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "'/*/' does not close: expected IDENTIFIER, got %d", tok.type);
+    tok = lex_one("/* a **/ /* b */ // c\n  /* d\n */ x");
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER, "comment run: expected IDENTIFIER, got %d", tok.type);
+    tok = lex_one("// only a comment");
+    EXPECT(tok.type == MCC_TOKEN_TYPE_EOF, "line comment at end: expected EOF, got %d", tok.type);
+    expect_invalid("/* never closed *");
+    expect_punctuator("/ * x", MCC_PUNCTUATOR_SLASH);
+    expect_punctuator("/=", MCC_PUNCTUATOR_SLASH_EQUAL);
+
+    // a splice joins the comment with the next line
+    tok = lex_one("// c \\\n continued\nx");
+    EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER && tok.lexeme.size == 1 && tok.lexeme.data[0] == 'x',
+           "spliced line comment: expected identifier x, got type %d",
+           tok.type);
+    expect_keyword("in\\\nt", MCC_KEYWORD_INT);
+    expect_keyword("in\\\r\nt", MCC_KEYWORD_INT);
+    expect_keyword("\\\n\\\nint", MCC_KEYWORD_INT);
+    expect_punctuator("+\\\n=", MCC_PUNCTUATOR_PLUS_EQUAL);
+    expect_invalid("\\ \nx");
+
+    expect_string_literal("\"a\\\nb\"", "ab", 2);
+
+    // the searches compare a byte with the one after it, so pairs straddling 16 and 32 byte blocks must be found
+    for (size_t n = 1; n < 70; n++) {
+        char buf[128];
+        memset(buf, '*', sizeof(buf));
+        buf[0] = '/';
+        memcpy(buf + 2 + n, "/y", 3);
+        tok = lex_one(buf);
+        EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER && tok.offset == 3 + n,
+               "comment closing at %zu: token type %d at %zu",
+               n,
+               tok.type,
+               tok.offset);
+
+        memset(buf, ' ', sizeof(buf));
+        memcpy(buf + n, "x\\\ny", 5);
+        tok = lex_one(buf);
+        EXPECT(tok.type == MCC_TOKEN_TYPE_IDENTIFIER && tok.lexeme.size == 2,
+               "splice at %zu: token type %d of length %zu",
+               n,
+               tok.type,
+               tok.lexeme.size);
+    }
+
+    // locations count the lines of the text as written
+    struct mcc_lexer lexer;
+    const char* src = "a\\\nb c\n d\\\r\n\\\n  e";
+    mcc_lexer_create(ctx, src, strlen(src), &lexer);
+    const struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+    const size_t lines[]                = {0, 1, 2, 4};
+    const size_t columns[]              = {0, 2, 1, 2};
+    EXPECT(tokens.size == 5, "spliced source: %zu tokens != expected 5", tokens.size);
+    for (size_t i = 0; i < 4 && i < tokens.size; i++) {
+        loc = mcc_lexer_location(&lexer, tokens.data[i].offset);
+        EXPECT(loc.line == lines[i] && loc.column == columns[i],
+               "spliced source: token %zu at %zu:%zu != expected %zu:%zu",
+               i,
+               loc.line,
+               loc.column,
+               lines[i],
+               columns[i]);
+    }
+    mcc_lexer_destroy(&lexer);
+}
+
+static void test_tokenize_all(void) {
+    TEST_SUITE("Bulk tokenization");
+
+    const char* src = "int main(void) { return x[1] + 0x2f * \"s\" - 'c'; }";
+
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, src, strlen(src), &lexer);
+    const struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+
+    EXPECT(tokens.size == 20, "token count %zu != expected 20", tokens.size);
+    EXPECT(tokens.data[tokens.size - 1].type == MCC_TOKEN_TYPE_EOF, "last token is not EOF");
+
+    // the bulk array must match the per-call stream token for token
+    lexer.current = lexer.source;
+    for (size_t i = 0; i < tokens.size; i++) {
+        const struct mcc_token tok = mcc_lexer_next_token(&lexer);
+        EXPECT(tok.type == tokens.data[i].type && tok.offset == tokens.data[i].offset &&
+                   tok.lexeme.size == tokens.data[i].lexeme.size,
+               "token %zu differs from mcc_lexer_next_token",
+               i);
+    }
+
+    // an empty source still produces the EOF token
+    mcc_lexer_destroy(&lexer);
+    mcc_lexer_create(ctx, "", 0, &lexer);
+    const struct mcc_token_array empty = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(empty.size == 1 && empty.data[0].type == MCC_TOKEN_TYPE_EOF, "empty source: expected a single EOF token");
+    mcc_lexer_destroy(&lexer);
+}
+
+/// @brief Tokenizes a source and concatenates its adjacent string literals.
+static struct mcc_token_array concatenate(const char* src, struct mcc_lexer* lexer) {
+    mcc_lexer_create(ctx, src, strlen(src), lexer);
+    return mcc_lexer_concatenate_strings(lexer, mcc_lexer_tokenize_all(lexer));
+}
+
+static void test_concatenate_strings(void) {
+    TEST_SUITE("String literal concatenation");
+
+    struct mcc_lexer lexer;
+    const char* src                     = "x = \"ab\" \"c\\n\" /* gap */ \"\" \"d\"; y = \"e\";";
+    const struct mcc_token_array tokens = concatenate(src, &lexer);
+    EXPECT(tokens.size == 9, "token count %zu != expected 9", tokens.size);
+    const struct mcc_token joined       = tokens.data[2];
+    const struct mcc_string_view string = joined.value.string_literal.value.string;
+    EXPECT(joined.type == MCC_TOKEN_TYPE_STRING_LITERAL &&
+               joined.value.string_literal.type == MCC_STRING_LITERAL_TYPE_STRING,
+           "run of narrow literals is not a narrow literal");
+    EXPECT(string.size == 5 && memcmp(string.data, "abc\nd", 6) == 0,
+           "run decodes to '%.*s'",
+           (int)string.size,
+           string.data);
+    EXPECT(joined.offset == 4 && joined.lexeme.size == strlen("\"ab\" \"c\\n\" /* gap */ \"\" \"d\""),
+           "lexeme of the run does not span its literals");
+    EXPECT(tokens.data[3].type == MCC_TOKEN_TYPE_PUNCTUATOR && tokens.data[4].type == MCC_TOKEN_TYPE_IDENTIFIER,
+           "tokens after the run were not moved up");
+    const struct mcc_string_view single = tokens.data[6].value.string_literal.value.string;
+    EXPECT(single.size == 1 && single.data == lexer.source + strlen(src) - 3, "a lone literal was rewritten");
+    EXPECT(tokens.data[8].type == MCC_TOKEN_TYPE_EOF, "last token is not EOF");
+    mcc_lexer_destroy(&lexer);
+
+    // a wide literal makes the run wide, narrow pieces read as if written wide
+    const struct mcc_token_array mixed = concatenate("\"a\\x41\" L\"b\\u00e9\" \"\\377c\"", &lexer);
+    const struct mcc_token expected    = lex_one("L\"a\\101b\\u00e9\\377c\"");
+    const struct mcc_wstring_view wide = mixed.data[0].value.string_literal.value.wstring;
+    const struct mcc_wstring_view want = expected.value.string_literal.value.wstring;
+    EXPECT(mixed.size == 2 && mixed.data[0].value.string_literal.type == MCC_STRING_LITERAL_TYPE_WIDE_STRING,
+           "mixed run is not a single wide literal");
+    EXPECT(wide.size == 6 && wide.size == want.size && wmemcmp(wide.data, want.data, want.size) == 0,
+           "mixed run differs from the same characters written as one wide literal");
+    mcc_lexer_destroy(&lexer);
+
+    // an invalid token ends a run, a run may open and close the source
+    const struct mcc_token_array broken = concatenate("\"a\" \"b\" \"\\q\" \"c\" \"d\"", &lexer);
+    EXPECT(broken.size == 4 && broken.data[1].type == MCC_TOKEN_TYPE_INVALID, "invalid literal joined a run");
+    EXPECT(broken.data[0].value.string_literal.value.string.size == 2 &&
+               memcmp(broken.data[2].value.string_literal.value.string.data, "cd", 3) == 0,
+           "runs around an invalid literal");
+    mcc_lexer_destroy(&lexer);
+
+    // string tables split into thousands of pieces end up in one literal
+    char* table = malloc(5 * 4096 + 1);
+    for (size_t i = 0; i < 4096; i++) {
+        memcpy(table + 5 * i, "\"xy\"\n", 5);
+    }
+    table[5 * 4096]                    = '\0';
+    const struct mcc_token_array large = concatenate(table, &lexer);
+    const struct mcc_string_view whole = large.data[0].value.string_literal.value.string;
+    EXPECT(large.size == 2 && whole.size == 2 * 4096 && whole.data[whole.size] == '\0' &&
+               memcmp(whole.data + 2 * 4095, "xy", 2) == 0,
+           "4096 literals joined into %zu characters",
+           whole.size);
+    mcc_lexer_destroy(&lexer);
+    free(table);
+
+    const struct mcc_token_array none = concatenate("", &lexer);
+    EXPECT(none.size == 1 && none.data[0].type == MCC_TOKEN_TYPE_EOF, "empty source: expected a single EOF token");
+    mcc_lexer_destroy(&lexer);
+}
+
+static bool same_constant(const struct mcc_constant* a, const struct mcc_constant* b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    switch (a->type) {
+    case MCC_CONSTANT_TYPE_CHAR:
+        return a->value.c == b->value.c;
+    case MCC_CONSTANT_TYPE_WIDE_CHAR:
+        return a->value.wc == b->value.wc;
+    case MCC_CONSTANT_TYPE_INT:
+        return a->value.i == b->value.i;
+    case MCC_CONSTANT_TYPE_LONG_INT:
+        return a->value.l == b->value.l;
+    case MCC_CONSTANT_TYPE_LONG_LONG_INT:
+        return a->value.ll == b->value.ll;
+    case MCC_CONSTANT_TYPE_UNSIGNED_INT:
+        return a->value.u == b->value.u;
+    case MCC_CONSTANT_TYPE_UNSIGNED_LONG_INT:
+        return a->value.ul == b->value.ul;
+    case MCC_CONSTANT_TYPE_UNSIGNED_LONG_LONG_INT:
+        return a->value.ull == b->value.ull;
+    case MCC_CONSTANT_TYPE_FLOAT:
+        return a->value.f == b->value.f;
+    case MCC_CONSTANT_TYPE_DOUBLE:
+        return a->value.d == b->value.d;
+    case MCC_CONSTANT_TYPE_LONG_DOUBLE:
+        return a->value.ld == b->value.ld;
+    default:
+        return true;
+    }
+}
+
+static bool same_token(const struct mcc_token* a, const struct mcc_token* b) {
+    if (a->type != b->type || a->offset != b->offset || a->lexeme.size != b->lexeme.size ||
+        memcmp(a->lexeme.data, b->lexeme.data, a->lexeme.size) != 0) {
+        return false;
+    }
+    switch (a->type) {
+    case MCC_TOKEN_TYPE_KEYWORD:
+        return a->value.keyword == b->value.keyword;
+    case MCC_TOKEN_TYPE_IDENTIFIER:
+        return a->value.identifier == b->value.identifier;
+    case MCC_TOKEN_TYPE_CONSTANT:
+        return same_constant(&a->value.constant, &b->value.constant);
+    case MCC_TOKEN_TYPE_PUNCTUATOR:
+        return a->value.punctuator == b->value.punctuator;
+    case MCC_TOKEN_TYPE_INVALID:
+        return strcmp(a->value.error_message, b->value.error_message) == 0;
+    case MCC_TOKEN_TYPE_STRING_LITERAL: {
+        const struct mcc_string_literal* x = &a->value.string_literal;
+        const struct mcc_string_literal* y = &b->value.string_literal;
+        if (x->type != y->type) {
+            return false;
+        }
+        if (x->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING) {
+            return x->value.wstring.size == y->value.wstring.size &&
+                   memcmp(x->value.wstring.data, y->value.wstring.data, x->value.wstring.size * sizeof(wchar_t)) == 0;
+        }
+        return x->value.string.size == y->value.string.size &&
+               memcmp(x->value.string.data, y->value.string.data, x->value.string.size) == 0;
+    }
+    default:
+        return true;
+    }
+}
+
+// mixed C of about the given size, with tokens running across newlines so window and chunk cuts land inside strings
+static char* generate_source(size_t capacity, size_t* length) {
+    static const char* const lines[] = {
+        "int id%u = id%u + 0x%xULL * 3.5e+2f;\n",
+        "static const char* s%u = \"a \\\"quoted\\\" %u\\\\\";\n",
+        "c%u = '\\'' + L'w' - '\\\\';\n",
+        "w%u = L\"wide %u\";\n",
+        "a%u<:0:> <%% x%u %%> %%:%%: y%u;\n",
+        "// comment with a \" quote %u\n",
+        "x%u = a \\\n + b%u;\n",
+        "/* block comment %u,\n * with an \" and a ' */ y%u = 1;\n",
+        "s%u = \"multi-line %u\n string\";\n",
+        "t%u = \"opens a string %u\n",
+        "closes it%u\" + id%u;\n",
+        "for (int i = 0; i < %u; i++) { v[i] >>= 1e%u; }\n",
+        "bad%u = 08%u $ @ `;\n",
+    };
+    const size_t line_count = sizeof(lines) / sizeof(lines[0]);
+
+    char* src     = malloc(capacity + 256 * 1024);
+    size_t size   = 0;
+    unsigned seed = 12345;
+    while (size < capacity) {
+        seed             = seed * 1103515245u + 12345u;
+        const size_t k   = (seed >> 16) % line_count;
+        const unsigned n = (seed >> 8) % 4096;
+        size += (size_t)sprintf(src + size, lines[k], n, n + 1, n + 2);
+
+        // one string longer than a parallel chunk or a stream window
+        if (size > capacity / 2 && size - capacity / 2 < 64) {
+            src[size++] = '"';
+            for (size_t i = 0; i < 200 * 1024; i += 64) {
+                size += (size_t)sprintf(src + size, "%062zu\n", i);
+            }
+            src[size++] = '"';
+            src[size++] = ';';
+        }
+    }
+    src[size] = '\0';
+    *length   = size;
+    return src;
+}
+
+static void test_tokenize_parallel(void) {
+    TEST_SUITE("Parallel tokenization");
+
+    size_t length;
+    char* src = generate_source(3 * 1024 * 1024, &length);
+
+    struct mcc_context* seq_ctx = mcc_context_create();
+    struct mcc_lexer seq;
+    mcc_lexer_create_borrowed(seq_ctx, src, length, &seq);
+    const struct mcc_token_array expected = mcc_lexer_tokenize_all(&seq);
+
+    for (size_t threads = 1; threads <= 8; threads++) {
+        struct mcc_context* par_ctx = mcc_context_create();
+        struct mcc_lexer par;
+        mcc_lexer_create_borrowed(par_ctx, src, length, &par);
+        const struct mcc_token_array tokens = mcc_lexer_tokenize_parallel(&par, threads);
+
+        EXPECT(tokens.size == expected.size,
+               "%zu threads: token count %zu != expected %zu",
+               threads,
+               tokens.size,
+               expected.size);
+
+        size_t mismatch = SIZE_MAX;
+        for (size_t i = 0; i < tokens.size && i < expected.size && mismatch == SIZE_MAX; i++) {
+            if (!same_token(&tokens.data[i], &expected.data[i])) {
+                mismatch = i;
+            }
+        }
+        EXPECT(mismatch == SIZE_MAX, "%zu threads: token %zu differs from mcc_lexer_tokenize_all", threads, mismatch);
+        EXPECT(mcc_context_symbol_count(par_ctx) == mcc_context_symbol_count(seq_ctx),
+               "%zu threads: %zu symbols != expected %zu",
+               threads,
+               mcc_context_symbol_count(par_ctx),
+               mcc_context_symbol_count(seq_ctx));
+        EXPECT(par.current - par.source == seq.current - seq.source, "%zu threads: lexer not left at EOF", threads);
+
+        mcc_lexer_destroy(&par);
+        mcc_context_destroy(par_ctx);
+    }
+
+    mcc_lexer_destroy(&seq);
+    mcc_context_destroy(seq_ctx);
+    free(src);
+}
+
+static void test_tokenize_stream(void) {
+    TEST_SUITE("Streaming input");
+
+    size_t length;
+    char* src = generate_source(3 * 1024 * 1024, &length);
+
+    const char* path = "test_files/stream.c";
+    FILE* file       = fopen(path, "wb");
+    if (!file) {
+        TEST_FAIL("could not create %s", path);
+        free(src);
+        return;
+    }
+    fwrite(src, 1, length, file);
+    fclose(file);
+
+    struct mcc_context* seq_ctx = mcc_context_create();
+    struct mcc_lexer seq;
+    mcc_lexer_create_borrowed(seq_ctx, src, length, &seq);
+    const struct mcc_token_array expected = mcc_lexer_tokenize_all(&seq);
+
+    // the smallest window, an odd one and the default, the long string in the source widens all of them
+    const size_t windows[] = {4096, 5000, 0};
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        file = fopen(path, "rb");
+        if (!file) {
+            TEST_FAIL("could not open %s", path);
+            break;
+        }
+
+        struct mcc_context* stream_ctx = mcc_context_create();
+        struct mcc_lexer stream;
+        mcc_lexer_create_stream(stream_ctx, fileno(file), windows[w], &stream);
+
+        size_t count    = 0;
+        size_t mismatch = SIZE_MAX;
+        for (;;) {
+            const struct mcc_token token = mcc_lexer_next_token(&stream);
+            if (mismatch == SIZE_MAX && (count >= expected.size || !same_token(&token, &expected.data[count]))) {
+                mismatch = count;
+            }
+            // locations are only known inside the window, the last token always is. Sampled tokens land after line
+            // splices the window has scrolled past
+            if (mismatch == SIZE_MAX && (token.type == MCC_TOKEN_TYPE_INVALID || count % 97 == 0)) {
+                const struct mcc_source_location a = mcc_lexer_location(&stream, token.offset);
+                const struct mcc_source_location b = mcc_lexer_location(&seq, token.offset);
+                if (a.line != b.line || a.column != b.column) {
+                    mismatch = count;
+                }
+            }
+            count++;
+            if (token.type == MCC_TOKEN_TYPE_EOF) {
+                break;
+            }
+        }
+
+        EXPECT(count == expected.size,
+               "window %zu: token count %zu != expected %zu",
+               windows[w],
+               count,
+               expected.size);
+        EXPECT(mismatch == SIZE_MAX, "window %zu: token %zu differs from mcc_lexer_tokenize_all", windows[w], mismatch);
+        EXPECT(mcc_context_symbol_count(stream_ctx) == mcc_context_symbol_count(seq_ctx),
+               "window %zu: %zu symbols != expected %zu",
+               windows[w],
+               mcc_context_symbol_count(stream_ctx),
+               mcc_context_symbol_count(seq_ctx));
+
+        mcc_lexer_destroy(&stream);
+        mcc_context_destroy(stream_ctx);
+        fclose(file);
+    }
+
+    mcc_lexer_destroy(&seq);
+    mcc_context_destroy(seq_ctx);
+
+    // long blank runs and line comments cut by the window are dropped as they are skipped, the window never grows
+    const size_t blank_lines = 256;
+    char* blank              = malloc(blank_lines * 10024 + 1);
+    size_t blank_length      = 0;
+    for (size_t i = 0; i < blank_lines; i++) {
+        memset(blank + blank_length, i % 2 ? ' ' : '\t', 10000);
+        blank_length += 10000;
+        blank_length += (size_t)sprintf(blank + blank_length, "// %04zu\nid%04zu\n", i, i);
+    }
+    file = fopen(path, "wb");
+    if (file) {
+        fwrite(blank, 1, blank_length, file);
+        fclose(file);
+        file = fopen(path, "rb");
+    }
+    if (!file) {
+        TEST_FAIL("could not write %s", path);
+    } else {
+        struct mcc_context* stream_ctx = mcc_context_create();
+        struct mcc_lexer stream;
+        mcc_lexer_create_stream(stream_ctx, fileno(file), 4096, &stream);
+        size_t count  = 0;
+        size_t widest = 0;
+        bool same     = true;
+        for (struct mcc_token token; (token = mcc_lexer_next_token(&stream)).type != MCC_TOKEN_TYPE_EOF; count++) {
+            char name[8];
+            snprintf(name, sizeof(name), "id%04zu", count);
+            same = same && token.type == MCC_TOKEN_TYPE_IDENTIFIER && token.lexeme.size == 6 &&
+                   memcmp(token.lexeme.data, name, 6) == 0;
+            if ((size_t)(stream.end - stream.source) > widest) {
+                widest = (size_t)(stream.end - stream.source);
+            }
+        }
+        EXPECT(count == blank_lines && same, "blank runs: %zu identifiers, expected %zu", count, blank_lines);
+        EXPECT(widest <= 4096, "blank runs widened the window to %zu bytes", widest);
+        mcc_lexer_destroy(&stream);
+        mcc_context_destroy(stream_ctx);
+        fclose(file);
+    }
+    free(blank);
+
+    remove(path);
+    free(src);
+}
+
+// identifiers are compared by name, symbols of a relexed buffer are numbered in edit order
+static bool same_relexed_token(const struct mcc_token* a,
+                               const struct mcc_context* a_ctx,
+                               const struct mcc_token* b,
+                               const struct mcc_context* b_ctx) {
+    if (a->type == MCC_TOKEN_TYPE_IDENTIFIER && b->type == MCC_TOKEN_TYPE_IDENTIFIER) {
+        const struct mcc_string_view x = mcc_context_symbol_name(a_ctx, a->value.identifier);
+        const struct mcc_string_view y = mcc_context_symbol_name(b_ctx, b->value.identifier);
+        if (x.size != y.size || memcmp(x.data, y.data, x.size) != 0) {
+            return false;
+        }
+        struct mcc_token renamed  = *a;
+        renamed.value.identifier = b->value.identifier;
+        return same_token(&renamed, b);
+    }
+    return same_token(a, b);
+}
+
+static bool same_position(const struct mcc_token* a, const struct mcc_token* b) {
+    return a->type == b->type && a->offset == b->offset && a->lexeme.size == b->lexeme.size;
+}
+
+static void test_lookahead(void) {
+    TEST_SUITE("Lookahead and checkpoints");
+
+    size_t length;
+    char* src = generate_source(64 * 1024, &length);
+
+    struct mcc_context* peek_ctx = mcc_context_create();
+    struct mcc_lexer reference;
+    mcc_lexer_create_borrowed(peek_ctx, src, length, &reference);
+    const struct mcc_token_array expected = mcc_lexer_tokenize_all(&reference);
+
+    // looking ahead any distance returns the tokens the lexer hands out later, and the EOF token past the end
+    struct mcc_lexer lexer;
+    mcc_lexer_create_borrowed(peek_ctx, src, length, &lexer);
+    const size_t distances[] = {0, 1, 5, 16, 17, 300};
+    size_t mismatches        = 0;
+    for (size_t i = 0; i < sizeof(distances) / sizeof(*distances); i++) {
+        const struct mcc_token ahead = mcc_lexer_peek(&lexer, distances[i]);
+        mismatches += !same_position(&ahead, &expected.data[distances[i]]);
+    }
+    const struct mcc_token past = mcc_lexer_peek(&lexer, expected.size + 10);
+    EXPECT(mismatches == 0, "%zu peeked tokens differ from the token array", mismatches);
+    EXPECT(past.type == MCC_TOKEN_TYPE_EOF, "looking past the end returned token type %d", past.type);
+
+    // nested checkpoints, one released and one rewound to, the ring grows while the outer one holds tokens back
+    const size_t outer = mcc_lexer_mark(&lexer);
+    for (size_t i = 0; i < 40; i++) {
+        const struct mcc_token token = mcc_lexer_next_token(&lexer);
+        mismatches += !same_position(&token, &expected.data[i]);
+    }
+    const size_t inner = mcc_lexer_mark(&lexer);
+    for (size_t i = 40; i < 1000; i++) {
+        (void)mcc_lexer_next_token(&lexer);
+    }
+    mcc_lexer_release(&lexer, inner);
+    mcc_lexer_rewind(&lexer, outer);
+    for (size_t i = 0; i < expected.size; i++) {
+        const struct mcc_token token = mcc_lexer_next_token(&lexer);
+        mismatches += !same_position(&token, &expected.data[i]);
+    }
+    EXPECT(mismatches == 0, "%zu tokens differ after rewinding", mismatches);
+    EXPECT(mcc_lexer_next_token(&lexer).type == MCC_TOKEN_TYPE_EOF &&
+               mcc_lexer_peek(&lexer, 0).type == MCC_TOKEN_TYPE_EOF,
+           "lexer stepped past the EOF token");
+    mcc_lexer_destroy(&lexer);
+
+    // rewinding hands out the tokens scanned the first time, decoded values included
+    const char* cast = "(T)\"a\\n\" + (x)";
+    mcc_lexer_create(peek_ctx, cast, strlen(cast), &lexer);
+    const size_t start            = mcc_lexer_mark(&lexer);
+    const struct mcc_token peeked = mcc_lexer_peek(&lexer, 3);
+    (void)mcc_lexer_next_token(&lexer);
+    (void)mcc_lexer_next_token(&lexer);
+    (void)mcc_lexer_mark(&lexer);
+    (void)mcc_lexer_next_token(&lexer);
+    const struct mcc_token handed = mcc_lexer_next_token(&lexer);
+    mcc_lexer_rewind(&lexer, start); // drops the checkpoint set after it too
+    const struct mcc_token again = mcc_lexer_next_token(&lexer);
+    EXPECT(peeked.type == MCC_TOKEN_TYPE_STRING_LITERAL &&
+               peeked.value.string_literal.value.string.data == handed.value.string_literal.value.string.data,
+           "string literal decoded again after looking ahead");
+    EXPECT(again.type == MCC_TOKEN_TYPE_PUNCTUATOR && again.offset == 0, "rewound to the token at %zu", again.offset);
+
+    // tokens already looked at start the array of the remaining input
+    (void)mcc_lexer_peek(&lexer, 4);
+    const struct mcc_token_array rest = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(rest.size == 8 && rest.data[0].type == MCC_TOKEN_TYPE_IDENTIFIER && rest.data[7].type == MCC_TOKEN_TYPE_EOF,
+           "remaining input: %zu tokens != expected 8",
+           rest.size);
+    mcc_lexer_destroy(&lexer);
+
+    // checkpoints set at the same token are distinct, giving back the older one drops both
+    const char* twice = "a b c";
+    mcc_lexer_create(peek_ctx, twice, strlen(twice), &lexer);
+    size_t first  = mcc_lexer_mark(&lexer);
+    size_t second = mcc_lexer_mark(&lexer);
+    (void)mcc_lexer_next_token(&lexer);
+    mcc_lexer_release(&lexer, first);
+    const struct mcc_token_array released = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(first != second && released.size == 3 && released.data[0].offset == 2,
+           "releasing the older of two checkpoints left %zu tokens",
+           released.size);
+    mcc_lexer_destroy(&lexer);
+    mcc_lexer_create(peek_ctx, twice, strlen(twice), &lexer);
+    first  = mcc_lexer_mark(&lexer);
+    second = mcc_lexer_mark(&lexer);
+    (void)mcc_lexer_next_token(&lexer);
+    mcc_lexer_rewind(&lexer, first);
+    const struct mcc_token_array rewound = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(rewound.size == 4 && rewound.data[0].offset == 0,
+           "rewinding to the older of two checkpoints left %zu tokens",
+           rewound.size);
+    mcc_lexer_destroy(&lexer);
+
+    mcc_lexer_destroy(&reference);
+    mcc_context_destroy(peek_ctx);
+    free(src);
+}
+
+static void test_relex(void) {
+    TEST_SUITE("Incremental relexing");
+
+    // fragments that merge with or split their neighbours, open and close strings, comments and digraphs
+    static const char* const fragments[] = {
+        "", "x", "\"", "'", "/", "//", "*", ".", "..", "%:", "%", ":", "\n", " ", "\\", "0x1", "1e+", "L\"", "<:", "+=",
+    };
+    const size_t fragment_count = sizeof(fragments) / sizeof(fragments[0]);
+
+    size_t length;
+    char* src = generate_source(16 * 1024, &length);
+
+    struct mcc_context* edit_ctx = mcc_context_create();
+    struct mcc_lexer lexer;
+    mcc_lexer_create(edit_ctx, src, length, &lexer);
+    struct mcc_token_array tokens = mcc_lexer_tokenize_all(&lexer);
+
+    // edits address the spliced text, so the reference copy is the spliced one
+    length = (size_t)(lexer.end - lexer.source);
+    memcpy(src, lexer.source, length + 1);
+
+    size_t mismatches = 0;
+    unsigned seed     = 777;
+    for (int edit = 0; edit < 300; edit++) {
+        seed                 = seed * 1103515245u + 12345u;
+        const size_t offset  = (seed >> 4) % (length + 1);
+        size_t removed       = (seed >> 20) % 6;
+        const char* fragment = fragments[(seed >> 12) % fragment_count];
+        const size_t added   = strlen(fragment);
+        if (removed > length - offset) {
+            removed = length - offset;
+        }
+
+        // the reference copy of the text gets the same edit and is lexed from scratch
+        char* edited = malloc(length - removed + added + 1);
+        memcpy(edited, src, offset);
+        memcpy(edited + offset, fragment, added);
+        memcpy(edited + offset + added, src + offset + removed, length - offset - removed + 1);
+        free(src);
+        src    = edited;
+        length = length - removed + added;
+
+        tokens = mcc_lexer_relex(&lexer, tokens, offset, removed, fragment, added);
+
+        struct mcc_context* fresh_ctx = mcc_context_create();
+        struct mcc_lexer fresh;
+        mcc_lexer_create(fresh_ctx, src, length, &fresh);
+        const struct mcc_token_array expected = mcc_lexer_tokenize_all(&fresh);
+
+        // the edit may have formed a splice, the fresh lexer removed it too
+        length = (size_t)(fresh.end - fresh.source);
+        memcpy(src, fresh.source, length + 1);
+
+        bool same = tokens.size == expected.size && (size_t)(lexer.end - lexer.source) == length &&
+                    memcmp(lexer.source, src, length) == 0;
+        for (size_t i = 0; same && i < tokens.size; i++) {
+            same = same_relexed_token(&tokens.data[i], edit_ctx, &expected.data[i], fresh_ctx);
+        }
+        if (!same && mismatches++ == 0) {
+            TEST_FAIL("edit %d (%zu, -%zu, \"%s\") differs from lexing afresh", edit, offset, removed, fragment);
+        }
+
+        mcc_lexer_destroy(&fresh);
+        mcc_context_destroy(fresh_ctx);
+    }
+    EXPECT(mismatches == 0, "%zu of 300 edits differ from lexing afresh", mismatches);
+
+    // tokens after the edit keep their lexemes and shift, locations follow the edited text
+    const struct mcc_source_location before = mcc_lexer_location(&lexer, tokens.data[tokens.size - 1].offset);
+    tokens = mcc_lexer_relex(&lexer, tokens, 0, 0, "\n\n", 2);
+    const struct mcc_source_location after = mcc_lexer_location(&lexer, tokens.data[tokens.size - 1].offset);
+    EXPECT(after.line == before.line + 2 && after.column == before.column,
+           "EOF moved from %zu:%zu to %zu:%zu, expected two lines down",
+           before.line,
+           before.column,
+           after.line,
+           after.column);
+
+    // tokens peeked and checkpoints set before an edit are dropped, looking ahead again lexes the edited source
+    const struct mcc_token stale = mcc_lexer_peek(&lexer, 0);
+    (void)mcc_lexer_mark(&lexer);
+    tokens                        = mcc_lexer_relex(&lexer, tokens, 0, 0, "y ", 2);
+    const struct mcc_token peeked = mcc_lexer_peek(&lexer, 0);
+    EXPECT(stale.type == MCC_TOKEN_TYPE_EOF && peeked.type == MCC_TOKEN_TYPE_EOF &&
+               peeked.offset == stale.offset + 2 && peeked.offset == tokens.data[tokens.size - 1].offset,
+           "peeked the EOF token at %zu after an edit, expected %zu",
+           peeked.offset,
+           stale.offset + 2);
+    const struct mcc_token_array rest = mcc_lexer_tokenize_all(&lexer);
+    EXPECT(rest.size == 1 && rest.data[0].offset == peeked.offset, "lexer not left at EOF after an edit");
+
+    mcc_lexer_destroy(&lexer);
+    mcc_context_destroy(edit_ctx);
+    free(src);
+}
+
 // =============================================================================
 // Entry Point
 // =============================================================================
@@ -871,6 +1784,15 @@ int main(void) {
     test_character_constants();
     test_string_literals();
     test_punctuators();
+    test_character_classes();
+    test_runs();
+    test_comments_and_splices();
+    test_tokenize_all();
+    test_concatenate_strings();
+    test_tokenize_parallel();
+    test_tokenize_stream();
+    test_relex();
+    test_lookahead();
 
     mcc_context_destroy(ctx);
 
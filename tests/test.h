@@ -0,0 +1,46 @@
+/// @file tests/test.h
+/// @brief Minimal assertion and reporting macros shared by the MCC unit tests.
+
+#pragma once
+
+#include <stdio.h>
+
+static int g_tests_run    = 0;
+static int g_tests_passed = 0;
+static int g_tests_failed = 0;
+
+#define TEST_PASS()       \
+    do {                  \
+        g_tests_run++;    \
+        g_tests_passed++; \
+    } while (0)
+
+#define TEST_FAIL(fmt, ...)                                                                    \
+    do {                                                                                       \
+        g_tests_run++;                                                                         \
+        g_tests_failed++;                                                                      \
+        (void)fprintf(stderr, "  FAIL [%s:%d]: " fmt "\n", __FILE__, __LINE__, ##__VA_ARGS__); \
+    } while (0)
+
+#define EXPECT(cond, fmt, ...)             \
+    do {                                   \
+        if ((cond)) {                      \
+            TEST_PASS();                   \
+        } else {                           \
+            TEST_FAIL(fmt, ##__VA_ARGS__); \
+        }                                  \
+    } while (0)
+
+#define TEST_SUITE(name)                \
+    do {                                \
+        printf("\n=== " name " ===\n"); \
+    } while (0)
+
+static void print_results(void) {
+    printf("\n----------------------------------------\n");
+    printf("Results: %d/%d passed", g_tests_passed, g_tests_run);
+    if (g_tests_failed > 0) {
+        printf(", %d FAILED", g_tests_failed);
+    }
+    printf("\n");
+}
@@ -0,0 +1,140 @@
+/// @file tests/token_buffer_test.c
+/// @brief Structure-of-arrays token buffer tests for the MCC C99 compiler.
+
+#include <lexer.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <token_buffer.h>
+#include "context.h"
+#include "test.h"
+
+static struct mcc_context* ctx;
+
+static const char* const source = "int main(void) {\n"
+                                  "    const char* s = \"hi\\n\";\n"
+                                  "    double d = 1.5e3 + 'x' + 0x10u;\n"
+                                  "    return s[0] >>= 2 @ L\"w\";\n"
+                                  "}\n";
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool tokens_equal(const struct mcc_token* a, const struct mcc_token* b) {
+    if (a->type != b->type || a->offset != b->offset || a->lexeme.data != b->lexeme.data ||
+        a->lexeme.size != b->lexeme.size) {
+        return false;
+    }
+    switch (a->type) {
+        case MCC_TOKEN_TYPE_IDENTIFIER:
+            return a->value.identifier == b->value.identifier;
+        case MCC_TOKEN_TYPE_KEYWORD:
+            return a->value.keyword == b->value.keyword;
+        case MCC_TOKEN_TYPE_PUNCTUATOR:
+            return a->value.punctuator == b->value.punctuator;
+        case MCC_TOKEN_TYPE_CONSTANT:
+            return a->value.constant.type == b->value.constant.type &&
+                   memcmp(&a->value.constant.value, &b->value.constant.value, sizeof(long long)) == 0;
+        case MCC_TOKEN_TYPE_STRING_LITERAL: {
+            // the reference stream decoded its own copy of each literal so compare contents
+            const struct mcc_string_literal* x = &a->value.string_literal;
+            const struct mcc_string_literal* y = &b->value.string_literal;
+            const size_t char_size             = x->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING ? sizeof(wchar_t) : 1;
+            return x->type == y->type && x->value.string.size == y->value.string.size &&
+                   memcmp(x->value.string.data, y->value.string.data, x->value.string.size * char_size) == 0;
+        }
+        case MCC_TOKEN_TYPE_INVALID:
+            return a->value.error_message == b->value.error_message;
+        default:
+            return true;
+    }
+}
+
+// =============================================================================
+// Tests
+// =============================================================================
+
+static void test_round_trip(void) {
+    TEST_SUITE("Token Buffer — Round trip");
+
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, source, strlen(source), &lexer);
+
+    // reference stream, the lexer is deterministic so a second pass over the same source matches the buffer
+    struct mcc_token expected[64];
+    size_t expected_size = 0;
+    do {
+        expected[expected_size] = mcc_lexer_next_token(&lexer);
+    } while (expected[expected_size++].type != MCC_TOKEN_TYPE_EOF && expected_size < 64);
+
+    struct mcc_token_buffer buffer;
+    mcc_token_buffer_create(lexer.source, &buffer);
+    lexer.current = lexer.source;
+    mcc_token_buffer_lex(&buffer, &lexer);
+
+    EXPECT(buffer.size == expected_size, "token count %zu != expected %zu", buffer.size, expected_size);
+    EXPECT(buffer.constants_size == 5, "constant side table size %zu != expected 5", buffer.constants_size);
+    EXPECT(buffer.string_literals_size == 2,
+           "string literal side table size %zu != expected 2",
+           buffer.string_literals_size);
+    EXPECT(buffer.error_messages_size == 1, "error side table size %zu != expected 1", buffer.error_messages_size);
+
+    for (size_t i = 0; i < buffer.size && i < expected_size; i++) {
+        EXPECT(mcc_token_buffer_type(&buffer, i) == expected[i].type, "token %zu: type mismatch", i);
+        const struct mcc_token tok = mcc_token_buffer_get(&buffer, i);
+        EXPECT(tokens_equal(&tok, &expected[i]),
+               "token %zu: '%.*s' mismatch",
+               i,
+               (int)tok.lexeme.size,
+               tok.lexeme.data);
+    }
+
+    mcc_token_buffer_destroy(&buffer);
+    mcc_lexer_destroy(&lexer);
+}
+
+static void test_growth(void) {
+    TEST_SUITE("Token Buffer — Growth");
+
+    // enough tokens to force several reallocations of every array
+    char src[4096];
+    size_t len = 0;
+    for (int i = 0; i < 500; i++) {
+        len += (size_t)sprintf(src + len, "%d;", i);
+    }
+
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, src, len, &lexer);
+    struct mcc_token_buffer buffer;
+    mcc_token_buffer_create(lexer.source, &buffer);
+    mcc_token_buffer_lex(&buffer, &lexer);
+
+    EXPECT(buffer.size == 1001, "token count %zu != expected 1001", buffer.size);
+    EXPECT(buffer.constants_size == 500, "constant count %zu != expected 500", buffer.constants_size);
+
+    const struct mcc_token last_constant = mcc_token_buffer_get(&buffer, 998);
+    EXPECT(last_constant.type == MCC_TOKEN_TYPE_CONSTANT && last_constant.value.constant.value.i == 499,
+           "token 998 is not the constant 499");
+    EXPECT(mcc_token_buffer_type(&buffer, 1000) == MCC_TOKEN_TYPE_EOF, "last token is not EOF");
+
+    mcc_token_buffer_destroy(&buffer);
+    mcc_lexer_destroy(&lexer);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    ctx = mcc_context_create();
+
+    test_round_trip();
+    test_growth();
+
+    mcc_context_destroy(ctx);
+
+    print_results();
+    return g_tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
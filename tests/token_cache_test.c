@@ -0,0 +1,226 @@
+/// @file tests/token_cache_test.c
+/// @brief On-disk token cache tests for the MCC C99 compiler.
+
+#include <lexer.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <token_cache.h>
+#include <wchar.h>
+#include "build_id.h"
+#include "context.h"
+#include "test.h"
+
+#define CACHE_DIR "test_files"
+
+static const char* source = "#ifndef SAMPLE_H\n"
+                            "#define SAMPLE_H\n"
+                            "static const char* name = \"sample\\n\";\n"
+                            "static const wchar_t* wide = L\"wide\";\n"
+                            "int count = 42, mask = 0xFFu; double ratio = 1.5e3; char c = 'x';\n"
+                            "int f(int count) { return count ? mask : count; } /* comment */\n"
+                            "int bad = 0x; @\n"
+                            "#endif\n";
+
+// =============================================================================
+// Helpers
+// =============================================================================
+
+static bool same_literal(const struct mcc_string_literal* a, const struct mcc_string_literal* b) {
+    if (a->type != b->type) {
+        return false;
+    }
+    if (a->type == MCC_STRING_LITERAL_TYPE_WIDE_STRING) {
+        return a->value.wstring.size == b->value.wstring.size &&
+               wmemcmp(a->value.wstring.data, b->value.wstring.data, a->value.wstring.size) == 0;
+    }
+    return a->value.string.size == b->value.string.size &&
+           memcmp(a->value.string.data, b->value.string.data, a->value.string.size) == 0;
+}
+
+static bool same_token(const struct mcc_token* a, const struct mcc_token* b) {
+    if (a->type != b->type || a->offset != b->offset || a->lexeme.size != b->lexeme.size) {
+        return false;
+    }
+    switch (a->type) {
+        case MCC_TOKEN_TYPE_IDENTIFIER:
+            return a->value.identifier == b->value.identifier;
+        case MCC_TOKEN_TYPE_KEYWORD:
+            return a->value.keyword == b->value.keyword;
+        case MCC_TOKEN_TYPE_PUNCTUATOR:
+            return a->value.punctuator == b->value.punctuator;
+        case MCC_TOKEN_TYPE_CONSTANT:
+            return a->value.constant.type == b->value.constant.type &&
+                   memcmp(&a->value.constant.value, &b->value.constant.value, sizeof(long long)) == 0;
+        case MCC_TOKEN_TYPE_STRING_LITERAL:
+            return same_literal(&a->value.string_literal, &b->value.string_literal);
+        case MCC_TOKEN_TYPE_INVALID:
+            return strcmp(a->value.error_message, b->value.error_message) == 0;
+        case MCC_TOKEN_TYPE_EOF:
+        default:
+            return true;
+    }
+}
+
+/// @brief Lexes text through the cache in a fresh context and checks the tokens against a plain lex.
+static void expect_cached(const char* label, const char* text, bool hit) {
+    struct mcc_context* ctx = mcc_context_create();
+    struct mcc_lexer reference;
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, text, strlen(text), &reference);
+    mcc_lexer_create(ctx, text, strlen(text), &lexer);
+
+    const struct mcc_token_array expected = mcc_lexer_tokenize_all(&reference);
+    bool cached                           = !hit;
+    const struct mcc_token_array tokens   = mcc_token_cache_tokenize(&lexer, CACHE_DIR, &cached);
+
+    EXPECT(cached == hit, "%s: hit %d != expected %d", label, cached, hit);
+    EXPECT(tokens.size == expected.size, "%s: %zu tokens != expected %zu", label, tokens.size, expected.size);
+    for (size_t i = 0; i < tokens.size && i < expected.size; i++) {
+        if (!same_token(&tokens.data[i], &expected.data[i])) {
+            TEST_FAIL("%s: token %zu '%.*s' differs from a plain lex",
+                      label,
+                      i,
+                      (int)expected.data[i].lexeme.size,
+                      expected.data[i].lexeme.data);
+            break;
+        }
+    }
+    EXPECT(lexer.current == lexer.end, "%s: lexer not at the end of the source", label);
+
+    mcc_lexer_destroy(&lexer);
+    mcc_lexer_destroy(&reference);
+    mcc_context_destroy(ctx);
+}
+
+static bool cache_file(char* path, size_t size, const char* text) {
+    struct mcc_context* ctx = mcc_context_create();
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, text, strlen(text), &lexer);
+    const bool found = mcc_token_cache_path(&lexer, CACHE_DIR, path, size);
+    mcc_lexer_destroy(&lexer);
+    mcc_context_destroy(ctx);
+    return found;
+}
+
+// =============================================================================
+// Tests
+// =============================================================================
+
+static void test_hit_and_miss(void) {
+    TEST_SUITE("Token Cache — Hits and misses");
+
+    char path[512];
+    cache_file(path, sizeof(path), source);
+    remove(path); // left over from an earlier run
+
+    expect_cached("first lex", source, false);
+    FILE* file = fopen(path, "rb");
+    EXPECT(file != NULL, "no cache file written at %s", path);
+    if (file) {
+        fclose(file);
+    }
+    expect_cached("second lex", source, true);
+    expect_cached("third lex", source, true);
+
+    // same length, different content
+    char* changed = malloc(strlen(source) + 1);
+    strcpy(changed, source);
+    *strstr(changed, "42") = '7';
+    char changed_path[512];
+    cache_file(changed_path, sizeof(changed_path), changed);
+    EXPECT(strcmp(path, changed_path) != 0, "changed source maps to the same file %s", path);
+    remove(changed_path);
+    expect_cached("changed source", changed, false);
+    expect_cached("changed source again", changed, true);
+    remove(changed_path);
+
+    // a file of another source under this name is never used
+    rename(path, changed_path);
+    expect_cached("wrong source", changed, false);
+    remove(changed_path);
+    free(changed);
+
+    cache_file(path, sizeof(path), "");
+    remove(path);
+    expect_cached("empty source", "", false);
+    expect_cached("empty source again", "", true);
+    remove(path);
+}
+
+static void test_damaged_files(void) {
+    TEST_SUITE("Token Cache — Damaged files");
+
+    char path[512];
+    cache_file(path, sizeof(path), source);
+    remove(path);
+    expect_cached("fresh", source, false);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        TEST_FAIL("no cache file written at %s", path);
+        return;
+    }
+    fseek(file, 0, SEEK_END);
+    const long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* data = malloc((size_t)size);
+    EXPECT(fread(data, 1, (size_t)size, file) == (size_t)size, "could not read %s", path);
+    fclose(file);
+    EXPECT(memcmp(data + 8, MCC_VERSION, sizeof(MCC_VERSION)) == 0, "cache file does not carry MCC_VERSION");
+    EXPECT(memcmp(data + 24, MCC_BUILD_ID, sizeof(MCC_BUILD_ID)) == 0, "cache file does not carry MCC_BUILD_ID");
+
+    // a file written by a build of other library sources is never used, even under the same MCC_VERSION
+    file     = fopen(path, "wb");
+    data[24] = data[24] == '0' ? '1' : '0';
+    fwrite(data, 1, (size_t)size, file);
+    fclose(file);
+    data[24] = MCC_BUILD_ID[0];
+    expect_cached("other build", source, false);
+    expect_cached("other build rewritten", source, true);
+
+    // truncated, then a byte flipped in the header, the source copy, the token arrays and the blob: each is a miss that
+    // rewrites the file
+    const long damage[] = {size / 2, 8, 40, 140, size / 2, size - 1};
+    for (size_t i = 0; i < sizeof(damage) / sizeof(*damage); i++) {
+        file = fopen(path, "wb");
+        if (i == 0) {
+            fwrite(data, 1, (size_t)damage[i], file);
+        } else {
+            data[damage[i]] ^= 0x5A;
+            fwrite(data, 1, (size_t)size, file);
+            data[damage[i]] ^= 0x5A;
+        }
+        fclose(file);
+
+        char label[64];
+        snprintf(label, sizeof(label), "%s at %ld", i == 0 ? "truncated" : "flipped", damage[i]);
+        expect_cached(label, source, false);
+        expect_cached(label, source, true);
+    }
+    free(data);
+    remove(path);
+
+    // a directory that does not exist only costs the cache
+    struct mcc_context* ctx = mcc_context_create();
+    struct mcc_lexer lexer;
+    mcc_lexer_create(ctx, source, strlen(source), &lexer);
+    bool hit                            = true;
+    const struct mcc_token_array tokens = mcc_token_cache_tokenize(&lexer, CACHE_DIR "/missing", &hit);
+    EXPECT(!hit && tokens.size > 1, "lex into a missing directory: hit %d, %zu tokens", hit, tokens.size);
+    mcc_lexer_destroy(&lexer);
+    mcc_context_destroy(ctx);
+}
+
+// =============================================================================
+// Entry Point
+// =============================================================================
+
+int main(void) {
+    test_hit_and_miss();
+    test_damaged_files();
+
+    print_results();
+    return g_tests_failed > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}